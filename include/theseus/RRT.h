@@ -2,33 +2,72 @@
 #define RRT_H
 
 #include <stack>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <math.h>
-#include <ros/ros.h>
-#include <ros/console.h>
-#include <visualization_msgs/Marker.h>
 
+#include <theseus/log.h>
 #include <theseus/map_s.h>
 #include <theseus/fillet_s.h>
 #include <theseus/rand_gen.h>
-#include <theseus/param_reader.h>
+#include <theseus/planner_config.h>
 #include <theseus/collision_detection.h>
-#include <theseus/rrt_plotter.h>
+#include <theseus/viz_sink.h>
 #include <theseus/node_s.h>
+#include <theseus/leg_cache.h>
+#include <theseus/roadmap.h>
+#include <theseus/visibility_graph.h>
+#include <theseus/phase_timer.h>
+#include <theseus/event_ring.h>
 
 namespace theseus
 {
+// Shared with whoever runs solveStatic on another thread
+struct rrt_progress_s
+{
+  std::atomic<bool> cancel;               // set to stop solveStatic, it returns false at the next check
+  std::atomic<unsigned int> leg;          // leg that is being planned
+  std::atomic<unsigned int> num_legs;
+  std::atomic<unsigned long> nodes;       // nodes added to the tree of that leg
+  std::atomic<unsigned long> total_nodes; // nodes added to all of the trees of the solve
+  std::atomic<unsigned long> smooth_us;   // time spent smoothing during the solve (us)
+  std::mutex mutex;                       // only for waking a solve that waits for a leg planned ahead
+  std::condition_variable wake;           // notified by stop() and when a leg planned ahead is finished
+  void stop()                             // sets cancel and wakes the solve if it is waiting
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      cancel = true;
+    }
+    wake.notify_all();
+  }
+};
 // Class Definition
 class RRT
 {
 public:
-  RRT(map_s map_in, unsigned int seed);
+  RRT(map_s map_in, unsigned int seed, planner_config_s config);
+  explicit RRT(planner_config_s config);
 	RRT();
   ~RRT();                                                                 // Deconstructor - deletes the tree
 	bool solveStatic(NED_s pos, float chi0, bool direct_hit, bool landing, bool drop_bomb, bool loiter_mission); // Solves the static path
-  void newMap(map_s map_in);                                              // creates a new map
-  void newSeed(unsigned int seed);
+  void newMap(map_s map_in, MapArtifact* artifact = NULL);                // creates a new map, artifact can be an open compiled map of it
+  void newSeed(unsigned int seed, bool own_stream = false); // own_stream keeps the sequence apart from other planners on other threads
+  void setTuning(planner_tuning_s tuning);                                // plan with the settings tuned for the map from now on
+  void setRoadmap(Roadmap* roadmap);                                      // legs are looked up in the roadmap before growing a tree
+  void setProgress(rrt_progress_s* progress);                             // progress is reported there and the cancel flag is checked (can be NULL)
+  void setLegCallback(std::function<void(unsigned int)> callback);       // called with i once leg i is in all_wps_ (can be empty)
+  void setVizSink(VizSink* viz);                                          // what animating_ draws on, owned by the caller (NULL draws nothing)
+  void setTrace(PhaseTrace* trace);                                       // the phases of each solve are timed into it, owned by the caller (NULL times nothing)
+  std::shared_ptr<EventRing> events_;         // what the planner did lately, dumped after a failed solve (NULL when input_file_.event_ring_size is 0)
   bool checkPoint(NED_s point, float clearance);
   std::vector<NED_s> all_wps_;                // final path waypoints
   std::vector<int> all_priorities_;
@@ -40,31 +79,49 @@ public:
   NED_s ending_point_;
   float ending_chi_;
   CollisionDetection col_det_;    // collision detecter
+  VisibilityGraph vis_graph_;     // 2D shortest paths around the cylinders, rebuilt with every new map
   bool animating_;
 private:
-  ros::NodeHandle nh_;         // public node handle for publishing, subscribing
-  ros::Publisher marker_pub_;
+  friend class KernelBenchmark;  // times findClosestNode on trees of its own
   // core functions
   bool tryDirectConnect(node* ps, node* pe, unsigned int i);
   int  developTree(unsigned int i);
   std::vector<node*> findMinimumPath(unsigned int i);
-  std::vector<node*> smoothPath(std::vector<node*> rough_path, int i);
+  std::vector<node*> smoothPath(std::vector<node*> rough_path, int i, float clearance, node** approach = NULL);
   void addPath(std::vector<node*> smooth_path, unsigned int i);
+  void finishLeg(unsigned int i, std::vector<node*> rough_path, std::vector<node*> smooth_path, leg_key_s leg_key, bool leg_cached, std::vector<NED_s>* all_rough_paths);
   NED_s findLoiterSpot(NED_s cp, float radius);
   NED_s findCloseLoiterSpot(NED_s cp, float radius);
 
   // secondary functions
   void resetParent(node* nin, node* new_parent);
   node* findClosestNodeGChild(node* root, NED_s p);
-  bool checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance, bool connecting_to_end);
+  bool checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance, bool connecting_to_end, node** added); // the new node is put in added
   NED_s randomPoint();
   node* findClosestNode(node* nin, NED_s P, node* minNode, float* minD);
   node* findMinConnector(node* nin, node* minNode, float* minCost);
   bool createFan(node* root, NED_s p, float chi, float clearance);
   float redoRandomDownPoint(unsigned int i, float closest_D);
-  bool checkWholePath(node* snode, std::vector<node*> rough_path, int ptr, int i);
-  bool checkDirectFan(NED_s coming_from, node* root, node* next_node);
+  bool takeOffHeading(unsigned int i, NED_s test_point); // false if a node this close to the take off points the wrong way
+  bool checkWholePath(node* snode, std::vector<node*> rough_path, int ptr, int i, float clearance, node** added);
+  bool checkDirectFan(NED_s coming_from, node* root, node* next_node, float clearance, node** added);
   void setupBombWps();
+  void saveTrees();
+  int  reuseTree(unsigned int i, long unsigned int* reused_nodes);
+  leg_key_s legKey(unsigned int i, float chi0, unsigned long map_hash);
+  leg_s packLeg(leg_key_s key, std::vector<node*> smooth_path, unsigned int i);
+  std::vector<node*> unpackLeg(leg_s leg, unsigned int i);
+  bool trySeedPath(node* start_node, std::vector<NED_s> seed, unsigned int i);
+  bool growLeg(unsigned int i, unsigned long map_hash, long unsigned int* iters_left); // false if cancelled or out of iterations
+  bool cancelled();
+
+  // Planning legs ahead of time
+  void startSpeculation(NED_s pos, unsigned long map_hash);
+  bool planLegAhead(unsigned int i, NED_s pos, NED_s approach, leg_key_s key, leg_s* leg); // runs on another planner's thread
+  bool takeSpeculation(unsigned int i, leg_key_s key, leg_s* leg);
+  bool fitJunction(unsigned int i, leg_s* leg);
+  void stopSpeculation();
+
   // Initialize and clear data functions
   void setup();
   void initializeTree(NED_s pos, float chi0);
@@ -72,6 +129,8 @@ private:
   void clearForNewMap();
   void deleteTree();                 // Delete the entire tree
 	void deleteNode(node*);            // Recursively delete the nodes
+  void pruneLeg(unsigned int i, unsigned int keep_children); // deletes the nodes leg i added after the first keep_children children of its root
+  void pruneNode(node* pn, node* goal); // deletes pn and everything under it except goal
   void clearTree();                  // Clear the entire tree
 	void clearNode(node*);             // Recursively clear the nodes
 
@@ -80,10 +139,13 @@ private:
   void printRoots();                         // prints all of the root nodes
   void printNode(node* nin);                 // prints the node
   void printFillet(fillet_s fil);
-  rrtPlotter plt;
+  void pause(float seconds);                 // lets the animation be seen
+  void event(uint32_t id, float a0 = 0.0f, float a1 = 0.0f, float a2 = 0.0f, float a3 = 0.0f); // records in events_ if there is one
+  void reportFailure(unsigned int i);        // logs the last events after leg i failed
+  VizSink* viz_;                  // owned by whoever calls setVizSink (can be NULL)
+  PhaseTrace* trace_;             // owned by whoever calls setTrace (can be NULL), shared with the smoother and the speculative planners
   rrtColors clr;
   float initial_map_time_;
-  float tree_display_time_;
   float smoothing_display_time_;
   float smoothed_display_time_;
 
@@ -91,7 +153,7 @@ private:
   float comfortable_altitude_;    // comfortable altitude to attain while taking off
   float chi_take_off_;            // comfortable angle to take off in
   float segment_length_;          // If used, this is the distance the algorithm uses between each node
-  ParamReader input_file_;        // address of the input file
+  planner_config_s input_file_;   // the planner configuration
   int num_paths_;                 // number of paths to be genererated before choosing the optimal path
   RandGen rg_;                    // Here is the random generator for the algorithm
   std::vector<node*> root_ptrs_;  // Vector of all roots, each element is the start of the tree to reach the next primary waypoint
@@ -101,7 +163,25 @@ private:
 	float path_clearance_;          // The minimum clearance that the path from waypoint i to i+1 will have. (only decreases until new waypoint is obtained)
 	bool taking_off_;               // If the plane is currently taking off, this option will allow the path planner to ignor the height restricitons.
   bool direct_hit_;               // when true the algorithm will hit primary waypoints dead on instead of filleting
-  node* most_recent_node_;        // pointer to the most recently added node
+  node* most_recent_node_;        // pointer to the most recently added node to the trees (the smoother keeps its own)
+  bool reuse_trees_;              // when true the trees from the last solve are re-rooted and grown on the next solve (same obstacles only)
+  std::vector<NED_s> old_goals_;                  // the waypoint each of the saved trees was growing towards
+  std::vector<std::vector<NED_s> > old_trees_;    // node positions of each saved tree, every parent is listed before its children
+  std::vector<std::vector<int> > old_parents_;    // index of the parent of each saved node (-1 if the parent was the root)
+  LegCache leg_cache_;            // smoothed legs from earlier solves
+  Roadmap* roadmap_;              // roadmap of the current map, owned by whoever calls setRoadmap (can be NULL)
+  bool use_vis_graph_;            // when true the visibility graph path is tried before growing a tree
+  bool pipeline_smoothing_;       // when true leg i is smoothed on another thread while the tree of leg i + 1 grows
+  rrt_progress_s* progress_;      // owned by whoever calls setProgress (can be NULL)
+  unsigned int speculative_legs_; // number of legs after the first one that are planned ahead on other threads
+  float speculation_tolerance_;   // a leg planned ahead is kept if the real heading at its start is this close to the predicted one (rad)
+  std::vector<std::shared_ptr<RRT> > speculators_;                      // planner of leg i + 1 when it is planned ahead
+  std::vector<std::shared_ptr<rrt_progress_s> > speculation_progress_;  // cancel flag of each of those planners
+  std::vector<std::shared_future<bool> > speculations_;                 // indexed by leg, empty when nothing is planned ahead
+  std::vector<char> speculation_done_;                                   // set under progress_->mutex once leg i planned ahead is finished
+  std::vector<leg_key_s> speculation_keys_;                             // the predicted key of each leg planned ahead
+  std::vector<leg_s> speculated_legs_;
+  std::function<void(unsigned int)> leg_callback_;
   int emergency_priority_;
   int mission_priority_;
   int landing_priority_;
@@ -0,0 +1,82 @@
+/*	DESCRIPTION:
+ *	This is a header for the AutoTuner class. It picks the segment length,
+ *	the clearance schedule, the node budget and the test points per node
+ *	for one map by planning a fixed set of problems on it (random starts
+ *	through the waypoints of the map) with RRT::solveStatic, one setting at
+ *	a time (coordinate descent from the configured settings). A setting is
+ *	kept if it solves at least the required fraction of the problems and
+ *	takes less total time than the best so far. Every setting plans the
+ *	same problems from the same seeds, and stops as soon as it has failed
+ *	or taken too long to win.
+ *
+ *	The result is stored with the compiled map (MAP_SECTION_TUNING).
+ *
+ */
+#ifndef AUTO_TUNER_H
+#define AUTO_TUNER_H
+
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+
+#include <theseus/map_s.h>
+#include <theseus/planner_config.h>
+#include <theseus/RRT.h>
+#include <theseus/roadmap.h>
+
+namespace theseus
+{
+  struct tuning_result_s
+  {
+    planner_tuning_s tuning;
+    float success_rate;                       // of the tuned settings on the tuning problems
+    float mean_time;                          // of the tuned settings (s)
+    float untuned_time;                       // of the configured settings (s)
+    uint32_t problems;
+    uint32_t settings;                        // settings tried
+  };
+  struct tuning_problem_s
+  {
+    NED_s start;
+    float chi0;
+    unsigned int seed;
+  };
+  struct tuning_score_s
+  {
+    unsigned int solved;
+    unsigned int planned;                     // problems planned, less than all of them if it stopped early
+    double time;                              // (s)
+  };
+  class AutoTuner
+  {
+  public:
+    AutoTuner(map_s map, planner_config_s config, unsigned int num_problems, unsigned int seed);
+    void setRoadmap(Roadmap* roadmap);        // the problems are planned with it, owned by the caller (can be NULL)
+    void setProgress(rrt_progress_s* progress); // the cancel flag is checked, the solves report there (can be NULL)
+    void setProblemCallback(std::function<bool()> callback); // called before each problem, tuning stops if it returns false
+    bool tune(double budget, float success_rate); // false if it was cancelled, budget in seconds
+    tuning_result_s result();
+    static void pack(tuning_result_s result, std::vector<char>* blob);
+    static bool load(const char* data, size_t size, tuning_result_s* result);
+    float min_gain_;                          // fraction of the time a setting has to save to be kept
+
+  private:
+    bool score(planner_tuning_s tuning, tuning_score_s best, tuning_score_s* score); // false if it stopped early
+    bool stopping();                          // cancelled, or the problem callback said to stop
+    bool better(tuning_score_s a, tuning_score_s b);
+    bool meets(tuning_score_s score);
+    std::vector<planner_tuning_s> neighbours(planner_tuning_s tuning, unsigned int k);
+    map_s map_;
+    planner_config_s config_;
+    std::vector<tuning_problem_s> problems_;
+    Roadmap* roadmap_;
+    rrt_progress_s* progress_;
+    std::function<bool()> problem_callback_;
+    bool stopped_;                            // the problem callback returned false
+    float success_rate_;
+    std::chrono::steady_clock::time_point deadline_;
+    tuning_result_s result_;
+  };
+} // end namespace theseus
+#endif
@@ -3,13 +3,12 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
 
 #include <theseus/map_s.h>
 #include <theseus/fillet_s.h>
-#include <theseus/param_reader.h>
-
-#include <ros/ros.h>
-#include <ros/console.h>
+#include <theseus/planner_config.h>
+#include <theseus/log.h>
 
 namespace theseus
 {
@@ -17,6 +16,7 @@ namespace theseus
   {
   public:
     CollisionDetection();
+    explicit CollisionDetection(planner_config_s config);
     ~CollisionDetection();
     bool checkFillet(NED_s w_im1, NED_s  w_i, NED_s w_ip1, float R, float clearance);
     bool checkFillet(fillet_s fil, float clearance);
@@ -26,6 +26,7 @@ namespace theseus
     bool checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lambda, float clearance);
     bool checkAfterWP(NED_s p, float chi, float clearance);
     void newMap(map_s map_in);
+    void countChecks(std::atomic<unsigned long>* counter); // every checkLine, checkArc and checkPoint adds one to it (can be NULL)
 
     bool  taking_off_;
     bool  landing_now_;
@@ -38,7 +39,8 @@ namespace theseus
 
   private:
     map_s map_;
-    ParamReader input_file_;
+    planner_config_s input_file_;
+    std::atomic<unsigned long>* check_counter_;   // owned by whoever calls countChecks (can be NULL)
 
     // Map variables
     std::vector<std::vector<float> > lineMinMax_; // (N x 4) vector containing the (min N, max N, min E, max E) for each boundary line
@@ -0,0 +1,60 @@
+/*	DESCRIPTION:
+ *	This is a header for the CollisionOracle class. It is the slow reference
+ *	for CollisionDetection: points, lines and arcs are walked in steps of a
+ *	few centimeters and every step is measured against the exact geometry
+ *	(the boundary polygon, the flying heights and the cylinders) in double
+ *	precision. Instead of a yes or no it returns the margin, how far the
+ *	worst step is from breaking the clearance (negative when it does) and
+ *	which constraint that was. The walk can miss at most step/2, so anything
+ *	within a tolerance bigger than that of 0 can go either way.
+ *
+ *	It is only meant for checking CollisionDetection (and anything that
+ *	replaces its kernels), see theseus_collision_differential.
+ *
+ */
+#ifndef COLLISION_ORACLE_H
+#define COLLISION_ORACLE_H
+
+#include <vector>
+
+#include <theseus/map_s.h>
+#include <theseus/planner_config.h>
+
+namespace theseus
+{
+  enum oracle_constraint_e
+  {
+    ORACLE_NONE,                  // no constraint at all (empty map)
+    ORACLE_BOUNDARY,              // index is the boundary line, from boundary_pts[index] to the next one
+    ORACLE_ALTITUDE,
+    ORACLE_CYLINDER,              // index is the cylinder
+    ORACLE_CLIMB                  // the climb or descend angle of a line
+  };
+  struct oracle_margin_s
+  {
+    double margin;                // (m), negative when the clearance is broken
+    oracle_constraint_e constraint;
+    int index;
+    NED_s where;                  // the step that is the closest to breaking it
+  };
+  class CollisionOracle
+  {
+  public:
+    CollisionOracle(planner_config_s config, double step);
+    void newMap(map_s map);
+    oracle_margin_s point(NED_s p, double clearance);
+    oracle_margin_s line(NED_s ps, NED_s pe, double clearance);
+    oracle_margin_s arc(NED_s ps, NED_s pe, double R, NED_s cp, int lambda, double clearance); // lambda 1 = cw, -1 = ccw, like fillet_s
+
+    bool taking_off_;             // the flying heights aren't checked while taking off or landing, like CollisionDetection
+    bool landing_now_;
+
+  private:
+    void measure(NED_s p, double clearance, oracle_margin_s* worst);
+    void worse(double margin, oracle_constraint_e constraint, int index, NED_s p, oracle_margin_s* worst);
+    map_s map_;
+    planner_config_s config_;
+    double step_;                 // (m)
+  };
+} // end namespace theseus
+#endif
@@ -0,0 +1,88 @@
+/*	DESCRIPTION:
+ *	This is a header for the EventRing class. It keeps the last few thousand
+ *	things the planner did (a time, an event id and up to four numbers) in a
+ *	fixed ring that any thread adds to without locks or formatting. The text
+ *	is only made when the ring is dumped, after a failed solve or when asked.
+ *
+ *	Each slot is guarded by its own sequence number like SeqLock, so a dump
+ *	that runs while the planner records skips the slots that are being
+ *	written instead of reading half of one.
+ *
+ */
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace theseus
+{
+  enum planner_event_e
+  {
+    EV_SOLVE_START,
+    EV_SOLVE_SETUP,
+    EV_SOLVE_DONE,
+    EV_SOLVE_FAILED,
+    EV_SOLVE_CANCELLED,
+    EV_FAN,
+    EV_LEG_START,
+    EV_LEG_CACHED,
+    EV_CACHE_MISFIT,
+    EV_LEG_SPECULATED,
+    EV_SPECULATION_MISSED,
+    EV_SPECULATION_MISFIT,
+    EV_DIRECT,
+    EV_VIS_GRAPH,
+    EV_REUSED,
+    EV_ROADMAP,
+    EV_NODES,
+    EV_CLEARANCE,
+    EV_TEST_POINTS,
+    EV_TOO_MANY_NODES,
+    EV_CONNECTED,
+    EV_LANDING_REJECTED,
+    EV_MIN_PATH,
+    EV_SMOOTH_START,
+    EV_SMOOTH_STEP,
+    EV_SMOOTH_FAN,
+    EV_SMOOTH_DONE,
+    EV_SMOOTH_TIMEOUT,
+    EV_APPROACH_MOVED,
+    EV_TAKE_OFF_DONE,
+    EV_ALTITUDE,
+    EV_LOITER_SPOT,
+    EV_BOMB_APPROACH,
+    NUM_PLANNER_EVENTS
+  };
+  struct event_record_s
+  {
+    uint64_t stamp_ns;          // steady clock
+    uint32_t id;                // planner_event_e
+    uint32_t thread;            // small number for each thread that records, in the order they first did
+    float    args[4];
+  };
+  class EventRing
+  {
+  public:
+    explicit EventRing(unsigned int capacity);  // rounded up to a power of 2
+    void record(uint32_t id, float a0 = 0.0f, float a1 = 0.0f, float a2 = 0.0f, float a3 = 0.0f);
+    std::vector<event_record_s> last(unsigned int n);  // the newest n that are still there, oldest first
+    std::string format(unsigned int n);                // one line each, times from the first one
+    bool dump(std::string file_name);                  // everything that is still in the ring
+    unsigned long recorded();                          // since the start, including the ones written over
+
+  private:
+    struct slot_s
+    {
+      std::atomic<uint64_t> seq;                // 2n + 1 while record n is written, 2n + 2 once it is there
+      std::atomic<uint64_t> words[4];
+    };
+    std::unique_ptr<slot_s[]> slots_;
+    uint64_t mask_;
+    std::atomic<uint64_t> head_;                // number of the next record
+  };
+} // end namespace theseus
+#endif
@@ -7,7 +7,9 @@
 #include <uav_msgs/MovingObstacle.h>
 #include <uav_msgs/MovingObstacleCollection.h>
 #include <visualization_msgs/Marker.h>
+#include <visualization_msgs/MarkerArray.h>
 #include <theseus/gps_struct.h>
+#include <theseus/odom_trail.h>
 #include <geometry_msgs/Pose.h>
 #include <tf/tf.h>
 
@@ -37,11 +39,14 @@ private:
   //***************** CALLBACKS AND TIMERS *****************//
   ros::WallTimer update_viz_timer_;
   void updateViz(const ros::WallTimerEvent&);
-  ros::Publisher ground_pub_;
+  ros::Publisher ground_pub_;           // every update goes out as one MarkerArray
+  ros::Publisher trail_pub_;            // latched, the history of the odometry trail
   visualization_msgs::Marker odom_mkr_;
+  OdomTrail odom_trail_;
   visualization_msgs::Marker mobs_mkr_;
   visualization_msgs::Marker pose_mkr_;
   bool recieved_state_;
+  unsigned int num_mobs_;               // moving obstacles in the last update, the ones that are gone get deleted
   gps_struct gps_converter_;
   double lat_ref_;
   double lon_ref_;
@@ -0,0 +1,47 @@
+/*	DESCRIPTION:
+ *	Latency histograms for the planning services. A latency_histogram_s
+ *	keeps counts in buckets that are 1/8 of a power of 2 wide (like an HDR
+ *	histogram with 3 significant bits), so every percentile is within 12.5%
+ *	from 1 us to days with a few hundred counters. A LatencyWindow keeps one
+ *	of them for each slice of a rolling window of time and adds up the ones
+ *	still in the window, so the percentiles are the ones of the last few
+ *	minutes of the flight and not of the whole flight.
+ *
+ */
+#ifndef LATENCY_WINDOW_H
+#define LATENCY_WINDOW_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace theseus
+{
+  struct latency_histogram_s
+  {
+    static const unsigned int num_buckets_ = 320;
+    uint32_t buckets[num_buckets_];
+    uint32_t count;
+    uint32_t failed;
+    double   max;                               // (s)
+    latency_histogram_s();
+    void   clear();
+    void   add(double seconds, bool failed_job);
+    void   merge(const latency_histogram_s& other);
+    double percentile(double p) const;          // upper edge of the bucket that p (0 to 100) falls in (s)
+  };
+  class LatencyWindow
+  {
+  public:
+    LatencyWindow(double window = 300.0, unsigned int num_slices = 10);
+    void add(double now, double seconds, bool failed_job);  // now in seconds, from any clock that doesn't go back
+    latency_histogram_s window(double now);     // everything added in the last window seconds
+    double length();                            // window (s)
+
+  private:
+    void advance(double now);
+    std::vector<latency_histogram_s> slices_;
+    double slice_length_;
+    long   current_;                            // number of the slice that the last time fell in
+  };
+} // end namespace theseus
+#endif
@@ -0,0 +1,68 @@
+/*	DESCRIPTION:
+ *	This is a header for the LegCache class. It remembers the smoothed
+ *	solution of the legs that the RRT has already solved so that a replan
+ *	of the same leg (same start, heading, goal, clearance, planner settings,
+ *	flags and map) doesn't have to grow and smooth a tree again. A leg that
+ *	is found still has to fit the turn into its start (RRT::fitJunction).
+ *
+ */
+#ifndef LEG_CACHE_H
+#define LEG_CACHE_H
+
+#include <deque>
+#include <vector>
+#include <math.h>
+
+#include <theseus/map_s.h>
+#include <theseus/fillet_s.h>
+#include <theseus/planner_config.h>
+
+namespace theseus
+{
+struct leg_key_s
+{
+  NED_s start;                    // position of the root of the leg
+  float chi;                      // heading of the plane at the root
+  NED_s goal;                     // waypoint the leg ends at
+  float clearance;                // clearance the leg was planned with, after any shrinking
+  planner_tuning_s tuning;        // settings the tree was grown with
+  unsigned int flags;             // direct hit, landing, taking off, bomb line and fan flags
+  unsigned long map_hash;         // hash of the boundaries and cylinders
+};
+struct leg_s
+{
+  leg_key_s key;
+  std::vector<NED_s> path;        // smoothed waypoints after the root, not including the goal
+  std::vector<fillet_s> fils;     // fillet of each of those waypoints
+  fillet_s goal_fil;              // fillet stored in the goal root
+  fillet_s smooth_goal_fil;       // fillet stored in the goal smoothing root
+  bool smooth_from_root;          // true if the goal smoothing root's parent was the root of the leg
+  bool smooth_from_null;          // true if the goal smoothing root had no parent
+  NED_s smooth_from;              // position of the goal smoothing root's parent
+  fillet_s smooth_from_fil;       // fillet of the goal smoothing root's parent
+};
+enum leg_flags_e
+{
+  LEG_DIRECT_HIT  = 1,
+  LEG_LANDING     = 2,
+  LEG_TAKING_OFF  = 4,
+  LEG_BOMB_LINE   = 8,
+  LEG_DONT_CONNECT = 16
+};
+class LegCache
+{
+public:
+  LegCache();
+  ~LegCache();
+  void setSize(unsigned int size);          // 0 disables the cache
+  bool find(leg_key_s key, leg_s* leg);     // true if the leg was found, moves it to the front
+  void add(leg_s leg);
+  void clear();
+  static unsigned long hashMap(map_s map);  // hash of the boundaries and cylinders, the waypoints are not included
+  static bool sameKey(leg_key_s a, leg_key_s b, float chi_tol = 0.001f); // chi_tol in rad
+private:
+  std::deque<leg_s> legs_;        // most recently used first
+  unsigned int size_;
+};
+}
+#endif
@@ -0,0 +1,37 @@
+/*	DESCRIPTION:
+ *	This is a header for the logging of the planner (theseus_core), so that
+ *	the core doesn't need ROS. THESEUS_DEBUG ... THESEUS_FATAL take printf
+ *	arguments like the ROS_* macros. Messages below the level are dropped,
+ *	the rest go to the sink, which prints them to stdout (stderr from warn
+ *	up) until one is set. The nodes send them to rosconsole (ros_log.h).
+ *
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include <functional>
+
+namespace theseus
+{
+  enum log_level_e                            // the rosconsole levels
+  {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_FATAL
+  };
+  void setLogLevel(int level);                // messages below it are dropped, info to start with
+  void setLogSink(std::function<void(int, const char*)> sink); // gets the level and the message, empty prints them
+  bool logEnabled(int level);
+  void logPrintf(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+} // end namespace theseus
+
+#define THESEUS_LOG(level, ...) do { if (theseus::logEnabled(level)) theseus::logPrintf(level, __VA_ARGS__); } while (0)
+#define THESEUS_DEBUG(...) THESEUS_LOG(theseus::LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define THESEUS_INFO(...)  THESEUS_LOG(theseus::LOG_LEVEL_INFO,  __VA_ARGS__)
+#define THESEUS_WARN(...)  THESEUS_LOG(theseus::LOG_LEVEL_WARN,  __VA_ARGS__)
+#define THESEUS_ERROR(...) THESEUS_LOG(theseus::LOG_LEVEL_ERROR, __VA_ARGS__)
+#define THESEUS_FATAL(...) THESEUS_LOG(theseus::LOG_LEVEL_FATAL, __VA_ARGS__)
+
+#endif
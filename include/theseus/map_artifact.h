@@ -0,0 +1,88 @@
+/*	DESCRIPTION:
+ *	This is a header for the MapArtifact class. A compiled map is one
+ *	versioned binary file that holds everything derived from a map_s
+ *	(boundary and cylinder arrays, visibility graph and roadmap) so a
+ *	restarted node can mmap it instead of building all of it again.
+ *
+ *	Layout: map_artifact_header_s, then num_sections map_artifact_section_s,
+ *	then the sections themselves, each one starting on an 8 byte boundary.
+ *
+ */
+#ifndef MAP_ARTIFACT_H
+#define MAP_ARTIFACT_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <string.h>
+
+#include <theseus/map_s.h>
+
+namespace theseus
+{
+  struct map_artifact_header_s
+  {
+    char     magic[8];                          // "THSMAP\0\0"
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t map_hash;                          // LegCache::hashMap of the map it was compiled from
+    float    clearance;                         // clearance everything was built with
+    uint32_t reserved;
+  };
+  struct map_artifact_section_s
+  {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t offset;                            // from the start of the file
+    uint64_t size;                              // bytes
+  };
+  enum map_artifact_section_e
+  {
+    MAP_SECTION_BOUNDARY   = 1,                 // N[], E[], D[] as doubles
+    MAP_SECTION_CYLINDERS  = 2,                 // N[], E[], R[], H[] as doubles
+    MAP_SECTION_VISIBILITY = 3,                 // VisibilityGraph::pack
+    MAP_SECTION_ROADMAP    = 4,                 // Roadmap::pack
+    MAP_SECTION_TUNING     = 5                  // AutoTuner::pack
+  };
+  // Helpers to write and read the sections
+  template <typename T> void appendBlob(std::vector<char>* blob, const T* data, size_t n)
+  {
+    if (n > 0)
+      blob->insert(blob->end(), (const char*) data, (const char*) data + n*sizeof(T));
+  }
+  struct blob_reader_s
+  {
+    const char* p;
+    const char* end;
+    blob_reader_s(const char* data, size_t size) : p(data), end(data + size) {}
+    template <typename T> bool read(T* out, size_t n)
+    {
+      if ((size_t) (end - p) < n*sizeof(T))
+        return false;
+      if (n > 0)
+        memcpy(out, p, n*sizeof(T));
+      p += n*sizeof(T);
+      return true;
+    }
+  };
+  class MapArtifact
+  {
+  public:
+    MapArtifact();
+    ~MapArtifact();
+    bool open(std::string file_name, map_s map, float clearance); // false if missing, another version, or for another map
+    void close();
+    bool isOpen();
+    const char* section(uint32_t id, size_t* size);                // NULL if the section isn't there
+    static bool write(std::string file_name, map_s map, float clearance, std::vector<std::pair<uint32_t, std::vector<char> > > sections);
+    static std::string fileName(std::string directory, map_s map, float clearance);
+    static const uint32_t version_ = 1;
+
+  private:
+    static std::vector<char> boundarySection(map_s map);
+    static std::vector<char> cylinderSection(map_s map);
+    const char* data_;
+    size_t size_;
+  };
+} // end namespace theseus
+#endif
@@ -10,10 +10,11 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <theseus/log.h>
 #include <theseus/map_s.h>
 #include <theseus/gps_struct.h>
 #include <theseus/rand_gen.h>
-#include <theseus/param_reader.h>
+#include <theseus/planner_config.h>
 
 namespace theseus
 {
@@ -22,7 +23,7 @@ class mapper
 public:
 	// Functions
   mapper();
-	mapper(unsigned int seed, ParamReader *input_file);		// default constructor (uses the competition boundaries) with random obstacles.
+	mapper(unsigned int seed, planner_config_s *input_file);		// default constructor (uses the competition boundaries) with random obstacles.
 	~mapper();
   void translateBoundaries(double lat, double lon, double height);
 
@@ -36,7 +37,7 @@ private:
 	bool flyZoneCheck(const NED_s NED, double radius);    // Return false if the point gets within radius of an obstacle - calls flyZoneCheckMASTER()
 	void tempGPS_converter(double lat, double lon, double h);
   // Members
-	ParamReader *input_file;                        // Input Parameters File Variables
+	planner_config_s *input_file;                   // Input Parameters File Variables
 	RandGen rg;                                     // This is the random generator
 	std::vector<std::vector<double> > lineMinMax;   // (N x 4) vector containing the (min N, max N, min E, max E) for each boundary line
 	std::vector<std::vector<double> > line_Mandb;   // (N x 4) vector that contains the slope and intercept of the line (m, b, (-1/m), (m + 1/m)) from N = m*E + b ... not sure about E = constant lines yet.
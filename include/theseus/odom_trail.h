@@ -0,0 +1,54 @@
+/*	DESCRIPTION:
+ *	This is a header for the OdomTrail class. It keeps the trail of points
+ *	the plane has flown through for rviz. A point is only kept once the
+ *	plane has moved far enough or enough time has passed, and the trail
+ *	holds a fixed number of points, the oldest are dropped first.
+ *
+ *	The trail is split in two markers. The tail holds the newest points and
+ *	is sent with every update. Once it is full its points move into the
+ *	history, which is only sent then (on a latched topic), so an update
+ *	never carries more than the tail.
+ *
+ */
+#ifndef ODOM_TRAIL_H
+#define ODOM_TRAIL_H
+
+#include <vector>
+#include <math.h>
+
+#include <geometry_msgs/Point.h>
+#include <visualization_msgs/Marker.h>
+
+namespace theseus
+{
+enum trail_update_e
+{
+  TRAIL_NONE    = 0,              // the point was too close to the last one
+  TRAIL_TAIL    = 1,              // the tail changed
+  TRAIL_HISTORY = 2               // the tail changed and the history did too
+};
+class OdomTrail
+{
+public:
+  OdomTrail();
+  ~OdomTrail();
+  void setup(visualization_msgs::Marker style, unsigned int capacity, float min_distance, float max_period, unsigned int tail_length);
+  trail_update_e add(geometry_msgs::Point p, double t); // t is the time of the point (s)
+  visualization_msgs::Marker history();                 // oldest point first, id 0 of the style namespace
+  visualization_msgs::Marker tail();                    // id 1 of the style namespace
+  void clear();
+private:
+  visualization_msgs::Marker style_;        // everything but the points and id
+  std::vector<geometry_msgs::Point> ring_;  // the history, ring_[head_] is the oldest once it is full
+  unsigned int head_;
+  unsigned int capacity_;                   // points in the history and tail together
+  std::vector<geometry_msgs::Point> tail_;
+  unsigned int tail_length_;
+  float min_distance_;                      // a point this close to the last one is dropped (m) ...
+  float max_period_;                        // ... unless this long has passed since it (s)
+  geometry_msgs::Point last_;
+  double last_t_;
+  bool has_last_;
+};
+}
+#endif
@@ -5,48 +5,17 @@
 #include <string>
 #include <math.h>
 
+#include <theseus/planner_config.h>
+
 namespace theseus
 {
-class ParamReader
+// Fills in the planner configuration from the parameter server.
+class ParamReader : public planner_config_s
 {
 public:
 	ParamReader();
 	~ParamReader();
 
-	// PARAMETERS
-
-	// Simulation Settings
-	int numWps;
-	int seed;
-
-	// Plane settings
-  double Va;
-	double turn_radius;
-  double loiter_radius;
-	double max_climb_angle;
-	double max_descend_angle;
-
-	// General Path Planning Algorithm Settings
-	double clearance;
-	int iters_limit;
-
-	// Map Settings
-  double lat_ref;
-  double lon_ref;
-  double h_ref;
-  float N_init;
-  float E_init;
-  float D_init;
-  bool chi0;
-	double minCylRadius;
-	double maxCylRadius;
-	double minCylHeight;
-	double maxCylHeight;
-	double minFlyHeight;
-	double maxFlyHeight;
-	double waypoint_clearance;
-	int nCyli;
-
 private:
   //********************* NODE HANDLES *********************//
   ros::NodeHandle nh_;         // public node handle for publishing, subscribing
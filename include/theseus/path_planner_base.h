@@ -5,17 +5,39 @@
 #include <math.h>
 #include <algorithm>
 #include <fstream>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <sys/stat.h>
+#include <time.h>
+#include <chrono>
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 
 #include <theseus/RRT.h>
+#include <theseus/roadmap.h>
+#include <theseus/leg_cache.h>
+#include <theseus/map_artifact.h>
+#include <theseus/auto_tuner.h>
+#include <theseus/plan_log.h>
+#include <theseus/phase_timer.h>
+#include <theseus/latency_window.h>
+#include <theseus/seqlock.h>
 #include <theseus/mapper.h>
 #include <theseus/rand_gen.h>
 #include <theseus/param_reader.h>
+#include <theseus/ros_log.h>
 #include <theseus/gps_struct.h>
 #include <theseus/fillet_s.h>
 #include <theseus/rrt_plotter.h>
 #include <theseus/GPS.h>
 #include <theseus/ned2gps.h>
+#include <theseus/PlannerProgress.h>
+#include <theseus/PlannerMetrics.h>
+#include <theseus/PlannerLatency.h>
 
 #include <rosplane_msgs/Waypoint.h>
 #include <rosplane_msgs/NewWaypoints.h>
@@ -39,6 +61,46 @@ struct rrtOptions
   bool drop_bomb;
   bool loiter_mission;
 };
+struct vehicle_state_s
+{
+  NED_s position;
+  float chi;
+  float Va;
+  double stamp;                              // time of the state message (s)
+};
+enum plan_job_e
+{
+  JOB_WPS,
+  JOB_LANDING,
+  JOB_TEXTFILE,
+  JOB_BOMB,
+  JOB_MISSION,
+  JOB_SEND,
+  JOB_TUNE
+};
+enum plan_priority_e
+{
+  PRIORITY_TUNE     = 0,                     // only runs when nothing else is queued, any other job preempts it
+  PRIORITY_ADD      = 1,                     // added to the end of the path
+  PRIORITY_NOW      = 2,                     // replaces the path
+  PRIORITY_LAND_NOW = 3                      // beats everything
+};
+struct job_result_s
+{
+  uint8_t state;                             // PlannerProgress state it ended in
+  std::string note;                          // why it failed, if the job said
+};
+struct plan_job_s
+{
+  plan_job_e type;
+  bool now;
+  int priority;                              // a now job preempts a running job of lower priority
+  unsigned int id;
+  std::string name;                          // service that asked for it
+  std::chrono::steady_clock::time_point queued; // when it was asked for
+  bool wait;                                 // a blocking service waits for it, its final state goes into finished_
+  uav_msgs::GeneratePath::Request mission;   // JOB_MISSION only
+};
 class PathPlannerBase
 {
 public:
@@ -47,6 +109,12 @@ public:
 private:
   //********************* NODE HANDLES *********************//
   ros::NodeHandle nh_;         // public node handle for publishing, subscribing
+  ros::NodeHandle state_nh_;   // the state subscribers, serviced by state_spinner_ only
+  ros::CallbackQueue state_queue_;
+  ros::AsyncSpinner state_spinner_;
+  ros::NodeHandle job_nh_;     // the planning services that wait for their job, a thread each on job_spinner_
+  ros::CallbackQueue job_queue_;
+  ros::AsyncSpinner job_spinner_;
   tf::TransformBroadcaster tf_frame_;
   //************** SUBSCRIBERS AND PUBLISHERS **************//
   ros::ServiceServer plan_mission_service_;
@@ -70,6 +138,11 @@ private:
   ros::ServiceServer translate_map_srv_;
   ros::ServiceServer convert_ned_srv_;
   ros::ServiceServer convert_gps_srv_;
+  ros::ServiceServer phase_stats_srv_;
+  ros::ServiceServer dump_events_srv_;
+  ros::ServiceServer tune_map_srv_;
+  std::vector<ros::ServiceServer> async_services_; // the *_async planning services
+  ros::Publisher progress_publisher_;
   map_s myWorld_;
   void stateCallback(const rosplane_msgs::State &msg);
   void movingObsCallback(const uav_msgs::MovingObstacleCollection &msg);
@@ -88,16 +161,33 @@ private:
   std::vector<NED_s> last_primary_wps_;
   std::vector<NED_s> all_sent_wps_;
   std::vector<int> all_sent_priorities_;
+  unsigned int sent_path_version_; // plt's version of all_sent_wps_, 0 before anything is sent
   rrtColors clr;
   gps_struct gps_converter_;
+  rrtPlotter rrt_plt_;         // the planner animates on this one
   RRT rrt_obj_;
-  NED_s odometry_;
-  float chi0_;
-  bool recieved_state_;
+  Roadmap roadmap_;            // built in the background every time a new map comes in
+  MapArtifact map_artifact_;
+  std::string map_artifact_dir_;  // where compiled maps are kept, empty to turn them off
+  bool map_artifact_pending_;     // true while the roadmap of a map that hasn't been compiled is building
+  map_s map_artifact_map_;        // the map that is waiting to be compiled
+  map_s tuning_map_;              // the map of the last prepareMap, the one tune_map tunes for
+  planner_tuning_s tuning_;       // what rrt_obj_ plans with, the configured settings or the ones tuned for the map
+  tuning_result_s tuning_result_;
+  bool map_tuned_;                // true if tuning_ was tuned for the map (and goes into its compiled map)
+  bool auto_tune_;                // when true every new map that isn't tuned yet is tuned once nothing else is queued
+  double tune_time_;              // (s)
+  float tune_success_rate_;
+  int tune_problems_;
+  SeqLock<vehicle_state_s> vehicle_state_;  // written by stateCallback only, read from any thread without a lock
+  std::atomic<bool> recieved_state_;
+  bool has_ending_point_;      // false until ending_point_ is set from the first state
   bool has_map_;
   std::vector<NED_s> all_primary_wps_;
 
+  std::mutex distance_mutex_;  // guards the distances and what they are measured to
   std::vector<NED_s> waypoints_to_hit_;
+  std::vector<cyl_s> distance_cylinders_;
   std::vector<float> wp_distances_;
   std::vector<float> cyl_distances_;
   float min_cyl_dis_;
@@ -106,11 +196,72 @@ private:
   void updateViz(const ros::WallTimerEvent&);
   bool sendWaypoints(uav_msgs::UploadPath::Request &req, uav_msgs::UploadPath::Response &res);
   bool sendWaypointsCore(bool now);
+  bool sendWaypointsCore(bool now, unsigned int first, unsigned int end);
+  void streamLeg(unsigned int i);
+  bool loiterAtStreamed();     // ends what was streamed with a loiter point, for when the rest of the path failed
+  bool stream_legs_;           // when true a now path is sent one leg at a time while the rest is planned
+  unsigned int streamed_wps_;  // waypoints of the current solve that are already sent
+  vehicle_state_s predictState(vehicle_state_s state, double lead_time);
+  bool latency_compensation_;  // when true a now path starts where the plane will be once the path is uploaded
+  double latency_;             // running estimate of the time from reading the state to uploading a now path (s)
+  double plan_start_;          // ROS time the state of the current now plan was read (s)
+  bool latency_pending_;       // true until the first upload of the current now plan is timed
+  NED_s now_start_;            // where the current now plan starts
+  PlanLog plan_log_;           // every planning request and its result, when pp/request_log_dir is set
+  unsigned int plan_requests_; // requests planned so far, request i is planned from seed input_file_.seed + i
+  bool phase_timers_;          // when true the phases of every request are timed into phase_trace_
+  std::string trace_prefix_;   // the trace of request i is written to trace_prefix_<i>.json, empty to keep no traces
+  int trace_max_events_;
+  PhaseTrace phase_trace_;     // the request that is planning
+  PhaseTrace* request_trace_;  // &phase_trace_ while a request plans, NULL otherwise
+  PhaseStats phase_stats_;     // every request so far
+  void finishTrace(unsigned int id);
 
   double lat_ref_;
   double lon_ref_;
   double h_ref_;
 
+  //******************** PLANNING WORKER *******************//
+  // The services queue jobs, they are planned one at a time on worker_. A planning service waits for its job,
+  // the *_async one returns its id and the result is on planner_progress.
+  std::thread worker_;
+  std::mutex queue_mutex_;                   // guards jobs_, running_, job_running_, next_job_id_, finished_ and shutdown_
+  std::condition_variable queue_cv_;
+  std::condition_variable finished_cv_;
+  std::map<unsigned int, job_result_s> finished_; // how the waited for jobs ended, until the service takes it
+  std::string job_note_;                     // set by the running job when it fails, only the worker touches it
+  std::deque<plan_job_s> jobs_;              // highest priority first
+  plan_job_s running_;
+  bool job_running_;
+  bool shutdown_;
+  unsigned int next_job_id_;
+  rrt_progress_s progress_;                  // progress and cancel flag of the running job
+  std::mutex planner_mutex_;                 // held while a job runs (tuning only between its problems), anything else that uses rrt_obj_ or the map has to take it
+  void plannerThread();
+  plan_job_s makeJob(plan_job_e type, bool now, std::string name);
+  unsigned int queueJob(plan_job_s job);
+  void finishJob(plan_job_s job, uint8_t state, unsigned int queued, std::string note); // with queue_mutex_ held
+  bool waitForJob(plan_job_s job, std_srvs::Trigger::Response &res);
+  bool queueAsync(plan_job_e type, bool now, std::string name, std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res);
+  bool runJob(plan_job_s job);
+  void publishProgress(plan_job_s job, uint8_t state, unsigned int queued);
+
+  //*********************** METRICS ************************//
+  ros::Publisher metrics_publisher_;         // a PlannerMetrics for every job that ran
+  ros::Publisher latency_publisher_;         // the rolling latency of every service
+  ros::WallTimer latency_timer_;
+  std::atomic<unsigned long> checks_;        // collision checks of rrt_obj_ (and the legs it plans ahead)
+  double plan_time_;                         // the rest are of the running job, only the worker touches them (s)
+  double smooth_time_;
+  double upload_time_;
+  unsigned int uploads_;
+  unsigned long plan_nodes_;
+  std::mutex metrics_mutex_;                 // guards service_latency_
+  std::map<std::string, LatencyWindow> service_latency_;
+  double latency_window_;                    // (s)
+  void publishMetrics(plan_job_s job, uint8_t state, std::chrono::steady_clock::time_point start, unsigned long checks_at_start);
+  void publishLatency(const ros::WallTimerEvent&);
+
   //********************** FUNCTIONS ***********************//
   bool solveStatic(rrtOptions options);
 public:
@@ -126,6 +277,9 @@ public:
   bool newRandomMap(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
   bool displayMapService(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
   bool displayD2WP(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
+  bool phaseStats(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
+  bool dumpEvents(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
+  bool tuneMap(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res);
   bool planMission(uav_msgs::GeneratePath::Request &req, uav_msgs::GeneratePath::Response &res);
 
   bool translateBoundaries(theseus::GPS::Request &req, theseus::GPS::Response &res);
@@ -133,9 +287,14 @@ public:
   bool convertNED(theseus::ned2gps::Request &req, theseus::ned2gps::Response &res);
   bool convertGPS(theseus::GPS::Request &req, theseus::GPS::Response &res);
 private:
+  bool wps(bool now);
+  bool mission(uav_msgs::GeneratePath::Request req);
   bool landing(bool now);
   bool textfile(bool now);
   void getInitialMap();
+  void prepareMap(map_s map);
+  void compileMap();
+  bool tune();
   bool bomb(bool now);
 
 };// end class PathPlanner
@@ -0,0 +1,113 @@
+/*	DESCRIPTION:
+ *	Scoped timers for the phases of a solve. A ScopedPhase on the stack adds
+ *	one event to a PhaseTrace when it goes out of scope, nested scopes nest
+ *	in the trace. The events of one request are written as a Chrome
+ *	trace-event file (chrome://tracing, ui.perfetto.dev), the durations are
+ *	also kept per phase name in log2 histograms that PhaseStats adds up over
+ *	many requests. Without a trace (NULL) a scope costs one comparison.
+ *
+ */
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <stdint.h>
+
+namespace theseus
+{
+  struct phase_hist_s
+  {
+    std::string name;
+    uint64_t count;
+    double   total;                             // (s)
+    double   min;                               // (s)
+    double   max;                               // (s)
+    uint64_t buckets[32];                       // bucket k counts the durations from 2^k to 2^(k + 1) us, bucket 0 everything below 2 us
+    phase_hist_s();
+    void   add(double seconds);
+    void   merge(const phase_hist_s& other);
+    double percentile(double p);                // upper edge of the bucket that p (0 to 100) falls in (s)
+  };
+  struct phase_event_s
+  {
+    const char* name;                           // always a string literal
+    uint32_t tid;                               // order the threads first showed up in
+    int64_t  start_ns;                          // from the start of the trace
+    int64_t  dur_ns;
+  };
+  class PhaseTrace
+  {
+  public:
+    PhaseTrace();
+    void start(unsigned int max_events);        // drops the last trace, every later event is timed from now
+    void add(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+    bool writeChromeTrace(std::string file_name, std::string label);
+    std::vector<phase_hist_s> histograms();
+    unsigned long dropped();                    // events past max_events, they are still in the histograms
+
+  private:
+    std::mutex mutex_;                          // the smoother and the speculative planners add from other threads
+    std::chrono::steady_clock::time_point t0_;
+    std::vector<phase_event_s> events_;
+    std::vector<std::thread::id> threads_;
+    std::vector<const char*> names_;            // the name of each of hists_, compared by address
+    std::vector<phase_hist_s> hists_;
+    unsigned int max_events_;
+    unsigned long dropped_;
+  };
+  class ScopedPhase
+  {
+  public:
+    ScopedPhase(PhaseTrace* trace, const char* name) : trace_(trace), name_(name)
+    {
+      if (trace_ != NULL)
+        start_ = std::chrono::steady_clock::now();
+    }
+    ~ScopedPhase()
+    {
+      if (trace_ != NULL)
+        trace_->add(name_, start_, std::chrono::steady_clock::now());
+    }
+  private:
+    PhaseTrace* trace_;
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+  };
+  class ScopedDuration                          // adds the microseconds it was alive to a counter (can be NULL)
+  {
+  public:
+    explicit ScopedDuration(std::atomic<unsigned long>* us) : us_(us)
+    {
+      if (us_ != NULL)
+        start_ = std::chrono::steady_clock::now();
+    }
+    ~ScopedDuration()
+    {
+      if (us_ != NULL)
+        us_->fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count(),
+                       std::memory_order_relaxed);
+    }
+  private:
+    std::atomic<unsigned long>* us_;
+    std::chrono::steady_clock::time_point start_;
+  };
+  class PhaseStats
+  {
+  public:
+    PhaseStats();
+    void add(std::vector<phase_hist_s> hists);  // the histograms of one request
+    std::string report();                       // one line per phase, slowest total first
+    void clear();
+
+  private:
+    std::mutex mutex_;
+    std::vector<phase_hist_s> hists_;
+    unsigned long requests_;
+  };
+} // end namespace theseus
+#endif
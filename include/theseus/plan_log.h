@@ -0,0 +1,87 @@
+/*	DESCRIPTION:
+ *	This is a header for the PlanLog class. It records every planning
+ *	request the path planner gets (the map, where it starts, the options,
+ *	the seed and the configuration) and what came out of it, so a slow or
+ *	failed plan can be run again exactly with theseus_plan_replay.
+ *
+ *	Layout: plan_log_header_s, then records, each one a plan_log_record_s
+ *	followed by its payload. A request is written before it is planned and
+ *	its result after, so a log cut short by a crash still has the request.
+ *
+ */
+#ifndef PLAN_LOG_H
+#define PLAN_LOG_H
+
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <theseus/map_s.h>
+#include <theseus/map_artifact.h>
+#include <theseus/planner_config.h>
+
+namespace theseus
+{
+  struct plan_log_header_s
+  {
+    char     magic[8];                          // "THSLOG\0\0"
+    uint32_t version;
+    uint32_t config_size;                       // sizeof(planner_config_s) of whoever wrote it
+  };
+  struct plan_log_record_s
+  {
+    uint32_t kind;                              // plan_log_record_e
+    uint32_t size;                              // bytes of payload that follow
+  };
+  enum plan_log_record_e
+  {
+    PLAN_RECORD_REQUEST = 1,
+    PLAN_RECORD_RESULT  = 2
+  };
+  struct plan_request_s
+  {
+    uint32_t id;                                // counts the requests since the log was opened
+    double   stamp;                             // wall time it was planned at (s)
+    uint32_t seed;                              // the planner was given its own random sequence from this seed
+    NED_s    pos;
+    float    chi;
+    bool     now;
+    bool     direct_hit;
+    bool     landing;
+    bool     drop_bomb;
+    bool     loiter_mission;
+    bool     roadmap_ready;                     // the roadmap of the map was finished when the solve started
+    bool     animating;                         // the solve time includes the animation pauses
+    map_s    map;                               // what the planner plans on, waypoints included
+    planner_config_s config;
+  };
+  struct plan_result_s
+  {
+    uint32_t id;                                // of the request
+    bool     solved;
+    double   solve_time;                        // (s)
+    uint64_t nodes;                             // nodes added to all of the trees
+    std::vector<NED_s> wps;                     // the planned path
+  };
+  class PlanLog
+  {
+  public:
+    PlanLog();
+    ~PlanLog();
+    bool open(std::string file_name);           // starts a new log, false if it can't be written
+    void close();
+    bool isOpen();
+    bool write(plan_request_s request);
+    bool write(plan_result_s result);
+    static bool read(std::string file_name, std::vector<plan_request_s>* requests, std::vector<plan_result_s>* results);
+    static const uint32_t version_ = 1;
+
+  private:
+    bool writeRecord(uint32_t kind, std::vector<char> payload);
+    static void appendPoints(std::vector<char>* blob, std::vector<NED_s> points);
+    static bool readPoints(blob_reader_s* reader, std::vector<NED_s>* points);
+    FILE* file_;
+  };
+} // end namespace theseus
+#endif
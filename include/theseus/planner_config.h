@@ -0,0 +1,155 @@
+/*	DESCRIPTION:
+ *	Everything the planner core (RRT, CollisionDetection, the mapper and the
+ *	roadmap) is configured with. It is a plain struct so the core can be set
+ *	up without a parameter server, the defaults are the ones in
+ *	param/path_planning.yaml. ParamReader fills one in from the parameter
+ *	server for the ROS nodes. Angles are in radians.
+ *
+ */
+#ifndef PLANNER_CONFIG_H
+#define PLANNER_CONFIG_H
+
+#include <math.h>
+
+namespace theseus
+{
+struct planner_config_s
+{
+	// Simulation Settings
+	int numWps;
+	int seed;
+
+	// Plane settings
+  double Va;
+	double turn_radius;
+  double loiter_radius;
+	double max_climb_angle;
+	double max_descend_angle;
+
+	// General Path Planning Algorithm Settings
+	double clearance;
+	int iters_limit;
+  float clearance_shrink;         // the clearance of a leg is multiplied by this every time it uses clearance_patience of its nodes
+  float clearance_patience;       // fraction of the nodes left a leg grows before its clearance shrinks
+
+	// Map Settings
+  double lat_ref;
+  double lon_ref;
+  double h_ref;
+  float N_init;
+  float E_init;
+  float D_init;
+  bool chi0;
+	double minCylRadius;
+	double maxCylRadius;
+	double minCylHeight;
+	double maxCylHeight;
+	double minFlyHeight;
+	double maxFlyHeight;
+	double waypoint_clearance;
+	int nCyli;
+
+  // RRT Settings
+  float segment_length;           // distance between each node of the trees
+  int   max_test_points;          // random points tried for a new node before developTree gives up
+  bool  reuse_trees;              // re-root the trees from the last solve when replanning to the same waypoints
+  int   leg_cache_size;           // smoothed legs remembered between solves, 0 turns the cache off
+  bool  visibility_graph;         // try the shortest 2D path around the cylinders before growing a tree
+  bool  pipeline_smoothing;       // smooth each leg on another thread while the next leg grows
+  int   speculative_legs;         // legs after the first one that are planned ahead on other threads
+  float speculation_tolerance;    // largest heading error at a direct hit waypoint for a leg planned ahead to be kept
+  float comfortable_altitude;     // altitude to gain while taking off
+  float chi_take_off;             // heading to take off in, less than -100 if it doesn't matter
+  float loiter_serch_alt;         // altitude of a loiter mission
+
+  // Roadmap Settings
+  int   roadmap_nodes;            // nodes in the roadmap that is built for every new map, 0 turns it off
+  float roadmap_radius;           // longest roadmap edge
+
+  // Logging
+  int   console_level;            // log level the node sets once (logToRosconsole): 0 debug, 1 info, 2 warn, 3 error, 4 fatal
+  int   event_ring_size;          // planner events kept to dump after a failed solve, 0 turns them off
+
+  planner_config_s()
+  {
+    double deg2rad        = M_PI/180.0;
+    numWps                = 5;
+    seed                  = 22025;
+    Va                    = 20.0;
+    turn_radius           = 50.0;
+    loiter_radius         = 75.0;
+    max_climb_angle       = 20.0*deg2rad;
+    max_descend_angle     = 14.0*deg2rad;
+    clearance             = 30.0;
+    iters_limit           = 5000;
+    clearance_shrink      = 0.5f;
+    clearance_patience    = 0.5f;
+    lat_ref               = 38.1446929;
+    lon_ref               = -76.428007;
+    h_ref                 = 0.0;
+    N_init                = 0.0f;
+    E_init                = 0.0f;
+    D_init                = 0.0f;
+    chi0                  = false;
+    minCylRadius          = 9.144;
+    maxCylRadius          = 91.44;
+    minCylHeight          = 9.144;
+    maxCylHeight          = 228.6;
+    minFlyHeight          = 30.48;
+    maxFlyHeight          = 228.6;
+    waypoint_clearance    = 40.0;
+    nCyli                 = 10;
+    segment_length        = 90.0f;
+    max_test_points       = 250;
+    reuse_trees           = false;
+    leg_cache_size        = 32;
+    visibility_graph      = true;
+    pipeline_smoothing    = false;
+    speculative_legs      = 0;
+    speculation_tolerance = 5.0f*deg2rad;
+    comfortable_altitude  = 40.0f;
+    chi_take_off          = -1000.0f;
+    loiter_serch_alt      = 50.0f;
+    roadmap_nodes         = 0;
+    roadmap_radius        = 400.0f;
+    console_level         = 1;
+    event_ring_size       = 8192;
+  }
+};
+// The part of the configuration that is tuned for each map, see AutoTuner.
+struct planner_tuning_s
+{
+  float segment_length;
+  float clearance_shrink;
+  float clearance_patience;
+  int   iters_limit;
+  int   max_test_points;
+
+  planner_tuning_s()
+  {
+    *this = planner_tuning_s(planner_config_s());
+  }
+  planner_tuning_s(const planner_config_s& config)
+  {
+    segment_length     = config.segment_length;
+    clearance_shrink   = config.clearance_shrink;
+    clearance_patience = config.clearance_patience;
+    iters_limit        = config.iters_limit;
+    max_test_points    = config.max_test_points;
+  }
+  void apply(planner_config_s* config) const
+  {
+    config->segment_length     = segment_length;
+    config->clearance_shrink   = clearance_shrink;
+    config->clearance_patience = clearance_patience;
+    config->iters_limit        = iters_limit;
+    config->max_test_points    = max_test_points;
+  }
+  bool operator==(const planner_tuning_s& b) const
+  {
+    return segment_length == b.segment_length && clearance_shrink == b.clearance_shrink && clearance_patience == b.clearance_patience &&
+           iters_limit == b.iters_limit && max_test_points == b.max_test_points;
+  }
+};
+}// end namespace theseus
+#endif // PLANNER_CONFIG_H
@@ -7,18 +7,32 @@
 
 namespace theseus
 {
+struct rand_mark_s                // where a RandGen is in its sequence
+{
+  unsigned int state;
+  unsigned long draws;
+};
 class RandGen
 {
 public:
 	RandGen(int seed_in); // Use this contructor - give it a seed
+	RandGen(int seed_in, bool own_stream); // own_stream keeps its own state, other threads drawing numbers don't change this sequence
 	RandGen();                     // Default contructor - NO SEED. Needed to allow randGen to be a member of a class
 	~RandGen();                    // Deconstructor
 	double randLin();              // This public function returns a random number from 0 to 1, uniform distribution.
 	double norm_rnd(double mu, double sigma);
   std::vector<unsigned int> UINTv(unsigned int len);	// Returns a vector of length len of random unsigned integers
   unsigned int UINT();
+  bool ownStream();              // true if it keeps its own state (it can be rewound)
+  rand_mark_s mark();
+  bool rewind(rand_mark_s mark); // goes back to the mark, false (and nothing changes) if it uses the shared sequence
 private:
+  int next();                    // the next number of its sequence
+
 	int seed;             // Stores the seed - might be unnecessary.
+	bool own_stream_;     // when true the numbers come from state_ instead of the shared rand() sequence
+	unsigned int state_;
+  unsigned long draws_;  // numbers drawn since it was seeded
 };
 }
 #endif
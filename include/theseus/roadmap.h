@@ -0,0 +1,69 @@
+/*	DESCRIPTION:
+ *	This is a header for the Roadmap class. It is a probabilistic roadmap
+ *	that is built once per map (in the background) and then answers many
+ *	planning queries with a graph search instead of growing a new tree.
+ *	The roadmap is 2D, every edge is checked at the lowest legal altitude
+ *	so it is valid at any altitude. Altitudes are filled in per query.
+ *
+ */
+#ifndef ROADMAP_H
+#define ROADMAP_H
+
+#include <vector>
+#include <queue>
+#include <math.h>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <theseus/map_s.h>
+#include <theseus/collision_detection.h>
+#include <theseus/map_artifact.h>
+#include <theseus/planner_config.h>
+#include <theseus/log.h>
+
+namespace theseus
+{
+  struct roadmap_edge_s
+  {
+    unsigned int to;                          // index of the node on the other end
+    float length;                             // length of the edge (m)
+  };
+  class Roadmap
+  {
+  public:
+    Roadmap();
+    ~Roadmap();
+    void build(map_s map, unsigned long map_hash, float clearance); // starts building in the background, drops any build in progress
+    bool ready(unsigned long map_hash);             // true if a roadmap for this map is finished
+    bool query(NED_s ps, NED_s pe, float clearance, unsigned long map_hash, std::vector<NED_s>* path);
+    void setNumNodes(unsigned int num_nodes);       // 0 turns the roadmap off
+    void setConnectionRadius(float radius);
+    void setConfig(planner_config_s config);        // before the first build, the edges are checked with it
+    unsigned int numNodes();
+    bool pack(std::vector<char>* blob);             // for a compiled map, false until the roadmap is ready
+    bool load(const char* data, size_t size, map_s map, unsigned long map_hash, float clearance);
+
+  private:
+    void buildThread(map_s map, unsigned long map_hash, float clearance);
+    void stop();
+    NED_s halton(unsigned int k);
+    std::vector<unsigned int> connect(NED_s p, float clearance, unsigned int max_connections);
+    bool search(unsigned int start, unsigned int goal, std::vector<unsigned int>* node_path);
+
+    std::thread build_thread_;
+    std::atomic<bool> cancel_;                      // set when a build should stop early
+    std::mutex mutex_;                              // guards everything below
+    bool ready_;
+    unsigned long map_hash_;                        // hash of the map the roadmap was built for
+    CollisionDetection col_det_;
+    planner_config_s config_;
+    float D_;                                       // altitude that the edges were checked at
+    std::vector<NED_s> nodes_;
+    std::vector<std::vector<roadmap_edge_s> > edges_;
+    unsigned int num_nodes_;
+    float radius_;
+  };
+} // end namespace theseus
+#endif
@@ -0,0 +1,39 @@
+/*	DESCRIPTION:
+ *	This is a header for the nodes that sends the messages of the planner
+ *	(theseus_core, log.h) to rosconsole, and sets the level of both to the
+ *	one the planner is configured with (pp/console_level).
+ *
+ */
+#ifndef ROS_LOG_H
+#define ROS_LOG_H
+
+#include <ros/console.h>
+
+#include <theseus/log.h>
+
+namespace theseus
+{
+  inline void logToRosconsole(int level)
+  {
+    if (level >= LOG_LEVEL_DEBUG && level <= LOG_LEVEL_FATAL)
+    {
+      setLogLevel(level);
+      if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, (ros::console::levels::Level) level))
+        ros::console::notifyLoggerLevelsChanged();
+    }
+    setLogSink([](int level, const char* message)
+    {
+      if (level <= LOG_LEVEL_DEBUG)
+        ROS_DEBUG("%s", message);
+      else if (level == LOG_LEVEL_INFO)
+        ROS_INFO("%s", message);
+      else if (level == LOG_LEVEL_WARN)
+        ROS_WARN("%s", message);
+      else if (level == LOG_LEVEL_ERROR)
+        ROS_ERROR("%s", message);
+      else
+        ROS_FATAL("%s", message);
+    });
+  }
+} // end namespace theseus
+#endif
@@ -2,6 +2,8 @@
 #define RRT_PLOTTTER
 
 #include <vector>
+#include <deque>
+#include <mutex>
 #include <math.h>
 #include <ros/ros.h>
 
@@ -9,30 +11,21 @@
 #include <theseus/fillet_s.h>
 #include <theseus/node_s.h>
 #include <theseus/param_reader.h>
+#include <theseus/odom_trail.h>
+#include <theseus/viz_sink.h>
 
 #include <visualization_msgs/Marker.h>
+#include <visualization_msgs/MarkerArray.h>
 
 namespace theseus
 {
-struct rrtColors
+struct tessellation_s
 {
-  NED_s gray;
-  NED_s blue;
-  NED_s green;
-  NED_s orange;
-  NED_s purple;
-  NED_s red;
-  rrtColors()
-  {
-    gray.N = 0.5f;   gray.E = 0.5f;    gray.D = 0.5f;
-    blue.N = 0.0f;   blue.E = 1.0f;    blue.D = 1.0f;
-    green.N = 0.0f;  green.E = 1.0f;   green.D = 0.0f;
-    orange.N = 1.0f; orange.E = 0.55f; orange.D = 0.0f;
-    purple.N = 0.5f; purple.E = 0.0f;  purple.D = 0.5f;
-    red.N = 1.0f;    red.E = 0.0f;     red.D = 0.0f;
-  }
+  unsigned int version;                       // path_version_ when the path was drawn
+  int id;                                     // marker id it was drawn with, a redraw replaces that marker
+  std::vector<geometry_msgs::Point> points;   // the flown path with every fillet drawn as an arc, in rviz coordinates
 };
-class rrtPlotter
+class rrtPlotter : public VizSink
 {
 public:
 	// Functions
@@ -46,36 +39,59 @@ public:
   void odomCallback(geometry_msgs::Point p);
   void mobsCallback(std::vector<NED_s> mobs_in, std::vector<float> radius);
   void displayPath(std::vector<node*> path, NED_s color, float width);
-  void displayPath(std::vector<NED_s> path, NED_s color, float width);
+  virtual void displayPath(std::vector<NED_s> path, NED_s color, float width);
   void displayPath(NED_s ps, std::vector<NED_s> path, NED_s color, float width);
   void displayPath(NED_s ps, std::vector<node*> path, NED_s color, float width);
   void drawCircle(NED_s cp, float r);
-  void clearRViz(map_s map);
+  virtual void clearRViz(map_s map);
   void clearRViz(map_s map, std::vector<NED_s> path, NED_s color, float width);
   void displayTree(node* root);
+  virtual void addTreeEdge(NED_s from, NED_s to); // queued until the next tree chunk is published
+  virtual void publishTree(bool now);     // sends the queued edges as one chunk, unless the last one went out too recently and now is false
   void displayBoundaries(map_s map);
   void pingBoundaries();
   void pingPath();
+  void publishScene();                    // sends the whole map scene again
   void addFinalPath(NED_s ps, std::vector<NED_s> stuff_in);
+  unsigned int pathVersion();             // version of the last path displayPath or addFinalPath drew
+  bool redrawPath(unsigned int version, NED_s color, float width); // false once that path has left the cache
 
 private:
+  std::recursive_mutex mutex_;            // taken by every public function (they call each other), the ROS callbacks draw from other threads than the planner
   ros::NodeHandle nh_;
   ros::Publisher marker_pub_;
   ros::Publisher ground_pub_;
+  ros::Publisher scene_pub_;              // latched, the map layers as one MarkerArray so late subscribers still get them
+  ros::Publisher ground_scene_pub_;
+  ros::Publisher trail_pub_;              // latched, the history of the odometry trail
+  ros::Publisher array_pub_;              // layers that change often (moving obstacles, loiter circle)
+  ros::Publisher ground_array_pub_;
+  visualization_msgs::MarkerArray scene_;         // everything that is on scene_pub_
+  visualization_msgs::MarkerArray ground_scene_;  // everything that is on ground_scene_pub_
+  unsigned int num_mobs_;                 // moving obstacles in the last update, the ones that are gone get deleted
   visualization_msgs::Marker odom_mkr_;
+  OdomTrail odom_trail_;
   visualization_msgs::Marker mobs_mkr_;
   visualization_msgs::Marker planned_path_mkr_;
   int path_id_;
   int pWPS_id_;
   ParamReader input_file_;
-  std::vector<node*> fringe_;
-  std::vector<NED_s> tree_path_;
+  visualization_msgs::Marker tree_mkr_;   // LINE_LIST of the tree edges that haven't been published yet
+  int tree_chunk_;                        // id of the next tree chunk, every chunk stays up until the display is cleared
+  double tree_period_;                    // shortest time between two tree chunks (s)
+  ros::WallTime last_tree_chunk_;
   rrtColors clr;
   visualization_msgs::Marker bds_mkr_;
 
-  std::vector<std::vector<float > > arc(float N, float E, float r, float aS, float aE);
-  void addFringe(node* nin);
-  void addTreePath(node* root, node* nin);
+  std::deque<tessellation_s> tessellations_; // most recently drawn paths first
+  unsigned int path_version_;             // bumped for every path displayPath and addFinalPath are given
+  float arc_tolerance_;                   // largest gap between a drawn arc and the real one (m)
+  float view_scale_;                      // metres a pixel of the view covers, gaps under half a pixel don't show
+  void tessellate(unsigned int version, const std::vector<NED_s>& path, std::vector<geometry_msgs::Point>* points);
+  void publishPath(unsigned int version, const std::vector<NED_s>& path, NED_s color, float width);
+  void appendArc(std::vector<geometry_msgs::Point>* points, NED_s c, float r, float a_start, float sweep);
+  void addTreeEdges(node* nin);
+  void putInScene(visualization_msgs::MarkerArray* scene, std::vector<visualization_msgs::Marker> layer);
 
 };
 }
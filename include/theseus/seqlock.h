@@ -0,0 +1,68 @@
+/*	DESCRIPTION:
+ *	This is a header for the SeqLock class. It holds one copy of a small,
+ *	trivially copyable struct that a single thread writes and any number of
+ *	threads read without locks. A reader retries if the writer was in the
+ *	middle of a write, so it always gets a consistent copy and the writer is
+ *	never held up by the readers.
+ *
+ *	The value is kept in atomic words so the copy in and out isn't a data race.
+ *
+ */
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+namespace theseus
+{
+  template <typename T> class SeqLock
+  {
+  public:
+    SeqLock() : seq_(0)
+    {
+      for (unsigned int j = 0; j < num_words_; j++)
+        words_[j].store(0, std::memory_order_relaxed);
+    }
+    void write(const T& value)           // only one thread may write
+    {
+      uint64_t words[num_words_];
+      memset(words, 0, sizeof(words));
+      memcpy(words, &value, sizeof(T));
+      unsigned int seq = seq_.load(std::memory_order_relaxed);
+      seq_.store(seq + 1, std::memory_order_relaxed); // odd while writing
+      std::atomic_thread_fence(std::memory_order_release);
+      for (unsigned int j = 0; j < num_words_; j++)
+        words_[j].store(words[j], std::memory_order_relaxed);
+      seq_.store(seq + 2, std::memory_order_release);
+    }
+    T read() const
+    {
+      uint64_t words[num_words_];
+      unsigned int seq_start, seq_end;
+      do
+      {
+        seq_start = seq_.load(std::memory_order_acquire);
+        for (unsigned int j = 0; j < num_words_; j++)
+          words[j] = words_[j].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = seq_.load(std::memory_order_relaxed);
+      }
+      while ((seq_start & 1) || seq_start != seq_end);
+      T value;
+      memcpy(&value, words, sizeof(T));
+      return value;
+    }
+    unsigned int version() const          // goes up by 2 with every write
+    {
+      return seq_.load(std::memory_order_acquire);
+    }
+
+  private:
+    static const unsigned int num_words_ = (sizeof(T) + sizeof(uint64_t) - 1)/sizeof(uint64_t);
+    std::atomic<unsigned int> seq_;
+    std::atomic<uint64_t> words_[num_words_];
+  };
+} // end namespace theseus
+#endif
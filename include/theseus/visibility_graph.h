@@ -0,0 +1,52 @@
+/*	DESCRIPTION:
+ *	This is a header for the VisibilityGraph class. It solves the 2D part of
+ *	the problem: the shortest path around the cylinders (inflated by the
+ *	clearance) inside the boundary polygon. Each inflated cylinder is replaced
+ *	by a circumscribed polygon, so the edges around a cylinder are tangent to
+ *	it. The concave corners of the boundary are the only other vertices.
+ *	The path it returns is meant to seed the RRT, it doesn't know about
+ *	altitude, climb angles or fillets.
+ *
+ */
+#ifndef VISIBILITY_GRAPH_H
+#define VISIBILITY_GRAPH_H
+
+#include <vector>
+#include <math.h>
+
+#include <theseus/map_s.h>
+#include <theseus/map_artifact.h>
+
+namespace theseus
+{
+  class VisibilityGraph
+  {
+  public:
+    VisibilityGraph();
+    ~VisibilityGraph();
+    void build(map_s map, float clearance);
+    bool query(NED_s ps, NED_s pe, std::vector<NED_s>* path);  // fills the points between ps and pe, D is set along a constant slope
+    void setNumSides(unsigned int num_sides);
+    bool pack(std::vector<char>* blob);                       // for a compiled map
+    bool load(const char* data, size_t size, map_s map, float clearance);
+
+  private:
+    void setMap(map_s map, float clearance);
+    bool pointClear(NED_s p);
+    bool segmentClear(NED_s a, NED_s b);
+    float pointToSegment(NED_s p, NED_s a, NED_s b);
+    bool segmentsCross(NED_s a, NED_s b, NED_s c, NED_s d);
+    void mergeCorners(NED_s ps, NED_s pe, std::vector<unsigned int>* node_path, std::vector<NED_s>* points);
+
+    std::vector<NED_s> boundary_;
+    std::vector<NED_s> centers_;                  // cylinder centers
+    std::vector<float> radii_;                    // inflated radius of each cylinder
+    std::vector<NED_s> vertices_;
+    std::vector<int> vertex_cyl_;                 // cylinder each vertex goes around, -1 for boundary corners
+    std::vector<std::vector<unsigned int> > visible_;
+    float clearance_;
+    unsigned int num_sides_;
+    bool built_;
+  };
+} // end namespace theseus
+#endif
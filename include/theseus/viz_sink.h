@@ -0,0 +1,52 @@
+/*	DESCRIPTION:
+ *	The interface the planner draws through while it is animating. The ROS
+ *	nodes hand RRT an rrtPlotter, a planner without one (batch runs, other
+ *	threads) draws nothing.
+ *
+ */
+#ifndef VIZ_SINK_H
+#define VIZ_SINK_H
+
+#include <vector>
+
+#include <theseus/map_s.h>
+#include <theseus/node_s.h>
+
+namespace theseus
+{
+struct rrtColors
+{
+  NED_s gray;
+  NED_s blue;
+  NED_s green;
+  NED_s orange;
+  NED_s purple;
+  NED_s red;
+  rrtColors()
+  {
+    gray.N = 0.5f;   gray.E = 0.5f;    gray.D = 0.5f;
+    blue.N = 0.0f;   blue.E = 1.0f;    blue.D = 1.0f;
+    green.N = 0.0f;  green.E = 1.0f;   green.D = 0.0f;
+    orange.N = 1.0f; orange.E = 0.55f; orange.D = 0.0f;
+    purple.N = 0.5f; purple.E = 0.0f;  purple.D = 0.5f;
+    red.N = 1.0f;    red.E = 0.0f;     red.D = 0.0f;
+  }
+};
+class VizSink
+{
+public:
+  virtual ~VizSink() {}
+  virtual void displayPath(std::vector<NED_s> path, NED_s color, float width) = 0;
+  virtual void addTreeEdge(NED_s from, NED_s to) = 0; // queued until publishTree
+  virtual void publishTree(bool now) = 0;             // may hold the edges back if the last ones went out too recently, unless now
+  virtual void clearRViz(map_s map) = 0;              // everything but the map
+  void displayPath(std::vector<node*> path, NED_s color, float width)
+  {
+    std::vector<NED_s> points;
+    for (unsigned int i = 0; i < path.size(); i++)
+      points.push_back(path[i]->p);
+    displayPath(points, color, width);
+  }
+};
+}// end namespace theseus
+#endif // VIZ_SINK_H
@@ -2,15 +2,24 @@
 
 namespace theseus
 {
-RRT::RRT(map_s map_in, unsigned int seed) :
-  nh_(ros::NodeHandle())// Setup the object
+RRT::RRT(map_s map_in, unsigned int seed, planner_config_s config) :
+  col_det_(config),
+  input_file_(config)             // Setup the object
 {
   map_            = map_in;
   col_det_.newMap(map_in);
   setup();
+  if (use_vis_graph_)
+    vis_graph_.build(map_, input_file_.clearance);
   RandGen rg_in(seed);            // Make a random generator object that is seeded
   rg_             = rg_in;        // Copy that random generator into the class.
 }
+RRT::RRT(planner_config_s config) :
+  col_det_(config),
+  input_file_(config)
+{
+  setup();
+}
 RRT::RRT()
 {
   setup();
@@ -23,29 +32,39 @@ void RRT::setup()
   landing_priority_       = 4;
   loitering_priority_     = 3;
   initial_map_time_       = 1.0f;
-  tree_display_time_      = 0.04f;
   smoothing_display_time_ = 0.1f;
   smoothed_display_time_  = 1.0f;
-  if(ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Debug))
-  {
-   ros::console::notifyLoggerLevelsChanged();
-  }
-  nh_.param<float>("pp/segment_length", segment_length_, 100.0);
+  if (input_file_.event_ring_size > 0)
+    events_ = std::make_shared<EventRing>(input_file_.event_ring_size);
+  segment_length_        = input_file_.segment_length;
+  reuse_trees_           = input_file_.reuse_trees;
+  leg_cache_.setSize(input_file_.leg_cache_size > 0 ? input_file_.leg_cache_size : 0);
+  roadmap_               = NULL;
+  progress_              = NULL;
+  viz_                   = NULL;
+  trace_                 = NULL;
+  most_recent_node_      = NULL;
+  use_vis_graph_         = input_file_.visibility_graph;
+  pipeline_smoothing_    = input_file_.pipeline_smoothing;
+  speculative_legs_      = input_file_.speculative_legs > 0 ? input_file_.speculative_legs : 0;
+  speculation_tolerance_ = input_file_.speculation_tolerance;
   num_paths_      = 1;            // number of paths to solve between each waypoint use 1 for now, not sure if more than 1 works, memory leaks..
-  RandGen rg_in(1);               // Make a random generator object that is seeded
+  RandGen rg_in(1, true);         // Make a random generator object that is seeded, without reseeding everyone else's
   rg_             = rg_in;        // Copy that random generator into the class.
   ending_chi_     = 0.0f;
   loiter_mission_ = false;
 }
 RRT::~RRT()
 {
+  stopSpeculation();
 	deleteTree();                          // Delete all of those tree pointer nodes
 	std::vector<node*>().swap(root_ptrs_); // Free the memory of the vector.
 }
 bool RRT::solveStatic(NED_s pos, float chi0, bool direct_hit, bool landing, bool drop_bomb, bool loiter_mission)         // This function solves for a path in between the waypoinnts (2 Dimensional)
 {
-  nh_.param<float>("pp/comfortable_altitude", comfortable_altitude_, 40.0f);
-  nh_.param<float>("pp/chi_take_off", chi_take_off_, -1000.0f);
+  ScopedPhase solve_phase(trace_, "solveStatic");
+  comfortable_altitude_ = input_file_.comfortable_altitude;
+  chi_take_off_         = input_file_.chi_take_off;
   if (chi_take_off_ > -100.0)
   {
     while (chi_take_off_ < 0.0)
@@ -57,23 +76,26 @@ bool RRT::solveStatic(NED_s pos, float chi0, bool direct_hit, bool landing, bool
   loiter_mission_ = loiter_mission;
   if (loiter_mission_)
   {
-    float alt;
-    nh_.param<float>("pp/loiter_serch_alt", alt, 50.0);
-    map_.wps[0].D = -alt;
+    ScopedPhase phase(trace_, "loiter setup");
+    map_.wps[0].D = -input_file_.loiter_serch_alt;
     NED_s lp;
     lp = findCloseLoiterSpot(map_.wps[0], input_file_.loiter_radius);
     map_.wps[0] = lp;
+    event(EV_LOITER_SPOT, lp.N, lp.E, lp.D);
   }
   dropping_bomb_ = drop_bomb;
-  if (animating_) {ros::Duration(initial_map_time_).sleep();}
+  if (animating_ && viz_ != NULL) {pause(initial_map_time_);}
   if (dropping_bomb_)
+  {
+    ScopedPhase phase(trace_, "bomb setup");
     setupBombWps();
+  }
   bool last_wp_safe_to_loiter = true;
   secondary_wps_indx_ = map_.wps.size();
-  ROS_WARN("secondary_wps_indx_ = %i", secondary_wps_indx_);
   bool add_loiter_point = true;
   if (landing == false && add_loiter_point == true)
   {
+    ScopedPhase phase(trace_, "loiter setup");
     NED_s final_wp;
     col_det_.taking_off_ = false;
     if (map_.wps.size() > 0)
@@ -85,126 +107,190 @@ bool RRT::solveStatic(NED_s pos, float chi0, bool direct_hit, bool landing, bool
       last_wp_safe_to_loiter = false;
       map_.wps.push_back(final_wp);
     }
+    event(EV_LOITER_SPOT, final_wp.N, final_wp.E, final_wp.D);
   }
 
   std::vector<NED_s> all_rough_paths;
 
   direct_hit_      = direct_hit;
   path_clearance_  = input_file_.clearance;
-  ROS_INFO("Starting RRT solver");
-  ROS_DEBUG("initial chi %f", chi0);
+  THESEUS_INFO("Starting RRT solver");
+  event(EV_SOLVE_START, pos.N, pos.E, pos.D, chi0);
   clearForNewPath();
 	initializeTree(pos, chi0);
   all_rough_paths.push_back(root_ptrs_[0]->p);
   taking_off_ = (-pos.D < input_file_.minFlyHeight + input_file_.clearance);
   col_det_.taking_off_ = taking_off_;
-  if (taking_off_) {ROS_DEBUG("taking_off_ on initial set is true");}
-  else {ROS_DEBUG("taking_off_ on initial set is false");}
+  event(EV_SOLVE_SETUP, secondary_wps_indx_, map_.wps.size(), taking_off_);
   printRRTSetup(pos, chi0);
   if (root_ptrs_[0]->dontConnect)
   {
+    ScopedPhase phase(trace_, "take-off fan");
     bool created_initial_fan = createFan(root_ptrs_[0],root_ptrs_[0]->p, chi0, path_clearance_);
-    if (created_initial_fan)
-      ROS_DEBUG("created initial fan");
-    else
+    event(EV_FAN, 0, created_initial_fan);
+    if (created_initial_fan == false)
     {
-      ROS_ERROR("Creating Initial Fan FAILED");
+      THESEUS_ERROR("Creating Initial Fan FAILED");
       root_ptrs_[0]->dontConnect = false;
     }
   }
   if (col_det_.checkPoint(root_ptrs_[0]->p, 1.0f) == false)
   {
-    ROS_FATAL("Initial position violates an obstacle or boundary");
+    THESEUS_FATAL("Initial position violates an obstacle or boundary");
+    reportFailure(0);
     return false;
   }
   long unsigned int iters_left = input_file_.iters_limit;
+  unsigned long map_hash = LegCache::hashMap(map_);
+  if (speculative_legs_ > 0 && landing == false)
+    startSpeculation(pos, map_hash);
+  if (progress_ != NULL)
+  {
+    progress_->total_nodes = 0;
+    progress_->smooth_us   = 0;
+  }
+  // Leg i - 1 can still be smoothing while leg i grows, it is finished before leg i is added. Leg i grows from
+  // the rough approach into waypoint i, what it changed is kept to grow it again if the smoother moves that.
+  std::future<std::vector<node*> > smoothing;
+  std::vector<node*> smoothing_rough_path;
+  leg_key_s smoothing_key;
+  node* smoothing_approach = NULL;
+  node grown_root;
+  rand_mark_s grown_mark;
+  long unsigned int grown_iters   = 0;
+  unsigned long grown_total_nodes = 0;
+  float grown_clearance           = path_clearance_;
   for (unsigned int i = 0; i < map_.wps.size(); i++)
   {
+    ScopedPhase leg_phase(trace_, "leg");
+    if (progress_ != NULL)
+    {
+      progress_->leg      = i;
+      progress_->num_legs = map_.wps.size();
+      progress_->nodes    = 0;
+    }
+    if (cancelled())
+    {
+      stopSpeculation();
+      event(EV_SOLVE_CANCELLED, i);
+      return false;
+    }
     landing_now_ = landing;
-    col_det_.landing_now_ = landing_now_;
-    if (i > 0 && taking_off_ == false && direct_hit_ == true)
+    if (col_det_.landing_now_ != landing_now_) // the smoother may be reading it
+      col_det_.landing_now_ = landing_now_;
+    if (smoothing.valid())
     {
-      ROS_DEBUG("creating fan from solveStatic");
-      createFan(root_ptrs_[i],root_ptrs_[i]->p, (root_ptrs_[i]->p - root_ptrs_[i]->parent->p).getChi(), path_clearance_);
+      grown_root        = *root_ptrs_[i];
+      grown_mark        = rg_.mark();
+      grown_iters       = iters_left;
+      grown_clearance   = path_clearance_;  // the fan is still made with the clearance of the last leg
+      grown_total_nodes = progress_ == NULL ? 0 : progress_->total_nodes.load();
     }
-    else
+    if (i > 0 && taking_off_ == false && direct_hit_ == true)
     {
-      ROS_DEBUG("no fan");
-      ROS_DEBUG("i = %i", i);
-      ROS_DEBUG("taking_off_ = %i", taking_off_);
-      ROS_DEBUG("direct_hit_ = %i", direct_hit_);
+      ScopedPhase phase(trace_, "fan");
+      bool created_fan = createFan(root_ptrs_[i],root_ptrs_[i]->p, (root_ptrs_[i]->p - root_ptrs_[i]->parent->p).getChi(), path_clearance_);
+      event(EV_FAN, i, created_fan);
+      if (created_fan == false)
+        root_ptrs_[i]->dontConnect = false; // like the first fan, the leg can still leave from the waypoint itself
     }
-    ROS_INFO("Finding route to waypoint %lu", i + (long unsigned int) 1);
+    event(EV_LEG_START, i, map_.wps[i].N, map_.wps[i].E, map_.wps[i].D);
     path_clearance_        = input_file_.clearance;
-    bool direct_connection = tryDirectConnect(root_ptrs_[i], root_ptrs_[i + 1], i);
-    if (dropping_bomb_ && (i == 1 || i == 2) && direct_connection == false)
+    leg_key_s leg_key      = legKey(i, chi0, map_hash);
+    leg_s cached_leg;
+    bool leg_cached        = leg_cache_.find(leg_key, &cached_leg);
+    if (leg_cached && direct_hit_ == false && smooth_rts_[i]->parent != NULL && fitJunction(i, &cached_leg) == false)
+    {
+      // The previous leg can come into the turn at waypoint i differently than the one the cached leg was planned
+      // after. A direct hit goes straight through along the heading in the key, there is no turn to fit.
+      event(EV_CACHE_MISFIT, i);
+      leg_cached = false;
+    }
+    if (leg_cached)
+      event(EV_LEG_CACHED, i);
+    else if (takeSpeculation(i, leg_key, &cached_leg))
     {
-      ROS_ERROR("Bomb drop line failed, pushing anyway");
-      root_ptrs_[i]->cost        = root_ptrs_[i]->cost + (root_ptrs_[i + 1]->p - root_ptrs_[i]->p).norm();
-      root_ptrs_[i]->connects2wp = true;
-      root_ptrs_[i]->children.push_back(root_ptrs_[i + 1]);
-      most_recent_node_          = root_ptrs_[i + 1];
-      direct_connection = true;
+      event(EV_LEG_SPECULATED, i);
+      leg_cache_.add(cached_leg);
+      leg_cached = true;
     }
-    ROS_INFO("trying to connect to N %f, E %f, D %f", root_ptrs_[i + 1]->p.N, root_ptrs_[i + 1]->p.E, root_ptrs_[i + 1]->p.D);
-    if (direct_connection == false)
+    bool grown = leg_cached || growLeg(i, map_hash, &iters_left);
+    if (smoothing.valid())
     {
-      int num_found_paths = 0;
-      long unsigned int added_nodes = 0;
-      ROS_INFO("Developing the tree");
-      while (num_found_paths < num_paths_)
+      std::vector<node*> smoothed = smoothing.get();
+      node* rough_approach = root_ptrs_[i]->parent;
+      bool moved = smoothing_approach != NULL && (smoothing_approach->p != rough_approach->p ||
+                   (smoothing_approach->parent == NULL) != (rough_approach->parent == NULL));
+      if (smoothing_approach != NULL)
+        resetParent(root_ptrs_[i], smoothing_approach);
+      finishLeg(i - 1, smoothing_rough_path, smoothed, smoothing_key, false, &all_rough_paths);
+      if (moved && cancelled() == false)
       {
-        num_found_paths += developTree(i);
-        added_nodes++;
-        if (added_nodes%50 == 0)
-          ROS_INFO("number of nodes %lu, %i", added_nodes, input_file_.iters_limit);
-        if ((float) added_nodes > iters_left/2.0f)
-        {
-          path_clearance_  = path_clearance_/2.0f;
-          iters_left  = iters_left/2.0f;
-          ROS_WARN("decreasing the clearance level to %f", path_clearance_);
-        }
-        if (added_nodes > input_file_.iters_limit)
-        {
-          ROS_FATAL("ADDED TOO MANY NODES");
-          return false;
-        }
+        // Sequential smoothing would have grown leg i from the new approach, so it is grown again from there.
+        event(EV_APPROACH_MOVED, i);
+        pruneLeg(i, grown_root.children.size());
+        root_ptrs_[i]->cost        = grown_root.cost;
+        root_ptrs_[i]->dontConnect = grown_root.dontConnect;
+        root_ptrs_[i]->connects2wp = grown_root.connects2wp;
+        rg_.rewind(grown_mark);
+        iters_left      = grown_iters;
+        path_clearance_ = grown_clearance;
+        if (progress_ != NULL)
+          progress_->total_nodes = grown_total_nodes;
+        i--;
+        continue;
       }
     }
+    if (grown == false)
+    {
+      stopSpeculation();
+      if (cancelled())
+        event(EV_SOLVE_CANCELLED, i);
+      else
+        reportFailure(i);
+      return false;
+    }
+    if (leg_cached == false)
+      leg_key.clearance = path_clearance_;  // a leg that had to shrink it is only found again at that clearance
     // plotting the waypoint sequences
-    std::vector<node*> rough_path  = findMinimumPath(i);
-    // plt.displayPath(rough_path, clr.blue, 13.0f);
-
-    std::vector<node*> smooth_path = smoothPath(rough_path, i);
-    addPath(smooth_path, i);
-    if (taking_off_ == true && -all_wps_.back().D > input_file_.minFlyHeight)
+    std::vector<node*> rough_path;
+    std::vector<node*> smooth_path;
+    if (leg_cached)
+      smooth_path = unpackLeg(cached_leg, i);
+    else
     {
-      taking_off_ = false;
-      col_det_.taking_off_ = false;
-      ROS_INFO("taking off is false");
+      rough_path  = findMinimumPath(i);
+      event(EV_MIN_PATH, i, rough_path.size());
+      // plt.displayPath(rough_path, clr.blue, 13.0f);
+      // The next leg only needs the node before the waypoint, it grows from the rough one while this leg smooths.
+      // Not while taking off ends on this leg, col_det_ would change under the smoother, nor when the next leg
+      // was planned ahead, fitJunction needs the smoothed approach. A leg that has to be grown again draws the same
+      // numbers again, which the shared rand() sequence can't do.
+      bool stops_taking_off = taking_off_ && -root_ptrs_[i + 1]->p.D > input_file_.minFlyHeight;
+      bool planned_ahead    = i + 1 < speculations_.size() && speculations_[i + 1].valid();
+      if (pipeline_smoothing_ && rg_.ownStream() && i + 1 < map_.wps.size() && landing_now_ == false && stops_taking_off == false && planned_ahead == false)
+      {
+        smoothing_rough_path = rough_path;
+        smoothing_key        = leg_key;
+        smoothing_approach   = NULL;
+        smoothing = std::async(std::launch::async, &RRT::smoothPath, this, rough_path, (int) i, path_clearance_, &smoothing_approach);
+        continue;
+      }
+      smooth_path = smoothPath(rough_path, i, path_clearance_);
     }
-    for (int it = 1; it < rough_path.size(); it++)
-      all_rough_paths.push_back(rough_path[it]->p);
-    // if (animating_) {plt.displayPath(rough_path, clr.blue, 6.0f);}
-    // if (false) {plt.displayTree(root_ptrs_[i]);}
-    if (animating_) {plt.clearRViz(map_);}
+    finishLeg(i, rough_path, smooth_path, leg_key, leg_cached, &all_rough_paths);
     if (landing_now_)
       break;
-    if (landing_now_ == false && i < secondary_wps_indx_)
-    {
-      ending_point_ = all_wps_.back();
-      ending_chi_   = (all_wps_.back() - all_wps_[all_wps_.size() - 2]).getChi();
-    }
   }
   if (landing_now_)
   {
     for (int j = 1; j < map_.wps.size(); j++)
     {
-      // ROS_DEBUG("pushing back another waypoint");
+      // THESEUS_DEBUG("pushing back another waypoint");
       all_wps_.push_back(map_.wps[j]);
       all_priorities_.push_back(landing_priority_);
       all_drop_bombs_.push_back(false);
-      // ROS_DEBUG("N: %f, E: %f, D: %f", all_wps_.back().N, all_wps_.back().E, all_wps_.back().D);
+      // THESEUS_DEBUG("N: %f, E: %f, D: %f", all_wps_.back().N, all_wps_.back().E, all_wps_.back().D);
       all_rough_paths.push_back(map_.wps[j]);
     }
     ending_point_ = all_wps_.back();
@@ -214,50 +300,287 @@ bool RRT::solveStatic(NED_s pos, float chi0, bool direct_hit, bool landing, bool
     map_.wps.pop_back();
 
   // for (int i = 0; i < map_.wps.size(); i++)
-  //   ROS_DEBUG("WP %i: %f, %f, %f", i, map_.wps[i].N, map_.wps[i].E, map_.wps[i].D);
+  //   THESEUS_DEBUG("WP %i: %f, %f, %f", i, map_.wps[i].N, map_.wps[i].E, map_.wps[i].D);
 
   // plt.clearRViz(map_);
   // plt.displayPath(all_rough_paths, clr.blue, 10.0f);
-  ROS_INFO("FINISHED THE RRT ALGORITHM");
+  stopSpeculation();
+  event(EV_SOLVE_DONE, all_wps_.size());
+  THESEUS_INFO("FINISHED THE RRT ALGORITHM");
   // sleep(15.0);
   return true;
 }
 
+bool RRT::growLeg(unsigned int i, unsigned long map_hash, long unsigned int* iters_left)
+{
+  ScopedPhase phase(trace_, "growLeg");
+  bool direct_connection = tryDirectConnect(root_ptrs_[i], root_ptrs_[i + 1], i);
+  if (dropping_bomb_ && (i == 1 || i == 2) && direct_connection == false)
+  {
+    THESEUS_ERROR("Bomb drop line failed, pushing anyway");
+    root_ptrs_[i]->cost        = root_ptrs_[i]->cost + (root_ptrs_[i + 1]->p - root_ptrs_[i]->p).norm();
+    root_ptrs_[i]->connects2wp = true;
+    root_ptrs_[i]->children.push_back(root_ptrs_[i + 1]);
+    most_recent_node_          = root_ptrs_[i + 1];
+    direct_connection = true;
+  }
+  if (direct_connection)
+    event(EV_DIRECT, i);
+  else
+  {
+    int num_found_paths = 0;
+    long unsigned int added_nodes = 0;
+    // Seed paths leave from the fan if there is one, that's where the tree is allowed to leave from.
+    node* seed_start = root_ptrs_[i];
+    if (seed_start->dontConnect && seed_start->children.size() > 0)
+      seed_start = findClosestNodeGChild(seed_start, root_ptrs_[i + 1]->p);
+    std::vector<NED_s> seed;
+    if (use_vis_graph_ && vis_graph_.query(seed_start->p, root_ptrs_[i + 1]->p, &seed))
+    {
+      num_found_paths = trySeedPath(seed_start, seed, i);
+      if (num_found_paths > 0)
+        event(EV_VIS_GRAPH, i);
+    }
+    if (reuse_trees_ && num_found_paths < num_paths_)
+    {
+      long unsigned int reused_nodes = 0;
+      num_found_paths = reuseTree(i, &reused_nodes);
+      event(EV_REUSED, i, reused_nodes, num_found_paths);
+    }
+    if (roadmap_ != NULL && num_found_paths < num_paths_ && roadmap_->query(seed_start->p, root_ptrs_[i + 1]->p, path_clearance_, map_hash, &seed))
+    {
+      num_found_paths = trySeedPath(seed_start, seed, i);
+      if (num_found_paths > 0)
+        event(EV_ROADMAP, i);
+    }
+    while (num_found_paths < num_paths_)
+    {
+      num_found_paths += developTree(i);
+      added_nodes++;
+      if (progress_ != NULL)
+      {
+        progress_->nodes = added_nodes;
+        progress_->total_nodes++;
+      }
+      if (cancelled())
+        return false;
+      if (added_nodes%50 == 0)
+        event(EV_NODES, i, added_nodes, input_file_.iters_limit);
+      if ((float) added_nodes > *iters_left*input_file_.clearance_patience)
+      {
+        path_clearance_  = path_clearance_*input_file_.clearance_shrink;
+        *iters_left = *iters_left*input_file_.clearance_patience;
+        event(EV_CLEARANCE, i, path_clearance_, added_nodes);
+      }
+      if (added_nodes > (long unsigned int) input_file_.iters_limit)
+      {
+        THESEUS_FATAL("ADDED TOO MANY NODES");
+        event(EV_TOO_MANY_NODES, i, added_nodes);
+        return false;
+      }
+    }
+    if (added_nodes > 0)
+      event(EV_CONNECTED, i, added_nodes);
+  }
+  return true;
+}
+void RRT::startSpeculation(NED_s pos, unsigned long map_hash)
+{
+  // Leg i only depends on leg i - 1 through the heading it reaches waypoint i with. The legs after the first are
+  // started on planners of their own with the heading of the last visibility graph segment into their waypoint.
+  unsigned int num_legs = map_.wps.size();
+  speculations_.resize(num_legs);
+  speculation_done_.assign(num_legs, 0);
+  speculation_keys_.resize(num_legs);
+  speculated_legs_.resize(num_legs);
+  for (unsigned int i = 1; i < num_legs && i <= speculative_legs_; i++)
+  {
+    if (speculators_.size() < i)
+    {
+      speculators_.push_back(std::make_shared<RRT>(input_file_));
+      speculation_progress_.push_back(std::make_shared<rrt_progress_s>());
+    }
+    RRT* speculator = speculators_[i - 1].get();
+    speculator->map_               = map_;
+    speculator->col_det_           = col_det_;
+    speculator->col_det_.taking_off_  = false;
+    speculator->col_det_.landing_now_ = false;
+    speculator->vis_graph_         = vis_graph_;
+    speculator->use_vis_graph_     = use_vis_graph_;
+    speculator->animating_         = false;
+    speculator->trace_             = trace_;
+    speculator->events_            = events_;
+    speculator->reuse_trees_       = false;
+    speculator->direct_hit_        = direct_hit_;
+    speculator->dropping_bomb_     = dropping_bomb_;
+    speculator->landing_now_       = false;
+    speculator->taking_off_        = false;
+    speculator->path_clearance_    = input_file_.clearance;
+    speculator->rg_                = RandGen(input_file_.seed + i, true);
+    speculator->progress_          = speculation_progress_[i - 1].get();
+    speculator->progress_->cancel  = false;
+
+    NED_s approach = root_ptrs_[i - 1]->p;
+    std::vector<NED_s> seed;
+    if (use_vis_graph_ && vis_graph_.query(root_ptrs_[i - 1]->p, root_ptrs_[i]->p, &seed) && seed.size() > 0)
+      approach = seed.back();
+    // root i has no parent yet, so the key takes the predicted heading as it is
+    speculation_keys_[i]        = legKey(i, (root_ptrs_[i]->p - approach).getChi(), map_hash);
+    speculation_keys_[i].flags &= ~(LEG_TAKING_OFF | LEG_LANDING);
+    leg_key_s key = speculation_keys_[i];
+    leg_s* leg    = &speculated_legs_[i];
+    speculations_[i] = std::async(std::launch::async, [this, speculator, i, pos, approach, key, leg]()
+    {
+      bool planned = speculator->planLegAhead(i, pos, approach, key, leg);
+      if (progress_ != NULL)
+      {
+        {
+          std::lock_guard<std::mutex> lock(progress_->mutex);
+          speculation_done_[i] = 1;
+        }
+        progress_->wake.notify_all();
+      }
+      return planned;
+    }).share();
+  }
+}
+bool RRT::planLegAhead(unsigned int i, NED_s pos, NED_s approach, leg_key_s key, leg_s* leg)
+{
+  // Plans leg i as if the plane came into waypoint i from approach. The roots before it are chained together
+  // so that clearTree reaches the tree of leg i.
+  clearForNewPath();
+  initializeTree(pos, 0.0f);
+  for (unsigned int j = 1; j < i; j++)
+  {
+    root_ptrs_[j - 1]->children.push_back(root_ptrs_[j]);
+    smooth_rts_[j - 1]->children.push_back(smooth_rts_[j]);
+  }
+  node* approach_node        = new node;
+  approach_node->p           = approach;
+  approach_node->fil.z2      = approach;
+  approach_node->parent      = NULL;
+  approach_node->cost        = 0.0f;
+  approach_node->dontConnect = false;
+  approach_node->connects2wp = false;
+  approach_node->children.push_back(root_ptrs_[i]);
+  root_ptrs_[i - 1]->children.push_back(approach_node);
+  smooth_rts_[i - 1]->children.push_back(smooth_rts_[i]);
+  root_ptrs_[i]->parent   = approach_node;
+  root_ptrs_[i]->fil.z2   = approach;
+  smooth_rts_[i]->parent  = approach_node;
+  smooth_rts_[i]->fil.z2  = approach;
+  // Without a fan a direct hit can't be kept, the leg is left to be planned when its turn comes.
+  if (direct_hit_ && createFan(root_ptrs_[i], root_ptrs_[i]->p, key.chi, path_clearance_) == false)
+    return false;
+  long unsigned int iters_left = input_file_.iters_limit;
+  if (growLeg(i, key.map_hash, &iters_left) == false)
+    return false;
+  std::vector<node*> smooth_path = smoothPath(findMinimumPath(i), i, path_clearance_);
+  key.clearance = path_clearance_;
+  *leg = packLeg(key, smooth_path, i);
+  return true;
+}
+bool RRT::takeSpeculation(unsigned int i, leg_key_s key, leg_s* leg)
+{
+  if (i >= speculations_.size() || speculations_[i].valid() == false)
+    return false;
+  // A filleted waypoint can take any heading that fitJunction finds a turn for, a direct hit only a small error.
+  float chi_tol = direct_hit_ ? speculation_tolerance_ : 2.0f*M_PI;
+  if (LegCache::sameKey(speculation_keys_[i], key, chi_tol) == false)
+  {
+    event(EV_SPECULATION_MISSED, i);
+    speculation_progress_[i - 1]->stop();
+    return false;
+  }
+  if (progress_ != NULL)
+  {
+    std::unique_lock<std::mutex> lock(progress_->mutex);
+    progress_->wake.wait(lock, [&]() { return speculation_done_[i] != 0 || progress_->cancel; });
+  }
+  if (cancelled())
+    return false;
+  if (speculations_[i].get() == false)
+    return false;
+  *leg = speculated_legs_[i];
+  if (fitJunction(i, leg) == false)
+  {
+    event(EV_SPECULATION_MISFIT, i);
+    return false;
+  }
+  float clearance    = leg->key.clearance;
+  leg->key           = key;
+  leg->key.clearance = clearance;  // it may have been shrunk while it was planned ahead
+  return true;
+}
+bool RRT::fitJunction(unsigned int i, leg_s* leg)
+{
+  // The turn at waypoint i was fitted to the predicted heading. It is fitted again to the real one, the rest
+  // of the leg is kept if the new turn is possible, clear, and still leaves room for the next turn.
+  node* root = smooth_rts_[i];
+  if (root->parent == NULL || leg->path.size() < 2)
+    return false;
+  fillet_s fil;
+  if (fil.calculate(root->parent->p, root->p, leg->path[0], input_file_.turn_radius) == false)
+    return false;
+  float slope = atan2f(-1.0f*(fil.z1.D - root->fil.z2.D), sqrtf(powf(root->fil.z2.N - fil.z1.N, 2.0f) + powf(root->fil.z2.E - fil.z1.E, 2.0f)));
+  if (slope < -1.0f*input_file_.max_descend_angle || slope > input_file_.max_climb_angle)
+    return false;
+  slope = atan2f(-1.0f*(leg->path[0].D - fil.z2.D), sqrtf(powf(fil.z2.N - leg->path[0].N, 2.0f) + powf(fil.z2.E - leg->path[0].E, 2.0f)));
+  if (slope < -1.0f*input_file_.max_descend_angle || slope > input_file_.max_climb_angle)
+    return false;
+  fillet_s temp_fil = fil;
+  temp_fil.w_im1    = fil.z1;
+  if (col_det_.checkFillet(temp_fil, path_clearance_) == false)
+    return false;
+  if (root->parent->parent != NULL && root->fil.roomFor(fil) == false)
+    return false;
+  if (fil.roomFor(leg->fils[1]) == false)
+    return false;
+  leg->fils[0] = fil;
+  return true;
+}
+void RRT::stopSpeculation()
+{
+  for (unsigned int j = 0; j < speculation_progress_.size(); j++)
+    speculation_progress_[j]->stop();
+  speculations_.clear();          // waits for the planners that are still running
+}
 
 bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
 {
-  // ROS_DEBUG("Attempting direct connect");
+  ScopedPhase phase(trace_, "tryDirectConnect");
+  // THESEUS_DEBUG("Attempting direct connect");
   float clearance = path_clearance_;
   node* start_of_line;
   if (ps->dontConnect && ps->children.size() > 0) // then try one of the grand children
   {
-    // ROS_DEBUG("finding the grand child that is closes TRYDIRECTCONNECT");
+    // THESEUS_DEBUG("finding the grand child that is closes TRYDIRECTCONNECT");
     start_of_line = findClosestNodeGChild(ps, pe_node->p);
   }
   else
   {
-    // ROS_DEBUG("using ps");
+    // THESEUS_DEBUG("using ps");
     start_of_line = ps;
     if (ps->dontConnect)
-      ROS_ERROR("dontConnect = true, but there are no children");
+      THESEUS_ERROR("dontConnect = true, but there are no children");
   }
-  // ROS_DEBUG("checking the line");
+  // THESEUS_DEBUG("checking the line");
   if (col_det_.checkLine(start_of_line->p, pe_node->p, clearance))
   {
-    // ROS_DEBUG("line passed");
+    // THESEUS_DEBUG("line passed");
     if (start_of_line->parent == NULL) // then this is the start
     {
-      // ROS_DEBUG("parent is null");
+      // THESEUS_DEBUG("parent is null");
       float chi = (pe_node->p - start_of_line->p).getChi();
-      // ROS_DEBUG("checking after the waypoint");
+      // THESEUS_DEBUG("checking after the waypoint");
       bool after_wp_check = true;
       if (direct_hit_)
       {
         after_wp_check = col_det_.checkAfterWP(pe_node->p, chi, clearance);
         // if (after_wp_check)
-        //   ROS_DEBUG("check after wp = true null");
+        //   THESEUS_DEBUG("check after wp = true null");
         // else
-        //   ROS_DEBUG("check after wp = false null");
+        //   THESEUS_DEBUG("check after wp = false null");
       }
       if (after_wp_check)
       {
@@ -273,7 +596,7 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
             chi2 -= 2.0f*M_PI;
           if (chi2 < 5.0f*M_PI/180.0 && chi2 > -5.0f*M_PI/180.0)
           {
-            // ROS_DEBUG("too close of chi1 and chi2");
+            // THESEUS_DEBUG("too close of chi1 and chi2");
             return false;
           }
           fillet_s fil_e;
@@ -282,11 +605,11 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
           bool passed_final_fillet = fil_e.calculate(start_of_line->p, map_.wps[0], pad, input_file_.turn_radius);
           if (passed_final_fillet == false)
           {
-            // ROS_FATAL("Failed final fillet 1");
+            // THESEUS_FATAL("Failed final fillet 1");
             return false;
           }
         }
-        // ROS_DEBUG("direct connection success 1");
+        // THESEUS_DEBUG("direct connection success 1");
         start_of_line->cost        = start_of_line->cost + (pe_node->p - start_of_line->p).norm();
         start_of_line->connects2wp = true;
         start_of_line->children.push_back(pe_node);
@@ -297,7 +620,7 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
     else
     {
       fillet_s fil;
-      // ROS_DEBUG("calculating fillet");
+      // THESEUS_DEBUG("calculating fillet");
       bool fil_possible = fil.calculate(start_of_line->parent->p, start_of_line->p, pe_node->p, input_file_.turn_radius);
       fillet_s temp_fil = fil;
       float slope = atan2f(-1.0f*(fil.z1.D - start_of_line->fil.z2.D), sqrtf(powf(start_of_line->fil.z2.N - \
@@ -309,39 +632,38 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
       if (slope < -1.0f*input_file_.max_descend_angle || slope > input_file_.max_climb_angle)
         return false;
       temp_fil.w_im1 = fil.z1;
-      // ROS_DEBUG("cheking fillet");
+      // THESEUS_DEBUG("cheking fillet");
       if (fil_possible && col_det_.checkFillet(temp_fil, clearance))
       {
-        // ROS_DEBUG("fillet checked out, now trying neighboring fillets");
+        // THESEUS_DEBUG("fillet checked out, now trying neighboring fillets");
         if (start_of_line->parent != NULL && start_of_line->fil.roomFor(fil) == false)
         {
           //printNode(start_of_line);
-          // ROS_DEBUG("failed direct connection because of neighboring fillets");
+          // THESEUS_DEBUG("failed direct connection because of neighboring fillets");
           return false;
         }
         float chi = (pe_node->p - start_of_line->p).getChi();
-        // ROS_DEBUG("checking after the waypoint");
+        // THESEUS_DEBUG("checking after the waypoint");
         bool after_wp_check = true;
         if (direct_hit_)
         {
           after_wp_check = col_det_.checkAfterWP(pe_node->p, chi, clearance);
           // if (after_wp_check)
-          //   ROS_DEBUG("check after wp = true");
+          //   THESEUS_DEBUG("check after wp = true");
           // else
-          //   ROS_DEBUG("check after wp = false");
-          // ROS_DEBUG("pe: N %f E %f D %f", pe_node->p.N, pe_node->p.E, pe_node->p.D);
-          // ROS_DEBUG("chi %f", chi);
-          // ROS_DEBUG("clearance: %f", clearance);
+          //   THESEUS_DEBUG("check after wp = false");
+          // THESEUS_DEBUG("pe: N %f E %f D %f", pe_node->p.N, pe_node->p.E, pe_node->p.D);
+          // THESEUS_DEBUG("chi %f", chi);
+          // THESEUS_DEBUG("clearance: %f", clearance);
         }
         if (after_wp_check)
         {
           // check to see if the change in chi is okay
           if (landing_now_)
           {
-            ROS_DEBUG("try direct connect landing");
             float chi1 = chi;
             float chi2 = (map_.wps.back() - map_.wps[map_.wps.size() - 2]).getChi() - M_PI;
-            // ROS_DEBUG("Chi1 %f Chi2 %f", chi1, chi2);
+            // THESEUS_DEBUG("Chi1 %f Chi2 %f", chi1, chi2);
             chi2 = chi2 - chi1;
             while (chi2 < -1.0f*M_PI)
               chi2 += 2.0f*M_PI;
@@ -349,7 +671,7 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
               chi2 -= 2.0f*M_PI;
             if (chi2 < 5.0f*M_PI/180.0 && chi2 > -5.0f*M_PI/180.0)
             {
-              ROS_DEBUG("too close of chi1 and chi2, number 2");
+              event(EV_LANDING_REJECTED, i, 1);
               return false;
             }
             fillet_s fil_e;
@@ -358,11 +680,10 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
             bool passed_final_fillet = fil_e.calculate(start_of_line->p, map_.wps[0], pad, input_file_.turn_radius);
             if (passed_final_fillet == false)
             {
-              ROS_DEBUG("Failed final fillet 2");
+              event(EV_LANDING_REJECTED, i, 2);
               return false;
             }
           }
-          ROS_DEBUG("direct connection success 2");
           start_of_line->cost        = start_of_line->cost + (pe_node->p - start_of_line->p).norm() - fil.adj;
           start_of_line->connects2wp = true;
           start_of_line->children.push_back(pe_node);
@@ -372,16 +693,17 @@ bool RRT::tryDirectConnect(node* ps, node* pe_node, unsigned int i)
       }
     }
   }
-  // ROS_DEBUG("direct connection failed");
+  // THESEUS_DEBUG("direct connection failed");
   return false;
 }
 int RRT::developTree(unsigned int i)
 {
-  // ROS_DEBUG("looking for next node");
+  ScopedPhase phase(trace_, "developTree");
+  // THESEUS_DEBUG("looking for next node");
   bool added_new_node = false;
   float clearance = path_clearance_;
   int num_test_points = 0;
-  int max_num_test_points = 250;
+  int max_num_test_points = input_file_.max_test_points;
   while (added_new_node == false)
   {
     // generate a good point to test
@@ -393,33 +715,10 @@ int RRT::developTree(unsigned int i)
     if (taking_off_ == false && landing_now_ == false)
       random_point.D     = redoRandomDownPoint(i,  closest_node->p.D); // this is so that more often a node passes the climb angle check
     NED_s test_point   = (random_point - closest_node->p).normalize()*segment_length_ + closest_node->p;
-    if (taking_off_ && chi_take_off_ > -100.0f)
-    {
-      // check to make sure you are getting above the comfortable_altitude_
-      float d2rand = sqrtf(powf(root_ptrs_[i]->p.N - test_point.N, 2.0f) + powf(root_ptrs_[i]->p.E - test_point.E, 2.0f));
-      if ((segment_length_+ 30.0) > d2rand)
-      {
-        // then get in the right direction
-        float chi_random = (test_point - root_ptrs_[i]->p).getChi();
-        while (chi_random < 0.0f)
-          chi_random += 2.0f*M_PI;
-        float chi_diff = chi_random - chi_take_off_;
-        while (chi_diff < -1.0f*M_PI)
-          chi_diff += 2.0f*M_PI;
-        while (chi_diff > 1.0f*M_PI)
-          chi_diff -= 2.0f*M_PI;
-        bool passed_take_off_chi = fabs(chi_diff) < 25.0f*M_PI/180.0;
-        if (passed_take_off_chi)
-          added_new_node     = checkForCollision(closest_node, test_point, i, clearance, false);
-        else
-          added_new_node     = false;
-      }
-      else
-        added_new_node     = checkForCollision(closest_node, test_point, i, clearance, false);
-
-    }
+    if (takeOffHeading(i, test_point))
+      added_new_node     = checkForCollision(closest_node, test_point, i, clearance, false, &most_recent_node_);
     else
-      added_new_node     = checkForCollision(closest_node, test_point, i, clearance, false);
+      added_new_node     = false;
 
     // std::vector<NED_s> temp_path;
     // if (closest_node->parent != NULL)
@@ -430,25 +729,22 @@ int RRT::developTree(unsigned int i)
     num_test_points++;
     if (num_test_points > max_num_test_points)
     {
-      ROS_WARN("Reached maximum number of test points in develop tree, starting again.");
+      event(EV_TEST_POINTS, i, max_num_test_points);
       return false;
     }
   }
-  // ROS_DEBUG("found a new node");
-  if (animating_)
+  // THESEUS_DEBUG("found a new node");
+  if (animating_ && viz_ != NULL)
   {
-    std::vector<NED_s> temp_path;
     if (most_recent_node_->parent->parent != NULL)
-      temp_path.push_back(most_recent_node_->parent->fil.z2);
-    temp_path.push_back(most_recent_node_->parent->p);
-    temp_path.push_back(most_recent_node_->p);
-    plt.displayPath(temp_path, clr.gray, 2.9f);
-    ros::Duration(tree_display_time_).sleep();
+      viz_->addTreeEdge(most_recent_node_->parent->fil.z2, most_recent_node_->parent->p);
+    viz_->addTreeEdge(most_recent_node_->parent->p, most_recent_node_->p);
   }
 
 
-  // ROS_DEBUG("trying direct connect for the new node");
+  // THESEUS_DEBUG("trying direct connect for the new node");
   bool connect_to_end = tryDirectConnect(most_recent_node_, root_ptrs_[i + 1], i);
+  if (animating_ && viz_ != NULL) {viz_->publishTree(connect_to_end);}
   if (connect_to_end == true)
     return true;
   else
@@ -456,12 +752,11 @@ int RRT::developTree(unsigned int i)
 }
 std::vector<node*> RRT::findMinimumPath(unsigned int i)
 {
-  ROS_DEBUG("finding a minimum path");
+  ScopedPhase phase(trace_, "findMinimumPath");
   // recursively go through the tree to find the connector
   std::vector<node*> rough_path;
   float minimum_cost = INFINITY;
   node* almost_last  = findMinConnector(root_ptrs_[i], root_ptrs_[i], &minimum_cost);
-  ROS_DEBUG("found a minimum path");
   root_ptrs_[i + 1]->parent  = almost_last;
   smooth_rts_[i + 1]->parent = almost_last;
   if (almost_last->parent != NULL)
@@ -470,74 +765,79 @@ std::vector<node*> RRT::findMinimumPath(unsigned int i)
     bool fil_b = fil.calculate(almost_last->parent->p, almost_last->p, root_ptrs_[i + 1]->p, input_file_.turn_radius);
     root_ptrs_[i + 1]->fil    = fil;
     smooth_rts_[i + 1]->fil    = fil;
-    // ROS_DEBUG("calculated fillet");
+    // THESEUS_DEBUG("calculated fillet");
   }
 
 	std::stack<node*> wpstack;
 	node *current_node = root_ptrs_[i + 1];
-  // //ROS_DEBUG("printing the root");
+  // //THESEUS_DEBUG("printing the root");
   // printNode(root_ptrs_[i]);
 	while (current_node != root_ptrs_[i])
   {
-    // ROS_DEBUG("pushing parent");
+    // THESEUS_DEBUG("pushing parent");
 		// printNode(current_node);
     wpstack.push(current_node);
 		current_node = current_node->parent;
 	}
   rough_path.push_back(root_ptrs_[i]);
-  // ROS_DEBUG("about to empty the stack");
+  // THESEUS_DEBUG("about to empty the stack");
 	while (!wpstack.empty())
 	{
-    //ROS_DEBUG("pushing to rough_path");
+    //THESEUS_DEBUG("pushing to rough_path");
 		rough_path.push_back(wpstack.top());
 		wpstack.pop();
 	}
-  //ROS_DEBUG("created rough path");
+  //THESEUS_DEBUG("created rough path");
   return rough_path;
 }
-std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i)
+std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i, float clearance, node** approach)
 {
+  ScopedPhase phase(trace_, "smoothPath");
+  ScopedDuration smooth_time(progress_ == NULL ? NULL : &progress_->smooth_us);
+  // With approach (on another thread while the next leg grows) nothing is plotted and the new parent of
+  // root i + 1 is put in approach instead of being reset.
+  bool animate = animating_ && viz_ != NULL && approach == NULL;
+  node* added  = NULL;  // the node the last check added, most_recent_node_ belongs to the tree that is growing
   // rough_path.erase(rough_path.begin());
   // return rough_path;
 
 
   std::vector<node*> new_path;
-  if (animating_){plt.displayPath(rough_path, clr.blue, 6.0f);}
+  if (animate){viz_->displayPath(rough_path, clr.blue, 6.0f);}
 
 
-  ROS_DEBUG("STARTING THE SMOOTHER");
-  ros::Time smooth_start_time = ros::Time::now();
+  event(EV_SMOOTH_START, i, rough_path.size(), root_ptrs_.size() > i && root_ptrs_[i]->dontConnect);
+  std::chrono::steady_clock::time_point smooth_start_time = std::chrono::steady_clock::now();
   float max_smoothing_time = 12.0f;
   float ts_;
   if (smooth_rts_.size() > i)
     new_path.push_back(smooth_rts_[i]);
   else
   {
-    ROS_FATAL("smooth roots error");
-    ROS_FATAL("pushing the rough path");
+    THESEUS_FATAL("smooth roots error");
+    THESEUS_FATAL("pushing the rough path");
     rough_path.erase(rough_path.begin());
     return rough_path;
   }
-  // ROS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
+  // THESEUS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
   // printNode(new_path.back());
   std::vector<NED_s> temp_path; // used for plotting
   if (root_ptrs_.size() < i + 1)
   {
-    ROS_FATAL("roots size error");
-    ROS_FATAL("pushing the rough path");
+    THESEUS_FATAL("roots size error");
+    THESEUS_FATAL("pushing the rough path");
     rough_path.erase(rough_path.begin());
     return rough_path;
   }
   if (root_ptrs_[i]->dontConnect)
   {
-    ROS_DEBUG("DONT CONNECT Smoother");
     int ptr;
     ptr = 0;
 
     if (rough_path.size() < ptr + 2 + 1)
     {
-      ROS_FATAL("rough_path size error, less than 3");
-      ROS_FATAL("pushing the rough path");
+      THESEUS_FATAL("rough_path size error, less than 3");
+      THESEUS_FATAL("pushing the rough path");
       rough_path.erase(rough_path.begin());
       return rough_path;
     }
@@ -550,7 +850,6 @@ std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i)
       parent_point = new_path.back()->parent->p;
     bool passed1 = fil1.calculate(parent_point, new_path.back()->p, rough_path[ptr + 1]->p, input_file_.turn_radius);
     bool passed2 = fil2.calculate(new_path.back()->p, rough_path[ptr + 1]->p, rough_path[ptr + 2]->p, input_file_.turn_radius);
-    if (passed1) {ROS_DEBUG("passed");}
     node *fake_child           = new node;
     node *normal_gchild        = new node;
     fake_child->p              = rough_path[ptr + 1]->p;
@@ -574,72 +873,69 @@ std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i)
     node* best_so_far;
     while (ptr < rough_path.size() - 1) // should this be -2 ?
     {
-      ROS_DEBUG("while ptr = %i of %lu",ptr, rough_path.size() - 1);
       // if (ptr == 2)
       // {
-      //   ROS_FATAL("ptr = 2 in direct connect, something went wrong, adding the rough path.");
+      //   THESEUS_FATAL("ptr = 2 in direct connect, something went wrong, adding the rough path.");
       //   rough_path.erase(rough_path.begin());
       //   return rough_path;
       // }
-      if (animating_)
+      if (animate)
       {
         if (new_path.back()->parent != NULL)
           temp_path.push_back(new_path.back()->fil.z2);
         temp_path.push_back(new_path.back()->p);
         temp_path.push_back(rough_path[ptr + 1]->p);
-        plt.displayPath(temp_path, clr.orange, 3.2f);
-        ros::Duration(smoothing_display_time_).sleep();
+        viz_->displayPath(temp_path, clr.orange, 3.2f);
+        pause(smoothing_display_time_);
         temp_path.clear();
       }
 
-      ROS_DEBUG("ptr = %i of %lu",ptr, rough_path.size() - 1);
-      if (checkWholePath(new_path.back(), rough_path, ptr + 1, i) == false)
+      if (checkWholePath(new_path.back(), rough_path, ptr + 1, i, clearance, &added) == false)
       {
-        ROS_DEBUG("Collision, adding the most recent node");
-        // ROS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
-        // ROS_DEBUG("N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
-        if (animating_)
+        event(EV_SMOOTH_STEP, i, ptr, rough_path.size() - 1, 1);
+        // THESEUS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
+        // THESEUS_DEBUG("N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
+        if (animate)
         {
           if (new_path.back()->parent != NULL)
             temp_path.push_back(new_path.back()->fil.z2);
           temp_path.push_back(new_path.back()->p);
           temp_path.push_back(best_so_far->p);
-          plt.displayPath(temp_path, clr.green, 8.0f);
-          ros::Duration(smoothing_display_time_).sleep();
+          viz_->displayPath(temp_path, clr.green, 8.0f);
+          pause(smoothing_display_time_);
           temp_path.clear();
         }
         new_path.push_back(best_so_far);
-        ROS_DEBUG("Adding most recent node");
       }
       else
       {
-        best_so_far = most_recent_node_;
-        // ROS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
+        best_so_far = added;
+        event(EV_SMOOTH_STEP, i, ptr, rough_path.size() - 1, 0);
+        // THESEUS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
         ptr++;
       }
 
-      ros::Time new_time = ros::Time::now();
-      ros::Duration time_step = new_time - smooth_start_time;
-      ts_ = time_step.toSec();
+      ts_ = std::chrono::duration<float>(std::chrono::steady_clock::now() - smooth_start_time).count();
       if (ts_ > max_smoothing_time)
       {
         rough_path.erase(rough_path.begin());
-        ROS_FATAL("SMOOTHER FAILED");
+        THESEUS_FATAL("SMOOTHER FAILED");
+        event(EV_SMOOTH_TIMEOUT, i);
         return rough_path;
       }
     }
     if (smooth_rts_.size() < i + 1 + 1)
     {
-      ROS_FATAL("smooth_rts_ size error, less than i + 1 + 1");
-      ROS_FATAL("pushing the rough path");
+      THESEUS_FATAL("smooth_rts_ size error, less than i + 1 + 1");
+      THESEUS_FATAL("pushing the rough path");
       rough_path.erase(rough_path.begin());
       return rough_path;
     }
     new_path.push_back(smooth_rts_[i + 1]);
-    // ROS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
+    // THESEUS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
     // for (int j = 0; j < new_path.size(); j++)
     // {
-    //   ROS_DEBUG("new_path %i N: %f E: %f D: %f", j, new_path[j]->p.N, new_path[j]->p.E, new_path[j]->p.D);
+    //   THESEUS_DEBUG("new_path %i N: %f E: %f D: %f", j, new_path[j]->p.N, new_path[j]->p.E, new_path[j]->p.D);
     // }
     // smooth the fan
     // if possible move the second waypoint and delete the third.
@@ -647,62 +943,58 @@ std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i)
     NED_s coming_from;
     if (new_path.size() < 4 || new_path.size() < 2)
     {
-      ROS_FATAL("new_path size error, less than 4 or 2, %lu", new_path.size());
-      ROS_FATAL("pushing the rough path");
+      THESEUS_FATAL("new_path size error, less than 4 or 2, %lu", new_path.size());
+      THESEUS_FATAL("pushing the rough path");
       rough_path.erase(rough_path.begin());
       return rough_path;
     }
-    ROS_DEBUG("looking at coming from");
     coming_from = new_path[0]->p + (new_path[0]->p - new_path[1]->p);
-    ROS_DEBUG("checking to create direct fan");
-    if (checkDirectFan(coming_from, new_path[0], new_path[3]))
+    if (checkDirectFan(coming_from, new_path[0], new_path[3], clearance, &added))
     {
-      ROS_INFO("SMOOTHING THE FAN IS POSSIBLE");
-      new_path[1] = most_recent_node_;
+      event(EV_SMOOTH_FAN, i);
+      new_path[1] = added;
       new_path.erase(new_path.begin() + 2);
       // for (int j = 0; j < new_path.size(); j++)
       // {
-      //   ROS_DEBUG("new_path %i N: %f E: %f D: %f", j, new_path[j]->p.N, new_path[j]->p.E, new_path[j]->p.D);
+      //   THESEUS_DEBUG("new_path %i N: %f E: %f D: %f", j, new_path[j]->p.N, new_path[j]->p.E, new_path[j]->p.D);
       // }
     }
   }
   else
   {
-    ROS_DEBUG("connect smoother");
     int ptr = 0;
     node* best_so_far;
     while (ptr < rough_path.size() - 1) // should this be -2?
     {
-      ROS_DEBUG("ptr = %i of %lu",ptr, rough_path.size() - 1);
-      if (animating_)
+      if (animate)
       {
         if (new_path.back()->parent != NULL)
           temp_path.push_back(new_path.back()->fil.z2);
         temp_path.push_back(new_path.back()->p);
         temp_path.push_back(rough_path[ptr + 1]->p);
-        plt.displayPath(temp_path, clr.orange, 3.2f);
-        ros::Duration(smoothing_display_time_).sleep();
+        viz_->displayPath(temp_path, clr.orange, 3.2f);
+        pause(smoothing_display_time_);
         temp_path.clear();
       }
-      if (checkWholePath(new_path.back(), rough_path, ptr + 1, i) == false)
+      if (checkWholePath(new_path.back(), rough_path, ptr + 1, i, clearance, &added) == false)
       {
-        ROS_DEBUG("Collision, adding the most recent node");
+        event(EV_SMOOTH_STEP, i, ptr, rough_path.size() - 1, 1);
         if (ptr == 0)
         {
-          ROS_FATAL("ptr = 0, something went wrong, adding the rough path.");
+          THESEUS_FATAL("ptr = 0, something went wrong, adding the rough path.");
           rough_path.erase(rough_path.begin());
           return rough_path;
         }
-        // ROS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
-        // ROS_DEBUG("N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
-        if (animating_)
+        // THESEUS_DEBUG("N: %f, E: %f, D: %f", new_path.back()->p.N, new_path.back()->p.E,new_path.back()->p.D);
+        // THESEUS_DEBUG("N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
+        if (animate)
         {
           if (new_path.back()->parent != NULL)
             temp_path.push_back(new_path.back()->fil.z2);
           temp_path.push_back(new_path.back()->p);
           temp_path.push_back(best_so_far->p);
-          plt.displayPath(temp_path, clr.green, 8.0f);
-          ros::Duration(smoothing_display_time_).sleep();
+          viz_->displayPath(temp_path, clr.green, 8.0f);
+          pause(smoothing_display_time_);
           temp_path.clear();
         }
 
@@ -710,83 +1002,112 @@ std::vector<node*> RRT::smoothPath(std::vector<node*> rough_path, int i)
       }
       else
       {
-        best_so_far = most_recent_node_;
+        best_so_far = added;
+        event(EV_SMOOTH_STEP, i, ptr, rough_path.size() - 1, 0);
         ptr++;
-        ROS_DEBUG("no collision");
-        // ROS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
+        // THESEUS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
       }
-      // ROS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
+      // THESEUS_DEBUG("best so far: N: %f, E: %f, D: %f", best_so_far->p.N, best_so_far->p.E,best_so_far->p.D);
 
-      ros::Time new_time = ros::Time::now();
-      ros::Duration time_step = new_time - smooth_start_time;
-      ts_ = time_step.toSec();
+      ts_ = std::chrono::duration<float>(std::chrono::steady_clock::now() - smooth_start_time).count();
       if (ts_ > max_smoothing_time)
       {
-        ROS_FATAL("SMOOTHER FAILED");
+        THESEUS_FATAL("SMOOTHER FAILED");
+        event(EV_SMOOTH_TIMEOUT, i);
         rough_path.erase(rough_path.begin());
         return rough_path;
       }
     }
     if (smooth_rts_.size() < i + 1 + 1)
     {
-      ROS_FATAL("smooth_rts_ size error, less than i + 1 + 1");
-      ROS_FATAL("pushing the rough path");
+      THESEUS_FATAL("smooth_rts_ size error, less than i + 1 + 1");
+      THESEUS_FATAL("pushing the rough path");
       rough_path.erase(rough_path.begin());
       return rough_path;
     }
     new_path.push_back(smooth_rts_[i + 1]);
   }
-  if (root_ptrs_.size() > i + 1)
+  if (root_ptrs_.size() > i + 1 && approach != NULL)
+    *approach = new_path[new_path.size() - 2];
+  else if (root_ptrs_.size() > i + 1)
     resetParent(root_ptrs_[i + 1], new_path[new_path.size() - 2]);
   else
-    ROS_FATAL("resetting parent issue");
-  if (animating_){plt.displayPath(new_path, clr.green, 10.0f);}
+    THESEUS_FATAL("resetting parent issue");
+  if (animate){viz_->displayPath(new_path, clr.green, 10.0f);}
   new_path.erase(new_path.begin());
-  if (animating_) {ros::Duration(smoothed_display_time_).sleep();}
+  event(EV_SMOOTH_DONE, i, new_path.size());
+  if (animate) {pause(smoothed_display_time_);}
   return new_path;
 }
-bool RRT::checkWholePath(node* snode, std::vector<node*> rough_path, int ptr, int i)
+bool RRT::checkWholePath(node* snode, std::vector<node*> rough_path, int ptr, int i, float clearance, node** added)
 {
   bool okay_path;
   node* add_this_node_next;
-  most_recent_node_ = snode;
+  node* last_added = snode;
   node* almost_last;
   for (int j = ptr; j < rough_path.size(); j++)
   {
-    // ROS_DEBUG("checking N %f E %f D %f", most_recent_node_->p.N, most_recent_node_->p.E, most_recent_node_->p.D);
-    // ROS_DEBUG("to       N %f E %f D %f", rough_path[j]->p.N, rough_path[j]->p.E, rough_path[j]->p.D);
-    almost_last = most_recent_node_;
-    okay_path = checkForCollision(most_recent_node_, rough_path[j]->p, i, path_clearance_, false);
+    // THESEUS_DEBUG("checking N %f E %f D %f", last_added->p.N, last_added->p.E, last_added->p.D);
+    // THESEUS_DEBUG("to       N %f E %f D %f", rough_path[j]->p.N, rough_path[j]->p.E, rough_path[j]->p.D);
+    almost_last = last_added;
+    okay_path = checkForCollision(last_added, rough_path[j]->p, i, clearance, false, &last_added);
     if (okay_path == false)
     {
-      // ROS_DEBUG("path is bad");
+      // THESEUS_DEBUG("path is bad");
       return false;
     }
     if (j == ptr)
-      add_this_node_next = most_recent_node_;
+      add_this_node_next = last_added;
   }
 
   if (direct_hit_)
   {
-    // ROS_DEBUG("after WP checking N %f E %f D %f", almost_last->p.N, almost_last->p.E, almost_last->p.D);
-    // ROS_DEBUG("after WP to       N %f E %f D %f", rough_path.back()->p.N, rough_path.back()->p.E, rough_path.back()->p.D);
+    // THESEUS_DEBUG("after WP checking N %f E %f D %f", almost_last->p.N, almost_last->p.E, almost_last->p.D);
+    // THESEUS_DEBUG("after WP to       N %f E %f D %f", rough_path.back()->p.N, rough_path.back()->p.E, rough_path.back()->p.D);
     float chi = (rough_path.back()->p - almost_last->p).getChi();
-    if (col_det_.checkAfterWP(rough_path.back()->p, chi, path_clearance_) == false)
+    if (col_det_.checkAfterWP(rough_path.back()->p, chi, clearance) == false)
     {
-      // ROS_WARN("check after = false");
-      // ROS_DEBUG("pe: N %f E %f D %f", rough_path.back()->p.N, rough_path.back()->p.E, rough_path.back()->p.D);
-      // ROS_DEBUG("chi %f", chi);
-      // ROS_DEBUG("clearance: %f", path_clearance_);
+      // THESEUS_WARN("check after = false");
+      // THESEUS_DEBUG("pe: N %f E %f D %f", rough_path.back()->p.N, rough_path.back()->p.E, rough_path.back()->p.D);
+      // THESEUS_DEBUG("chi %f", chi);
+      // THESEUS_DEBUG("clearance: %f", path_clearance_);
       return false;
     }
   }
-  most_recent_node_ = add_this_node_next;
+  *added = add_this_node_next;
   return true;
 }
+void RRT::finishLeg(unsigned int i, std::vector<node*> rough_path, std::vector<node*> smooth_path, leg_key_s leg_key, bool leg_cached, std::vector<NED_s>* all_rough_paths)
+{
+  addPath(smooth_path, i);
+  if (leg_cached == false)
+    leg_cache_.add(packLeg(leg_key, smooth_path, i));
+  if (leg_callback_)
+    leg_callback_(i);
+  if (taking_off_ == true && -all_wps_.back().D > input_file_.minFlyHeight)
+  {
+    taking_off_ = false;
+    col_det_.taking_off_ = false;
+    event(EV_TAKE_OFF_DONE, i, -all_wps_.back().D);
+  }
+  for (int it = 1; it < rough_path.size(); it++)
+    all_rough_paths->push_back(rough_path[it]->p);
+  // if (animating_) {plt.displayPath(rough_path, clr.blue, 6.0f);}
+  // if (false) {plt.displayTree(root_ptrs_[i]);}
+  if (animating_ && viz_ != NULL) {viz_->clearRViz(map_);}
+  if (landing_now_ == false && i < secondary_wps_indx_)
+  {
+    // A leg can add a single waypoint, the heading is then from where the solve started.
+    NED_s previous = all_wps_.size() > 1 ? all_wps_[all_wps_.size() - 2] : root_ptrs_[0]->p;
+    ending_point_  = all_wps_.back();
+    ending_chi_    = (all_wps_.back() - previous).getChi();
+  }
+}
 void RRT::addPath(std::vector<node*> smooth_path, unsigned int i)
 {
-  // ROS_DEBUG("Adding the path");
-  // ROS_DEBUG("smooth_path.size() %lu",smooth_path.size());
+  ScopedPhase phase(trace_, "addPath");
+  // THESEUS_DEBUG("Adding the path");
+  // THESEUS_DEBUG("smooth_path.size() %lu",smooth_path.size());
   for (unsigned int j = 0; j < smooth_path.size(); j++)
   {
     // if (direct_hit_ == true && j == smooth_path.size() - 1 && i != map_.wps.size() - 1 && j != 0)
@@ -798,7 +1119,7 @@ void RRT::addPath(std::vector<node*> smooth_path, unsigned int i)
       // redo any height isssues on take off
       if (taking_off_ && j == 0 && -smooth_path[j]->p.D < comfortable_altitude_)
       {
-        ROS_WARN("adjusting height of close waypoint from %f to %f", -smooth_path[j]->p.D, comfortable_altitude_);
+        event(EV_ALTITUDE, i, -smooth_path[j]->p.D, comfortable_altitude_);
         smooth_path[j]->p.D = -comfortable_altitude_;
       }
       all_wps_.push_back(smooth_path[j]->p);
@@ -818,7 +1139,7 @@ void RRT::addPath(std::vector<node*> smooth_path, unsigned int i)
 // Secondary functions
 void RRT::resetParent(node* nin, node* new_parent)
 {
-  // ROS_DEBUG("resetting parent");
+  // THESEUS_DEBUG("resetting parent");
   node* last_parent = nin->parent;
   // printNode(nin);
   // printNode(new_parent);
@@ -839,22 +1160,230 @@ void RRT::resetParent(node* nin, node* new_parent)
   // printNode(new_parent);
   // printNode(last_parent);
 }
+void RRT::saveTrees()
+{
+  // Keeps the positions of every tree from the last solve so that the next solve can re-root them.
+  old_goals_.clear();
+  old_trees_.clear();
+  old_parents_.clear();
+  for (unsigned int i = 0; i + 1 < root_ptrs_.size(); i++)
+  {
+    std::vector<NED_s> pts;
+    std::vector<int> parents;
+    std::vector<node*> queue;   // breadth first, so that every parent is saved before its children
+    std::vector<int> queue_idx;
+    for (unsigned int j = 0; j < root_ptrs_[i]->children.size(); j++)
+    {
+      node* child = root_ptrs_[i]->children[j];
+      if (root_ptrs_[i]->dontConnect)                 // the fan only fits the old heading, keep what grew past it
+        for (unsigned int k = 0; k < child->children.size(); k++)
+        {
+          queue.push_back(child->children[k]);
+          queue_idx.push_back(-1);
+        }
+      else
+      {
+        queue.push_back(child);
+        queue_idx.push_back(-1);
+      }
+    }
+    for (unsigned int q = 0; q < queue.size(); q++)
+    {
+      if (std::find(root_ptrs_.begin(), root_ptrs_.end(), queue[q]) != root_ptrs_.end())
+        continue;                                     // connections to the next waypoint belong to the next tree
+      pts.push_back(queue[q]->p);
+      parents.push_back(queue_idx[q]);
+      for (unsigned int j = 0; j < queue[q]->children.size(); j++)
+      {
+        queue.push_back(queue[q]->children[j]);
+        queue_idx.push_back(pts.size() - 1);
+      }
+    }
+    old_goals_.push_back(root_ptrs_[i + 1]->p);
+    old_trees_.push_back(pts);
+    old_parents_.push_back(parents);
+  }
+}
+bool RRT::takeOffHeading(unsigned int i, NED_s test_point)
+{
+  if (taking_off_ == false || chi_take_off_ <= -100.0f)
+    return true;
+  // check to make sure you are getting above the comfortable_altitude_
+  float d2rand = sqrtf(powf(root_ptrs_[i]->p.N - test_point.N, 2.0f) + powf(root_ptrs_[i]->p.E - test_point.E, 2.0f));
+  if ((segment_length_+ 30.0) <= d2rand)
+    return true;
+  // then get in the right direction
+  float chi_random = (test_point - root_ptrs_[i]->p).getChi();
+  while (chi_random < 0.0f)
+    chi_random += 2.0f*M_PI;
+  float chi_diff = chi_random - chi_take_off_;
+  while (chi_diff < -1.0f*M_PI)
+    chi_diff += 2.0f*M_PI;
+  while (chi_diff > 1.0f*M_PI)
+    chi_diff -= 2.0f*M_PI;
+  return fabs(chi_diff) < 25.0f*M_PI/180.0;
+}
+int RRT::reuseTree(unsigned int i, long unsigned int* reused_nodes)
+{
+  // Re-roots the saved tree that was growing towards the same waypoint. The nodes that grew from the old root are
+  // connected to the closest node of the new tree, every other node goes back on its saved parent. Each edge is
+  // checked again, a node that no longer connects is pruned along with everything that grew from it.
+  int tree = -1;
+  for (unsigned int j = 0; j < old_goals_.size(); j++)
+    if ((old_goals_[j] - root_ptrs_[i + 1]->p).norm() < 1.0f)
+    {
+      tree = j;
+      break;
+    }
+  if (tree < 0)
+    return 0;
+  std::vector<NED_s> pts    = old_trees_[tree];
+  std::vector<int>   parent = old_parents_[tree];
+  std::vector<node*> made(pts.size(), NULL);
+  for (unsigned int j = 0; j < pts.size(); j++)
+  {
+    if (parent[j] >= 0 && made[parent[j]] == NULL)
+      continue;
+    if (landing_now_ && pts[j].D > map_.wps[0].D)
+      continue;
+    node* from = NULL;
+    if (parent[j] >= 0)
+      from = made[parent[j]];
+    else
+    {
+      float min_d = (root_ptrs_[i]->p - pts[j]).norm();
+      from        = findClosestNode(root_ptrs_[i], pts[j], root_ptrs_[i], &min_d);
+      if (min_d < 1.0f)
+        continue;
+    }
+    if (takeOffHeading(i, pts[j]) == false)
+      continue;
+    if (checkForCollision(from, pts[j], i, path_clearance_, false, &most_recent_node_) == false)
+      continue;
+    made[j] = most_recent_node_;
+    (*reused_nodes)++;
+    if (tryDirectConnect(most_recent_node_, root_ptrs_[i + 1], i))
+      return 1;
+  }
+  return 0;
+}
+leg_key_s RRT::legKey(unsigned int i, float chi0, unsigned long map_hash)
+{
+  leg_key_s key;
+  key.start     = root_ptrs_[i]->p;
+  key.goal      = root_ptrs_[i + 1]->p;
+  key.clearance = path_clearance_;
+  key.tuning    = planner_tuning_s(input_file_);
+  key.map_hash  = map_hash;
+  if (root_ptrs_[i]->parent == NULL)
+    key.chi     = chi0;
+  else
+    key.chi     = (root_ptrs_[i]->p - root_ptrs_[i]->parent->p).getChi();
+  key.flags     = 0;
+  if (direct_hit_)
+    key.flags  |= LEG_DIRECT_HIT;
+  if (landing_now_)
+    key.flags  |= LEG_LANDING;
+  if (taking_off_)
+    key.flags  |= LEG_TAKING_OFF;
+  if (dropping_bomb_ && (i == 1 || i == 2))
+    key.flags  |= LEG_BOMB_LINE;
+  if (root_ptrs_[i]->dontConnect)
+    key.flags  |= LEG_DONT_CONNECT;
+  return key;
+}
+leg_s RRT::packLeg(leg_key_s key, std::vector<node*> smooth_path, unsigned int i)
+{
+  // smooth_path ends at the goal, everything before it is stored with its fillet.
+  leg_s leg;
+  leg.key = key;
+  for (unsigned int j = 0; j + 1 < smooth_path.size(); j++)
+  {
+    leg.path.push_back(smooth_path[j]->p);
+    leg.fils.push_back(smooth_path[j]->fil);
+  }
+  leg.goal_fil         = root_ptrs_[i + 1]->fil;
+  leg.smooth_goal_fil  = smooth_rts_[i + 1]->fil;
+  node* smooth_from    = smooth_rts_[i + 1]->parent;
+  leg.smooth_from_null = (smooth_from == NULL);
+  leg.smooth_from_root = (smooth_from == root_ptrs_[i]);
+  if (smooth_from != NULL)
+  {
+    leg.smooth_from     = smooth_from->p;
+    leg.smooth_from_fil = smooth_from->fil;
+  }
+  return leg;
+}
+std::vector<node*> RRT::unpackLeg(leg_s leg, unsigned int i)
+{
+  // Rebuilds the nodes that smoothPath would have left behind for this leg.
+  std::vector<node*> smooth_path;
+  node* parent = smooth_rts_[i];
+  for (unsigned int j = 0; j < leg.path.size(); j++)
+  {
+    node* new_node        = new node;
+    new_node->p           = leg.path[j];
+    new_node->fil         = leg.fils[j];
+    new_node->parent      = parent;
+    new_node->cost        = parent->cost + (leg.path[j] - parent->p).norm() - leg.fils[j].adj;
+    new_node->dontConnect = false;
+    new_node->connects2wp = false;
+    parent->children.push_back(new_node);
+    smooth_path.push_back(new_node);
+    parent = new_node;
+  }
+  root_ptrs_[i + 1]->parent = parent;
+  root_ptrs_[i + 1]->fil    = leg.goal_fil;
+  smooth_rts_[i + 1]->fil   = leg.smooth_goal_fil;
+  if (leg.smooth_from_null)
+    smooth_rts_[i + 1]->parent = NULL;
+  else if (leg.smooth_from_root)
+    smooth_rts_[i + 1]->parent = root_ptrs_[i];
+  else
+  {
+    node* smooth_from        = new node;
+    smooth_from->p           = leg.smooth_from;
+    smooth_from->fil         = leg.smooth_from_fil;
+    smooth_from->parent      = smooth_rts_[i];
+    smooth_from->cost        = smooth_rts_[i]->cost + (leg.smooth_from - smooth_rts_[i]->p).norm();
+    smooth_from->dontConnect = false;
+    smooth_from->connects2wp = false;
+    smooth_rts_[i]->children.push_back(smooth_from);
+    smooth_rts_[i + 1]->parent = smooth_from;
+  }
+  smooth_path.push_back(smooth_rts_[i + 1]);
+  most_recent_node_ = smooth_path.back();
+  return smooth_path;
+}
+bool RRT::trySeedPath(node* start_node, std::vector<NED_s> seed, unsigned int i)
+{
+  // Adds the seed points to the tree one after another, then tries to finish at the waypoint.
+  // The nodes that made it in stay in the tree, developTree can keep growing from them.
+  node* last_node = start_node;
+  for (unsigned int j = 0; j < seed.size(); j++)
+  {
+    if (checkForCollision(last_node, seed[j], i, path_clearance_, false, &most_recent_node_) == false)
+      return false;
+    last_node = most_recent_node_;
+  }
+  return tryDirectConnect(last_node, root_ptrs_[i + 1], i);
+}
 node* RRT::findClosestNodeGChild(node* root, NED_s p)
 {
-  // ROS_DEBUG("looking for the closest node");
+  // THESEUS_DEBUG("looking for the closest node");
   float distance = INFINITY;
   node* closest_gchild;
-  node* closest_node;
-  // ROS_DEBUG("num_children = %lu", root->children.size());
+  node* closest_node = root;      // if none of the children have children of their own
+  // THESEUS_DEBUG("num_children = %lu", root->children.size());
   if (root->children.size() == 0)
   {
-    ROS_ERROR("finding closest grandchildren, but there are no children");
+    THESEUS_ERROR("finding closest grandchildren, but there are no children");
     return root;
   }
   for (unsigned int j = 0; j < root->children.size(); j++)
     for (unsigned int k = 0; k < root->children[j]->children.size(); k++)
     {
-      // ROS_DEBUG("j = %u, k = %u", j, k);
+      // THESEUS_DEBUG("j = %u, k = %u", j, k);
       // printNode(root->children[j]->children[k]);
       float d_gchild = (p - root->children[j]->children[k]->p).norm();
       closest_gchild = findClosestNode(root->children[j]->children[k], p, root->children[j]->children[k], &d_gchild);
@@ -864,38 +1393,38 @@ node* RRT::findClosestNodeGChild(node* root, NED_s p)
         distance = d_gchild;
       }
     }
-    // ROS_DEBUG("found the closest node");
+    // THESEUS_DEBUG("found the closest node");
     // printNode(closest_node);
     return closest_node;
 }
-bool RRT::checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance, bool connecting_to_end)
+bool RRT::checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance, bool connecting_to_end, node** added)
 {
   // returns true if there was no collision detected.
   // returns false if there was a collision collected.
   node* start_of_line;
   if (ps->dontConnect && ps->children.size() > 0) // then try one of the grand children
   {
-    // //ROS_DEBUG("finding one of the grand children");
+    // //THESEUS_DEBUG("finding one of the grand children");
     start_of_line = findClosestNodeGChild(ps, pe);
   }
   else
   {
-    // //ROS_DEBUG("using the starting point");
+    // //THESEUS_DEBUG("using the starting point");
     start_of_line = ps;
     if (ps->dontConnect)
-      ROS_ERROR("dontConnect = true, but there are no children");
+      THESEUS_ERROR("dontConnect = true, but there are no children");
   }
-  // //ROS_DEBUG("checking the line");
+  // //THESEUS_DEBUG("checking the line");
   if (col_det_.checkLine(start_of_line->p, pe, clearance))
   {
-    // ROS_FATAL("chekcLine in RRT passed");
-    // //ROS_DEBUG("line worked");
+    // THESEUS_FATAL("chekcLine in RRT passed");
+    // //THESEUS_DEBUG("line worked");
     if (start_of_line->parent == NULL) // then this is the start
     {
-      // //ROS_DEBUG("parent was null");
+      // //THESEUS_DEBUG("parent was null");
       float chi = (pe - start_of_line->p).getChi();
-      // //ROS_DEBUG("checking after waypoint");
-      // //ROS_DEBUG("found a good connection");
+      // //THESEUS_DEBUG("checking after waypoint");
+      // //THESEUS_DEBUG("found a good connection");
       node* ending_node        = new node;
       ending_node->p           = pe;
       // don't do the fillet
@@ -904,22 +1433,22 @@ bool RRT::checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance,
       ending_node->dontConnect = false;
       ending_node->connects2wp = (pe == map_.wps[i]);
       start_of_line->children.push_back(ending_node);
-      most_recent_node_        = ending_node;
-      // //ROS_DEBUG("printing ending node");
+      *added                   = ending_node;
+      // //THESEUS_DEBUG("printing ending node");
       // printNode(ending_node);
       return true;
     }
     else
     {
-      // //ROS_DEBUG("parent not null, caclulating fillet");
+      // //THESEUS_DEBUG("parent not null, caclulating fillet");
       fillet_s fil;
       bool fil_possible = fil.calculate(start_of_line->parent->p, start_of_line->p, pe, input_file_.turn_radius);
-      // ROS_WARN("n_beg: %f, e_beg: %f, d_beg: %f, n_end: %f, e_end: %f, d_end: %f, ",\
+      // THESEUS_WARN("n_beg: %f, e_beg: %f, d_beg: %f, n_end: %f, e_end: %f, d_end: %f, ",\
       // fil.w_im1.N, fil.w_im1.E, fil.w_im1.D, fil.z1.N, fil.z1.E, fil.z1.D);
       // printFillet(fil);
 
-      // if (fil_possible) { ROS_INFO("fillet possible");}
-      // else {ROS_WARN("fillet not possible");}
+      // if (fil_possible) { THESEUS_INFO("fillet possible");}
+      // else {THESEUS_WARN("fillet not possible");}
       fillet_s temp_fil = fil;
       float slope = atan2f(-1.0f*(fil.z1.D - start_of_line->fil.z2.D), sqrtf(powf(start_of_line->fil.z2.N - \
                            fil.z1.N, 2.0f) + powf(start_of_line->fil.z2.E - fil.z1.E, 2.0f)));
@@ -931,18 +1460,18 @@ bool RRT::checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance,
       temp_fil.w_im1 = fil.z1;
       if (fil_possible && col_det_.checkFillet(temp_fil, clearance))
       {
-        //ROS_DEBUG("passed fillet check, checking for neighboring fillets");
+        //THESEUS_DEBUG("passed fillet check, checking for neighboring fillets");
         if (start_of_line->parent->parent != NULL && start_of_line->fil.roomFor(fil) == false)
         {
           // printNode(start_of_line);
-          //ROS_DEBUG("testing spot N: %f, E %f, D %f", pe.N, pe.E, pe.D);
-          // ROS_FATAL("failed neighboring fillets");
+          //THESEUS_DEBUG("testing spot N: %f, E %f, D %f", pe.N, pe.E, pe.D);
+          // THESEUS_FATAL("failed neighboring fillets");
           return false;
         }
-        //ROS_DEBUG("passed neighboring fillets");
+        //THESEUS_DEBUG("passed neighboring fillets");
         float chi = (pe - start_of_line->p).getChi();
-        // //ROS_DEBUG("checking after wp");
-        //ROS_DEBUG("everything worked, adding another connection");
+        // //THESEUS_DEBUG("checking after wp");
+        //THESEUS_DEBUG("everything worked, adding another connection");
         node* ending_node        = new node;
         ending_node->p           = pe;
         ending_node->fil         = fil;
@@ -951,18 +1480,18 @@ bool RRT::checkForCollision(node* ps, NED_s pe, unsigned int i, float clearance,
         ending_node->dontConnect = false;
         ending_node->connects2wp = (pe == map_.wps[i]);
         start_of_line->children.push_back(ending_node);
-        most_recent_node_        = ending_node;
-        // //ROS_DEBUG("printing ending node");
+        *added                   = ending_node;
+        // //THESEUS_DEBUG("printing ending node");
         // printNode(ending_node);
         return true;
       }
       // else
-      //   ROS_ERROR("failed fillet");
+      //   THESEUS_ERROR("failed fillet");
     }
   }
   // else
-    //ROS_DEBUG("failed line check");
-  // //ROS_DEBUG("Adding node Failed");
+    //THESEUS_DEBUG("failed line check");
+  // //THESEUS_DEBUG("Adding node Failed");
   return false;
 }
 NED_s RRT::randomPoint()
@@ -978,12 +1507,12 @@ NED_s RRT::randomPoint()
   //   // if (funnel_height > input_file_.minFlyHeight)
   //   //   P.D = root_ptrs_[i]->p.D - sqrtf(P.N*P.N + P.E*P.E)*0.6f*input_file_.max_climb_angle;
   // }
-  // if (landing_now_) {ROS_DEBUG("LANDING redo random point"); ROS_DEBUG("%f %f",P.D, map_.wps[0].D);}
+  // if (landing_now_) {THESEUS_DEBUG("LANDING redo random point"); THESEUS_DEBUG("%f %f",P.D, map_.wps[0].D);}
   return P;
 }
 float RRT::redoRandomDownPoint(unsigned int i, float closest_D)
 {
-  // if (landing_now_) {ROS_DEBUG("LANDING redo random point"); ROS_DEBUG("%f %f",closest_D, map_.wps[0].D);}
+  // if (landing_now_) {THESEUS_DEBUG("LANDING redo random point"); THESEUS_DEBUG("%f %f",closest_D, map_.wps[0].D);}
   if (landing_now_ && closest_D > map_.wps[0].D)
     return map_.wps[0].D;
   float angle = rg_.randLin()*(input_file_.max_climb_angle  + input_file_.max_descend_angle) - input_file_.max_descend_angle;
@@ -1017,30 +1546,29 @@ node* RRT::findMinConnector(node* nin, node* minNode, float* minCost) // This re
   float cost;                     // total cost of the function
   if (nin->connects2wp == true)
   {
-    //ROS_DEBUG("found a connector");
+    //THESEUS_DEBUG("found a connector");
     cost = nin->cost;
     if (cost <= *minCost)          // If we found a better cost, update it
     {
-      //ROS_DEBUG("found lower costing connector");
+      //THESEUS_DEBUG("found lower costing connector");
       minNode = nin;              // reset the minNode
       *minCost = cost;               // reset the minimum cost
     }
   }
   else
   {
-    // //ROS_DEBUG("checking all children for connectors");
+    // //THESEUS_DEBUG("checking all children for connectors");
     for (unsigned int i = 0; i < nin->children.size(); i++) // For all of the children figure out their distances
       minNode = findMinConnector(nin->children[i], minNode, minCost); // Recursion for each child
-    // //ROS_DEBUG("finished checking all children for connect  ors");
+    // //THESEUS_DEBUG("finished checking all children for connect  ors");
   }
   return minNode;                  // Return the closest node
 }
 NED_s RRT::findLoiterSpot(NED_s cp, float radius)
 {
-  ROS_DEBUG("finding loiter spot");
   bool center, first_half, second_half;
   center  = col_det_.checkPoint(cp,input_file_.clearance);
-  // ROS_DEBUG("checkpoint 1");
+  // THESEUS_DEBUG("checkpoint 1");
   // ps = 12:00, pe = 6:00
   NED_s ps, pe, ups, upe;
   ups.N = 1.0f; upe.N = -1.0f;
@@ -1050,32 +1578,29 @@ NED_s RRT::findLoiterSpot(NED_s cp, float radius)
   pe    = cp + upe*radius;
   first_half  = col_det_.checkArc(ps, pe, radius, cp, 1, input_file_.clearance); // cw
   second_half = col_det_.checkArc(pe, ps, radius, cp, 1, input_file_.clearance); // cw
-  // ROS_DEBUG("checkpoint 2");
+  // THESEUS_DEBUG("checkpoint 2");
   while ( center == false || first_half == false || second_half == false)
   {
-    // ROS_DEBUG("checkpoint before random point");
+    // THESEUS_DEBUG("checkpoint before random point");
     cp   = randomPoint();
-    // ROS_DEBUG("checkpoint after random point");
+    // THESEUS_DEBUG("checkpoint after random point");
     cp.D = -(rg_.randLin()*(col_det_.maxFlyHeight_  - col_det_.minFlyHeight_ - 15.0f)  + col_det_.minFlyHeight_ + 15.0f);
     center  = col_det_.checkPoint(cp,input_file_.clearance);
     ps   = cp + ups*radius;
     pe   = cp + upe*radius;
     first_half  = col_det_.checkArc(ps, pe, radius, cp, 1, input_file_.clearance); // cw
     second_half = col_det_.checkArc(pe, ps, radius, cp, 1, input_file_.clearance); // cw
-    // ROS_DEBUG("checkpoint 3");
+    // THESEUS_DEBUG("checkpoint 3");
   }
-  ROS_DEBUG("found loiterspot");
   return cp;
 }
 NED_s RRT::findCloseLoiterSpot(NED_s cp, float radius)
 {
-  ROS_DEBUG("finding loiter spot for loiter mission");
   NED_s cp0;
   cp0 = cp;
   bool center, first_half, second_half;
   center  = col_det_.checkPoint(cp,input_file_.clearance);
-  ROS_WARN("down: %f", cp.D);
-  // ROS_DEBUG("checkpoint 1");
+  // THESEUS_DEBUG("checkpoint 1");
   // ps = 12:00, pe = 6:00
   NED_s ps, pe, ups, upe;
   ups.N = 1.0f; upe.N = -1.0f;
@@ -1085,7 +1610,7 @@ NED_s RRT::findCloseLoiterSpot(NED_s cp, float radius)
   pe    = cp + upe*radius;
   first_half  = col_det_.checkArc(ps, pe, radius, cp, 1, input_file_.clearance); // cw
   second_half = col_det_.checkArc(pe, ps, radius, cp, 1, input_file_.clearance); // cw
-  // ROS_DEBUG("checkpoint 2");
+  // THESEUS_DEBUG("checkpoint 2");
   float chi   = 0.0f;
   float d     = 1.0f;
   float dchi  = M_PI/8.0f;
@@ -1094,31 +1619,29 @@ NED_s RRT::findCloseLoiterSpot(NED_s cp, float radius)
   float dDown = -0.5f;
   while ( center == false || first_half == false || second_half == false)
   {
-    // ROS_DEBUG("checkpoint before random point");
+    // THESEUS_DEBUG("checkpoint before random point");
     cp.N = cp0.N + cosf(chi)*d*rg_.randLin();
     cp.E = cp0.E + sinf(chi)*d*rg_.randLin();
     cp.D = cp0.D + Down*rg_.randLin();
     Down += dDown;
     d    += dd;
     chi  += dchi;
-    // ROS_DEBUG("checkpoint after random point");
+    // THESEUS_DEBUG("checkpoint after random point");
     center  = col_det_.checkPoint(cp,input_file_.clearance);
     ps   = cp + ups*radius;
     pe   = cp + upe*radius;
     first_half  = col_det_.checkArc(ps, pe, radius, cp, 1, input_file_.clearance); // cw
     second_half = col_det_.checkArc(pe, ps, radius, cp, 1, input_file_.clearance); // cw
-    // ROS_DEBUG("checkpoint 3");
+    // THESEUS_DEBUG("checkpoint 3");
   }
-  ROS_DEBUG("found loiterspot");
   return cp;
 }
 bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
 {
-  ROS_DEBUG("Creating Fan");
   // printNode(root);
-  // ROS_DEBUG("N: %f, E: %f, D: %f", p.N, p.E, p.D);
-  // ROS_DEBUG("chi %f: ", chi);
-  // ROS_DEBUG("clearance %f", clearance);
+  // THESEUS_DEBUG("N: %f, E: %f, D: %f", p.N, p.E, p.D);
+  // THESEUS_DEBUG("chi %f: ", chi);
+  // THESEUS_DEBUG("clearance %f", clearance);
 
   bool found_at_least_1_good_path = false;
   // Make sure that it is possible to go to the next waypoint
@@ -1160,9 +1683,9 @@ bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
     lea.E = p.E + R*cosf(approach_angle + alpha);
     lea.D = p.D;
 
-    // ROS_WARN("p N %f E %f D %f", p.N, p.E, p.D);
-    // ROS_WARN("cea N %f E %f D %f", cea.N, cea.E, cea.D);
-    // ROS_WARN("cpa N %f E %f D %f", cpa.N, cpa.E, cpa.D);
+    // THESEUS_WARN("p N %f E %f D %f", p.N, p.E, p.D);
+    // THESEUS_WARN("cea N %f E %f D %f", cea.N, cea.E, cea.D);
+    // THESEUS_WARN("cpa N %f E %f D %f", cpa.N, cpa.E, cpa.D);
     // std::vector<NED_s> temp_path0;
     // temp_path0.push_back(root->p);
     // temp_path0.push_back(fake_wp);
@@ -1172,10 +1695,10 @@ bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
     // temp_path0.clear();
     if (col_det_.checkArc(p, cea, input_file_.turn_radius, cpa, 1, clearance)) // cw
     {
-      // ROS_DEBUG("arc passed");
+      // THESEUS_DEBUG("arc passed");
       if (col_det_.checkLine(cea, lea, clearance))
       {
-        // ROS_DEBUG("line passed");
+        // THESEUS_DEBUG("line passed");
         fillet_s fil1, fil2;
         bool passed1, passed2;
         if (root->parent == NULL)
@@ -1230,9 +1753,9 @@ bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
     lea.E = p.E + R*cosf(approach_angle - alpha);
     lea.D = p.D;
 
-    // ROS_FATAL("p N %f E %f D %f", p.N, p.E, p.D);
-    // ROS_FATAL("cea N %f E %f D %f", cea.N, cea.E, cea.D);
-    // ROS_FATAL("cpa N %f E %f D %f", cpa.N, cpa.E, cpa.D);
+    // THESEUS_FATAL("p N %f E %f D %f", p.N, p.E, p.D);
+    // THESEUS_FATAL("cea N %f E %f D %f", cea.N, cea.E, cea.D);
+    // THESEUS_FATAL("cpa N %f E %f D %f", cpa.N, cpa.E, cpa.D);
     // temp_path0.push_back(root->p);
     // temp_path0.push_back(fake_wp);
     // temp_path0.push_back(lea);
@@ -1242,10 +1765,10 @@ bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
 
     if (col_det_.checkArc(p, cea, input_file_.turn_radius, cpa, -1, clearance)) // ccw
     {
-      // ROS_DEBUG("arc passed");
+      // THESEUS_DEBUG("arc passed");
       if (col_det_.checkLine(cea, lea, clearance))
       {
-        // ROS_DEBUG("line passed");
+        // THESEUS_DEBUG("line passed");
         fillet_s fil1, fil2;
         bool passed1, passed2;
         if (root->parent == NULL)
@@ -1288,18 +1811,18 @@ bool RRT::createFan(node* root, NED_s p, float chi, float clearance)
     }
     // ros::Duration(1.0).sleep();
   }
-  // ROS_FATAL("Created the fan: root node now:");
+  // THESEUS_FATAL("Created the fan: root node now:");
   // printNode(root);
   // if (found_at_least_1_good_path)
-  //   ROS_DEBUG("found_at_least_1_good_path = true");
+  //   THESEUS_DEBUG("found_at_least_1_good_path = true");
   // else
-  //   ROS_DEBUG("found_at_least_1_good_path = false");
-  // ROS_DEBUG("ps: N %f E %f D %f", p.N, p.E, p.D);
-  // ROS_DEBUG("chi %f", chi);
-  // ROS_DEBUG("clearance: %f", clearance);
+  //   THESEUS_DEBUG("found_at_least_1_good_path = false");
+  // THESEUS_DEBUG("ps: N %f E %f D %f", p.N, p.E, p.D);
+  // THESEUS_DEBUG("chi %f", chi);
+  // THESEUS_DEBUG("clearance: %f", clearance);
   return found_at_least_1_good_path;
 }
-bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
+bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node, float clearance, node** added)
 {
   NED_s primary_wp, second_wp;
   primary_wp = root->p;
@@ -1359,8 +1882,8 @@ bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
 		lea.N = primary_wp.N + R*sinf(approach_angle + alpha);
 		lea.E = primary_wp.E + R*cosf(approach_angle + alpha);
 		lea.D = primary_wp.D;
-    if (col_det_.checkArc(primary_wp, cea, input_file_.turn_radius, cpa, 1, path_clearance_))
-      if (col_det_.checkLine(cea, lea, path_clearance_))
+    if (col_det_.checkArc(primary_wp, cea, input_file_.turn_radius, cpa, 1, clearance))
+      if (col_det_.checkLine(cea, lea, clearance))
 			{
 				// Looks like things are going to work out for this maneuver!
         fillet_s fil1, fil2;
@@ -1384,7 +1907,7 @@ bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
         root->children.push_back(fake_child);
         next_node->fil          = fil2;
         // normal_gchild->cost        = normal_gchild->parent->cost + (lea - fake_wp).norm() - fil2.adj;
-        most_recent_node_       = fake_child;
+        *added                  = fake_child;
         return true;
 			}
 	}
@@ -1402,8 +1925,8 @@ bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
 		lea.E = primary_wp.E + R*cosf(approach_angle - alpha);
 		lea.D = primary_wp.D;
 
-    if (col_det_.checkArc(primary_wp, cea, input_file_.turn_radius, cpa, -1, path_clearance_))
-      if (col_det_.checkLine(cea, lea, path_clearance_))
+    if (col_det_.checkArc(primary_wp, cea, input_file_.turn_radius, cpa, -1, clearance))
+      if (col_det_.checkLine(cea, lea, clearance))
 			{
         // Looks like things are going to work out for this maneuver!
         fillet_s fil1, fil2;
@@ -1427,7 +1950,7 @@ bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
         root->children.push_back(fake_child);
         next_node->fil          = fil2;
         // normal_gchild->cost        = normal_gchild->parent->cost + (lea - fake_wp).norm() - fil2.adj;
-        most_recent_node_       = fake_child;
+        *added                  = fake_child;
         return true;
 			}
 	}
@@ -1435,7 +1958,7 @@ bool RRT::checkDirectFan(NED_s coming_from, node* root, node* next_node)
 }
 void RRT::setupBombWps()
 {
-  ROS_WARN("setting up bomb wps");
+  THESEUS_WARN("setting up bomb wps");
   float max_len = 400.0f;
   NED_s target;
   target = map_.wps[0];
@@ -1491,7 +2014,7 @@ void RRT::setupBombWps()
           if (best_value < value) // higher number is better
           {
             best_value = value;
-            ROS_INFO("height: %f, len %f, value %f chi %f", -wp.D, len, value, chi);
+            event(EV_BOMB_APPROACH, -wp.D, len, value, chi);
             best_ps = ps;
             best_wp = wp;
             best_pe = pe;
@@ -1509,7 +2032,7 @@ void RRT::setupBombWps()
     map_.wps.push_back(best_pe);
   }
   else
-    ROS_FATAL("failed to find an approach for the bomb drop");
+    THESEUS_FATAL("failed to find an approach for the bomb drop");
 }
 // Initializing and Clearing Data
 void RRT::initializeTree(NED_s pos, float chi0)
@@ -1530,9 +2053,9 @@ void RRT::initializeTree(NED_s pos, float chi0)
 	root_in0->cost        = 0.0f;            // 0 distance.
   root_in0->dontConnect = fan_first_node;
   root_in0->connects2wp = false;
-  // ROS_DEBUG("about to set smoother");
+  // THESEUS_DEBUG("about to set smoother");
   root_in0_smooth->equal(root_in0);
-  // ROS_DEBUG("set smooth_rts");
+  // THESEUS_DEBUG("set smooth_rts");
   // printNode(root_in0);
 	root_ptrs_.push_back(root_in0);
   smooth_rts_.push_back(root_in0_smooth);
@@ -1562,17 +2085,76 @@ void RRT::clearForNewPath()
   all_wps_.clear();
   all_priorities_.clear();
   all_drop_bombs_.clear();
+  if (reuse_trees_)
+    saveTrees();
   clearTree();                    // Clear all of those tree pointer nodes
   // std::vector<node*>().swap(root_ptrs_);
 }
-void RRT::newMap(map_s map_in)
+void RRT::newMap(map_s map_in, MapArtifact* artifact)
 {
+  if (LegCache::hashMap(map_in) != LegCache::hashMap(map_))
+  {
+    old_goals_.clear();           // the saved trees were grown around other obstacles
+    old_trees_.clear();
+    old_parents_.clear();
+  }
   map_ = map_in;
   col_det_.newMap(map_in);
+  size_t size;
+  const char* data = artifact == NULL ? NULL : artifact->section(MAP_SECTION_VISIBILITY, &size);
+  if (use_vis_graph_ && (data == NULL || vis_graph_.load(data, size, map_, input_file_.clearance) == false))
+    vis_graph_.build(map_, input_file_.clearance);
+}
+void RRT::setTuning(planner_tuning_s tuning)
+{
+  stopSpeculation();
+  tuning.apply(&input_file_);
+  segment_length_ = input_file_.segment_length;
+  speculators_.clear();           // they were made with the old configuration
+  speculation_progress_.clear();
 }
-void RRT::newSeed(unsigned int seed)
+void RRT::setRoadmap(Roadmap* roadmap)
 {
-  RandGen rg_in(seed);          // Make a random generator object that is seeded
+  roadmap_ = roadmap;
+}
+void RRT::setProgress(rrt_progress_s* progress)
+{
+  progress_ = progress;
+}
+void RRT::setLegCallback(std::function<void(unsigned int)> callback)
+{
+  leg_callback_ = callback;
+}
+void RRT::setVizSink(VizSink* viz)
+{
+  viz_ = viz;
+}
+void RRT::setTrace(PhaseTrace* trace)
+{
+  trace_ = trace;
+}
+void RRT::event(uint32_t id, float a0, float a1, float a2, float a3)
+{
+  if (events_)
+    events_->record(id, a0, a1, a2, a3);
+}
+void RRT::reportFailure(unsigned int i)
+{
+  if (!events_)
+    return;
+  event(EV_SOLVE_FAILED, i);
+  THESEUS_ERROR("the solve failed, the last planner events were:\n%s", events_->format(200).c_str());
+}
+bool RRT::cancelled()
+{
+  if (progress_ == NULL || progress_->cancel == false)
+    return false;
+  THESEUS_WARN("solveStatic was cancelled");
+  return true;
+}
+void RRT::newSeed(unsigned int seed, bool own_stream)
+{
+  RandGen rg_in(seed, own_stream); // Make a random generator object that is seeded
 	rg_         = rg_in;           // Copy that random generator into the class.
 }
 void RRT::deleteTree()
@@ -1591,9 +2173,24 @@ void RRT::deleteNode(node* pn)                         // Recursively delete eve
 	pn->children.clear();
 	delete pn;
 }
+void RRT::pruneLeg(unsigned int i, unsigned int keep_children)
+{
+  // Deletes everything that grew from root i after its first keep_children children, root i + 1 stays.
+  for (unsigned int j = keep_children; j < root_ptrs_[i]->children.size(); j++)
+    pruneNode(root_ptrs_[i]->children[j], root_ptrs_[i + 1]);
+  root_ptrs_[i]->children.resize(keep_children);
+}
+void RRT::pruneNode(node* pn, node* goal)
+{
+  if (pn == goal)
+    return;
+  for (unsigned int j = 0; j < pn->children.size(); j++)
+    pruneNode(pn->children[j], goal);
+  delete pn;
+}
 void RRT::clearTree()
 {
-  //ROS_DEBUG("clearing tree");
+  //THESEUS_DEBUG("clearing tree");
   if (root_ptrs_.size() > 0)
     clearNode(root_ptrs_[0]);
   root_ptrs_.clear();
@@ -1617,64 +2214,68 @@ bool RRT::checkPoint(NED_s point, float clearance)
 void RRT::printRRTSetup(NED_s pos, float chi0)
 {
   // Print initial position
-  ROS_DEBUG("Initial North: %f, Initial East: %f, Initial Down: %f", pos.N, pos.E, pos.D);
+  THESEUS_DEBUG("Initial North: %f, Initial East: %f, Initial Down: %f", pos.N, pos.E, pos.D);
 
-  ROS_DEBUG("Number of Boundary Points: %lu",  map_.boundary_pts.size());
+  THESEUS_DEBUG("Number of Boundary Points: %lu",  map_.boundary_pts.size());
   for (long unsigned int i = 0; i < map_.boundary_pts.size(); i++)
   {
-    ROS_DEBUG("Boundary: %lu, North: %f, East: %f, Down: %f", \
+    THESEUS_DEBUG("Boundary: %lu, North: %f, East: %f, Down: %f", \
     i, map_.boundary_pts[i].N, map_.boundary_pts[i].E, map_.boundary_pts[i].D);
   }
-  ROS_DEBUG("Number of Waypoints: %lu", map_.wps.size());
+  THESEUS_DEBUG("Number of Waypoints: %lu", map_.wps.size());
   for (long unsigned int i = 0; i < map_.wps.size(); i++)
   {
-    ROS_DEBUG("WP: %lu, North: %f, East: %f, Down: %f", i + (unsigned long int) 1, map_.wps[i].N, map_.wps[i].E, map_.wps[i].D);
+    THESEUS_DEBUG("WP: %lu, North: %f, East: %f, Down: %f", i + (unsigned long int) 1, map_.wps[i].N, map_.wps[i].E, map_.wps[i].D);
   }
-  ROS_DEBUG("Number of Cylinders: %lu", map_.cylinders.size());
+  THESEUS_DEBUG("Number of Cylinders: %lu", map_.cylinders.size());
   for (long unsigned int i = 0; i <  map_.cylinders.size(); i++)
   {
-    ROS_DEBUG("Cylinder: %lu, North: %f, East: %f, Radius: %f, Height: %f", \
+    THESEUS_DEBUG("Cylinder: %lu, North: %f, East: %f, Radius: %f, Height: %f", \
     i, map_.cylinders[i].N, map_.cylinders[i].E, map_.cylinders[i].R,  map_.cylinders[i].H);
   }
 }
 void RRT::printRoots()
 {
   for (unsigned int i = 0; i < root_ptrs_.size(); i++)
-    ROS_DEBUG("Waypoint %i, North: %f, East %f Down: %f", \
+    THESEUS_DEBUG("Waypoint %i, North: %f, East %f Down: %f", \
     i, root_ptrs_[i]->p.N, root_ptrs_[i]->p.E, root_ptrs_[i]->p.D);
 }
 void RRT::printNode(node* nin)
 {
-  ROS_DEBUG("NODE ADDRESS: %p", (void *)nin);
-  ROS_DEBUG("p.N %f, p.E %f, p.D %f", nin->p.N, nin->p.E, nin->p.D);
+  THESEUS_DEBUG("NODE ADDRESS: %p", (void *)nin);
+  THESEUS_DEBUG("p.N %f, p.E %f, p.D %f", nin->p.N, nin->p.E, nin->p.D);
   printFillet(nin->fil);
-  ROS_DEBUG("fil.w_im1.N %f, fil.w_im1.E %f, fil.w_im1.D %f", nin->fil.w_im1.N, nin->fil.w_im1.E, nin->fil.w_im1.D);
-  ROS_DEBUG("fil.w_i.N %f, fil.w_i.E %f, fil.w_i.D %f", nin->fil.w_i.N, nin->fil.w_i.E, nin->fil.w_i.D);
-  ROS_DEBUG("fil.w_ip1.N %f, fil.w_ip1.E %f, fil.w_ip1.D %f", nin->fil.w_ip1.N, nin->fil.w_ip1.E, nin->fil.w_ip1.D);
-  ROS_DEBUG("fil.z1.N %f, fil.z1.E %f, fil.z1.D %f", nin->fil.z1.N, nin->fil.z1.E, nin->fil.z1.D);
-  ROS_DEBUG("fil.z2.N %f, fil.z2.E %f, fil.z2.D %f", nin->fil.z2.N, nin->fil.z2.E, nin->fil.z2.D);
-  ROS_DEBUG("fil.c.N %f, fil.c.E %f, fil.c.D %f", nin->fil.c.N, nin->fil.c.E, nin->fil.c.D);
-  ROS_DEBUG("fil.q_im1.N %f, fil.q_im1.E %f, fil.q_im1.D %f", nin->fil.q_im1.N, nin->fil.q_im1.E, nin->fil.q_im1.D);
-  ROS_DEBUG("fil.q_i.N %f, fil.q_i.E %f, fil.q_i.D %f", nin->fil.q_i.N, nin->fil.q_i.E, nin->fil.q_i.D);
-  ROS_DEBUG("fil.R %f", nin->fil.R);
-  ROS_DEBUG("parent %p", (void *)nin->parent);
-  ROS_DEBUG("number of children %lu", nin->children.size());
-  ROS_DEBUG("cost %f", nin->cost);
-  if (nin->dontConnect) {ROS_DEBUG("dontConnect = true");}
-  else {ROS_DEBUG("dontConnect == false");}
-  if (nin->connects2wp) {ROS_DEBUG("connects2wp = true");}
-  else {ROS_DEBUG("connects2wp == false");}
+  THESEUS_DEBUG("fil.w_im1.N %f, fil.w_im1.E %f, fil.w_im1.D %f", nin->fil.w_im1.N, nin->fil.w_im1.E, nin->fil.w_im1.D);
+  THESEUS_DEBUG("fil.w_i.N %f, fil.w_i.E %f, fil.w_i.D %f", nin->fil.w_i.N, nin->fil.w_i.E, nin->fil.w_i.D);
+  THESEUS_DEBUG("fil.w_ip1.N %f, fil.w_ip1.E %f, fil.w_ip1.D %f", nin->fil.w_ip1.N, nin->fil.w_ip1.E, nin->fil.w_ip1.D);
+  THESEUS_DEBUG("fil.z1.N %f, fil.z1.E %f, fil.z1.D %f", nin->fil.z1.N, nin->fil.z1.E, nin->fil.z1.D);
+  THESEUS_DEBUG("fil.z2.N %f, fil.z2.E %f, fil.z2.D %f", nin->fil.z2.N, nin->fil.z2.E, nin->fil.z2.D);
+  THESEUS_DEBUG("fil.c.N %f, fil.c.E %f, fil.c.D %f", nin->fil.c.N, nin->fil.c.E, nin->fil.c.D);
+  THESEUS_DEBUG("fil.q_im1.N %f, fil.q_im1.E %f, fil.q_im1.D %f", nin->fil.q_im1.N, nin->fil.q_im1.E, nin->fil.q_im1.D);
+  THESEUS_DEBUG("fil.q_i.N %f, fil.q_i.E %f, fil.q_i.D %f", nin->fil.q_i.N, nin->fil.q_i.E, nin->fil.q_i.D);
+  THESEUS_DEBUG("fil.R %f", nin->fil.R);
+  THESEUS_DEBUG("parent %p", (void *)nin->parent);
+  THESEUS_DEBUG("number of children %lu", nin->children.size());
+  THESEUS_DEBUG("cost %f", nin->cost);
+  if (nin->dontConnect) {THESEUS_DEBUG("dontConnect = true");}
+  else {THESEUS_DEBUG("dontConnect == false");}
+  if (nin->connects2wp) {THESEUS_DEBUG("connects2wp = true");}
+  else {THESEUS_DEBUG("connects2wp == false");}
 }
 void RRT::printFillet(fillet_s fil)
 {
-  ROS_DEBUG("fil.w_im1.N %f, fil.w_im1.E %f, fil.w_im1.D %f",  fil.w_im1.N,  fil.w_im1.E,  fil.w_im1.D);
-  ROS_DEBUG("fil.w_i.N %f, fil.w_i.E %f, fil.w_i.D %f",  fil.w_i.N,  fil.w_i.E,  fil.w_i.D);
-  ROS_DEBUG("fil.w_ip1.N %f, fil.w_ip1.E %f, fil.w_ip1.D %f",  fil.w_ip1.N,  fil.w_ip1.E,  fil.w_ip1.D);
-  ROS_DEBUG("fil.z1.N %f, fil.z1.E %f, fil.z1.D %f",  fil.z1.N,  fil.z1.E,  fil.z1.D);
-  ROS_DEBUG("fil.z2.N %f, fil.z2.E %f, fil.z2.D %f",  fil.z2.N,  fil.z2.E,  fil.z2.D);
-  ROS_DEBUG("fil.c.N %f, fil.c.E %f, fil.c.D %f",  fil.c.N,  fil.c.E,  fil.c.D);
-  ROS_DEBUG("fil.q_im1.N %f, fil.q_im1.E %f, fil.q_im1.D %f",  fil.q_im1.N,  fil.q_im1.E,  fil.q_im1.D);
-  ROS_DEBUG("fil.q_i.N %f, fil.q_i.E %f, fil.q_i.D %f",  fil.q_i.N,  fil.q_i.E,  fil.q_i.D);
-  ROS_DEBUG("fil.R %f",  fil.R);
+  THESEUS_DEBUG("fil.w_im1.N %f, fil.w_im1.E %f, fil.w_im1.D %f",  fil.w_im1.N,  fil.w_im1.E,  fil.w_im1.D);
+  THESEUS_DEBUG("fil.w_i.N %f, fil.w_i.E %f, fil.w_i.D %f",  fil.w_i.N,  fil.w_i.E,  fil.w_i.D);
+  THESEUS_DEBUG("fil.w_ip1.N %f, fil.w_ip1.E %f, fil.w_ip1.D %f",  fil.w_ip1.N,  fil.w_ip1.E,  fil.w_ip1.D);
+  THESEUS_DEBUG("fil.z1.N %f, fil.z1.E %f, fil.z1.D %f",  fil.z1.N,  fil.z1.E,  fil.z1.D);
+  THESEUS_DEBUG("fil.z2.N %f, fil.z2.E %f, fil.z2.D %f",  fil.z2.N,  fil.z2.E,  fil.z2.D);
+  THESEUS_DEBUG("fil.c.N %f, fil.c.E %f, fil.c.D %f",  fil.c.N,  fil.c.E,  fil.c.D);
+  THESEUS_DEBUG("fil.q_im1.N %f, fil.q_im1.E %f, fil.q_im1.D %f",  fil.q_im1.N,  fil.q_im1.E,  fil.q_im1.D);
+  THESEUS_DEBUG("fil.q_i.N %f, fil.q_i.E %f, fil.q_i.D %f",  fil.q_i.N,  fil.q_i.E,  fil.q_i.D);
+  THESEUS_DEBUG("fil.R %f",  fil.R);
+}
+void RRT::pause(float seconds)
+{
+  std::this_thread::sleep_for(std::chrono::duration<float>(seconds));
 }
 } // end namespace theseus
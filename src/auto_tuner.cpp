@@ -0,0 +1,259 @@
+#include <theseus/auto_tuner.h>
+#include <theseus/map_artifact.h>
+
+#include <math.h>
+#include <algorithm>
+
+namespace theseus
+{
+AutoTuner::AutoTuner(map_s map, planner_config_s config, unsigned int num_problems, unsigned int seed)
+{
+  map_          = map;
+  config_       = config;
+  config_.event_ring_size = 0;    // a failed tuning solve isn't worth dumping
+  roadmap_      = NULL;
+  progress_     = NULL;
+  stopped_      = false;
+  min_gain_     = 0.05f;
+  success_rate_ = 1.0f;
+
+  // The problems start anywhere in the air that a replan could start from, well clear of everything.
+  CollisionDetection col_det(config_);
+  col_det.newMap(map_);
+  double minN = -500.0, maxN = 500.0, minE = -500.0, maxE = 500.0;
+  if (map_.boundary_pts.size() > 0)
+  {
+    minN = maxN = map_.boundary_pts[0].N;
+    minE = maxE = map_.boundary_pts[0].E;
+    for (unsigned int j = 1; j < map_.boundary_pts.size(); j++)
+    {
+      minN = std::min(minN, map_.boundary_pts[j].N);
+      maxN = std::max(maxN, map_.boundary_pts[j].N);
+      minE = std::min(minE, map_.boundary_pts[j].E);
+      maxE = std::max(maxE, map_.boundary_pts[j].E);
+    }
+  }
+  double lowest  = config_.minFlyHeight + config_.clearance;
+  double highest = std::max(lowest, config_.maxFlyHeight - config_.clearance);
+  RandGen rg(seed, true);
+  // A map without waypoints is given as many as the mapper would give it.
+  bool draw_wps = map_.wps.empty();
+  for (int k = 0; draw_wps && (int) map_.wps.size() < config_.numWps && k < 1000*config_.numWps; k++)
+  {
+    NED_s p(minN + rg.randLin()*(maxN - minN), minE + rg.randLin()*(maxE - minE), -(lowest + rg.randLin()*(highest - lowest)));
+    if (col_det.checkPoint(p, config_.waypoint_clearance))
+      map_.wps.push_back(p);
+  }
+  for (unsigned int k = 0; k < num_problems; k++)
+    for (unsigned int tries = 0; tries < 1000; tries++)
+    {
+      tuning_problem_s problem;
+      problem.start = NED_s(minN + rg.randLin()*(maxN - minN), minE + rg.randLin()*(maxE - minE), -(lowest + rg.randLin()*(highest - lowest)));
+      problem.chi0  = rg.randLin()*2.0*M_PI;
+      problem.seed  = seed + k;
+      if (col_det.checkPoint(problem.start, config_.clearance + config_.turn_radius))
+      {
+        problems_.push_back(problem);
+        break;
+      }
+    }
+  result_.tuning       = planner_tuning_s(config_);
+  result_.success_rate = 0.0f;
+  result_.mean_time    = 0.0f;
+  result_.untuned_time = 0.0f;
+  result_.problems     = problems_.size();
+  result_.settings     = 0;
+}
+void AutoTuner::setRoadmap(Roadmap* roadmap)
+{
+  roadmap_ = roadmap;
+}
+void AutoTuner::setProgress(rrt_progress_s* progress)
+{
+  progress_ = progress;
+}
+void AutoTuner::setProblemCallback(std::function<bool()> callback)
+{
+  problem_callback_ = callback;
+}
+bool AutoTuner::tune(double budget, float success_rate)
+{
+  success_rate_ = success_rate;
+  stopped_      = false;
+  deadline_     = std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (budget*1.0e6));
+  if (problems_.empty())
+  {
+    THESEUS_WARN("there is nowhere to start a tuning problem from on this map");
+    return false;
+  }
+  tuning_score_s none;
+  none.solved  = 0;
+  none.planned = 0;
+  none.time    = HUGE_VAL;
+  planner_tuning_s best_tuning(config_);
+  tuning_score_s best;
+  result_.settings = 1;
+  if (score(best_tuning, none, &best) == false)
+  {
+    if (stopping() == false)
+      THESEUS_WARN("there wasn't time to plan the tuning problems once");
+    return false;
+  }
+  result_.untuned_time = best.time/problems_.size();
+  THESEUS_INFO("tuning: the configured settings solve %u of %u problems in %.3f s", best.solved, best.planned, best.time);
+
+  bool improved = true;
+  while (improved)
+  {
+    improved = false;
+    for (unsigned int k = 0; k < 5; k++)
+    {
+      std::vector<planner_tuning_s> tries = neighbours(best_tuning, k);
+      for (unsigned int j = 0; j < tries.size(); j++)
+      {
+        if (stopping() || std::chrono::steady_clock::now() > deadline_)
+          break;
+        tuning_score_s candidate;
+        result_.settings++;
+        if (score(tries[j], best, &candidate) && better(candidate, best))
+        {
+          best        = candidate;
+          best_tuning = tries[j];
+          improved    = true;
+          THESEUS_INFO("tuning: segment %.0f m, clearance x%.2f after %.0f%% of the nodes, %i nodes, %i test points solve %u of %u in %.3f s",
+                   best_tuning.segment_length, best_tuning.clearance_shrink, best_tuning.clearance_patience*100.0f,
+                   best_tuning.iters_limit, best_tuning.max_test_points, best.solved, best.planned, best.time);
+        }
+      }
+    }
+    if (stopping())
+      return false;
+    if (std::chrono::steady_clock::now() > deadline_)
+    {
+      THESEUS_INFO("tuning ran out of time, it keeps the best settings so far");
+      break;
+    }
+  }
+  result_.tuning       = best_tuning;
+  result_.success_rate = best.solved/((float) problems_.size());
+  result_.mean_time    = best.time/problems_.size();
+  return true;
+}
+tuning_result_s AutoTuner::result()
+{
+  return result_;
+}
+bool AutoTuner::score(planner_tuning_s tuning, tuning_score_s best, tuning_score_s* score)
+{
+  // Stops as soon as it can't be better than best any more.
+  score->solved  = 0;
+  score->planned = 0;
+  score->time    = 0.0;
+  planner_config_s config = config_;
+  tuning.apply(&config);
+  unsigned int num_problems = problems_.size();
+  unsigned int required     = ceil(success_rate_*num_problems - 1.0e-6);
+  for (unsigned int k = 0; k < num_problems; k++)
+  {
+    if (stopped_ == false && problem_callback_ && problem_callback_() == false)
+      stopped_ = true;
+    if (stopping() || std::chrono::steady_clock::now() > deadline_)
+      return false;
+    RRT rrt(map_, problems_[k].seed, config);
+    rrt.newSeed(problems_[k].seed, true);
+    rrt.animating_ = false;
+    rrt.setRoadmap(roadmap_);
+    rrt.setProgress(progress_);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool solved = rrt.solveStatic(problems_[k].start, problems_[k].chi0, true, false, false, false);
+    if (stopping())
+      return false;
+    score->time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    score->planned++;
+    if (solved)
+      score->solved++;
+    unsigned int most_solved = score->solved + num_problems - score->planned;
+    if (meets(best) && (most_solved < required || score->time >= best.time*(1.0 - min_gain_)))
+      return false;
+    if (meets(best) == false && (most_solved < best.solved || (most_solved == best.solved && score->time >= best.time*(1.0 - min_gain_))))
+      return false;
+  }
+  return true;
+}
+bool AutoTuner::stopping()
+{
+  return stopped_ || (progress_ != NULL && progress_->cancel);
+}
+bool AutoTuner::better(tuning_score_s a, tuning_score_s b)
+{
+  if (meets(a) != meets(b))
+    return meets(a);
+  if (meets(a) == false && a.solved != b.solved)
+    return a.solved > b.solved;
+  return a.time < b.time*(1.0 - min_gain_);
+}
+bool AutoTuner::meets(tuning_score_s score)
+{
+  return score.planned > 0 && score.solved >= ceil(success_rate_*problems_.size() - 1.0e-6);
+}
+std::vector<planner_tuning_s> AutoTuner::neighbours(planner_tuning_s tuning, unsigned int k)
+{
+  // Setting k of tuning is changed to each of the values it can take, other than the one it has.
+  static const float segment_scales[]    = {0.5f, 0.75f, 1.0f, 1.5f, 2.0f};  // of the configured ones
+  static const float shrinks[]           = {0.25f, 0.5f, 0.75f};
+  static const float patiences[]         = {0.25f, 0.5f, 0.75f};
+  static const float iters_scales[]      = {0.25f, 0.5f, 1.0f, 2.0f};
+  static const float test_point_scales[] = {0.4f, 1.0f, 2.0f, 4.0f};
+  std::vector<planner_tuning_s> tries;
+  planner_tuning_s t = tuning;
+  if (k == 0)
+    for (unsigned int j = 0; j < sizeof(segment_scales)/sizeof(float); j++)
+    {
+      t.segment_length = config_.segment_length*segment_scales[j];
+      if (t.segment_length != tuning.segment_length)
+        tries.push_back(t);
+    }
+  else if (k == 1)
+    for (unsigned int j = 0; j < sizeof(shrinks)/sizeof(float); j++)
+    {
+      t.clearance_shrink = shrinks[j];
+      if (t.clearance_shrink != tuning.clearance_shrink)
+        tries.push_back(t);
+    }
+  else if (k == 2)
+    for (unsigned int j = 0; j < sizeof(patiences)/sizeof(float); j++)
+    {
+      t.clearance_patience = patiences[j];
+      if (t.clearance_patience != tuning.clearance_patience)
+        tries.push_back(t);
+    }
+  else if (k == 3)
+    for (unsigned int j = 0; j < sizeof(iters_scales)/sizeof(float); j++)
+    {
+      t.iters_limit = config_.iters_limit*iters_scales[j];
+      if (t.iters_limit != tuning.iters_limit && t.iters_limit > 0)
+        tries.push_back(t);
+    }
+  else if (k == 4)
+    for (unsigned int j = 0; j < sizeof(test_point_scales)/sizeof(float); j++)
+    {
+      t.max_test_points = config_.max_test_points*test_point_scales[j];
+      if (t.max_test_points != tuning.max_test_points && t.max_test_points > 0)
+        tries.push_back(t);
+    }
+  return tries;
+}
+void AutoTuner::pack(tuning_result_s result, std::vector<char>* blob)
+{
+  appendBlob(blob, &result, 1);
+}
+bool AutoTuner::load(const char* data, size_t size, tuning_result_s* result)
+{
+  blob_reader_s reader(data, size);
+  if (size != sizeof(tuning_result_s) || reader.read(result, 1) == false)
+    return false;
+  planner_tuning_s t = result->tuning;
+  return t.segment_length > 0.0f && t.clearance_shrink > 0.0f && t.clearance_shrink <= 1.0f &&
+         t.clearance_patience > 0.0f && t.clearance_patience < 1.0f && t.iters_limit > 0 && t.max_test_points > 0;
+}
+} // end namespace theseus
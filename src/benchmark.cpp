@@ -0,0 +1,247 @@
+/*	DESCRIPTION:
+ *	Microbenchmarks of the kernels the planner spends its time in: the
+ *	collision checks, the fillet calculation, the nearest node search and
+ *	the gps conversions. The maps come from the mapper with fixed seeds, so
+ *	two runs on the same machine measure the same work. The results are
+ *	written as JSON.
+ *
+ *	rosrun theseus theseus_benchmark _obstacles:="[10, 30, 60]" _output:=kernels.json
+ *	(the pp and ppsim parameters have to be loaded, see param/path_planning.yaml)
+ *
+ */
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <ros/ros.h>
+
+#include <theseus/map_s.h>
+#include <theseus/mapper.h>
+#include <theseus/fillet_s.h>
+#include <theseus/node_s.h>
+#include <theseus/rand_gen.h>
+#include <theseus/gps_struct.h>
+#include <theseus/param_reader.h>
+#include <theseus/ros_log.h>
+#include <theseus/collision_detection.h>
+#include <theseus/RRT.h>
+
+namespace theseus
+{
+struct bench_result_s
+{
+  std::string kernel;
+  int obstacles;
+  int map_seed;
+  int size;                       // nodes in the tree (findClosestNode only)
+  unsigned int calls;             // calls in one repetition
+  double median_ns;               // per call, median of the repetitions
+  double min_ns;                  // per call, fastest repetition
+  double true_fraction;           // how often the kernel returned true, so runs can be checked for the same work
+};
+// Friend of RRT so the nearest node search can be timed without growing a real tree.
+class KernelBenchmark
+{
+public:
+  KernelBenchmark(unsigned int calls, int repetitions);
+  void run(int obstacles, int map_seed, std::vector<int> tree_sizes);
+  bool write(std::string file);
+private:
+  template <typename F> void time(std::string kernel, int obstacles, int map_seed, int size, F f);
+  NED_s randomPoint(RandGen* rg, CollisionDetection* col_det);
+  unsigned int calls_;
+  int repetitions_;
+  float clearance_;
+  float turn_radius_;
+  ParamReader input_file_;
+  std::vector<bench_result_s> results_;
+};
+KernelBenchmark::KernelBenchmark(unsigned int calls, int repetitions)
+{
+  calls_       = calls;
+  repetitions_ = repetitions < 1 ? 1 : repetitions;
+  clearance_   = input_file_.clearance;
+  turn_radius_ = input_file_.turn_radius;
+  logToRosconsole(input_file_.console_level);
+}
+template <typename F> void KernelBenchmark::time(std::string kernel, int obstacles, int map_seed, int size, F f)
+{
+  std::vector<double> ns;
+  unsigned int trues = 0;
+  for (int r = 0; r < repetitions_; r++)
+  {
+    trues = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int j = 0; j < calls_; j++)
+      trues += f(j) ? 1 : 0;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    ns.push_back(std::chrono::duration<double, std::nano>(end - start).count()/calls_);
+  }
+  std::sort(ns.begin(), ns.end());
+  bench_result_s result;
+  result.kernel        = kernel;
+  result.obstacles     = obstacles;
+  result.map_seed      = map_seed;
+  result.size          = size;
+  result.calls         = calls_;
+  result.median_ns     = ns[ns.size()/2];
+  result.min_ns        = ns[0];
+  result.true_fraction = trues/((double) calls_);
+  results_.push_back(result);
+  ROS_INFO("%-22s obstacles %3i seed %3i size %5i: %10.1f ns/call (min %.1f), %.3f true", kernel.c_str(), obstacles,
+           map_seed, size, result.median_ns, result.min_ns, result.true_fraction);
+}
+NED_s KernelBenchmark::randomPoint(RandGen* rg, CollisionDetection* col_det)
+{
+  NED_s p;
+  p.N = col_det->minNorth_ + rg->randLin()*(col_det->maxNorth_ - col_det->minNorth_);
+  p.E = col_det->minEast_  + rg->randLin()*(col_det->maxEast_  - col_det->minEast_);
+  p.D = -(col_det->minFlyHeight_ + rg->randLin()*(col_det->maxFlyHeight_ - col_det->minFlyHeight_));
+  return p;
+}
+void KernelBenchmark::run(int obstacles, int map_seed, std::vector<int> tree_sizes)
+{
+  input_file_.nCyli = obstacles;
+  mapper myWorld(map_seed, &input_file_);
+  CollisionDetection col_det(input_file_);
+  col_det.newMap(myWorld.map);
+  col_det.taking_off_  = false;
+  col_det.landing_now_ = false;
+
+  // The inputs are drawn before anything is timed, with their own stream so they don't depend on the map.
+  RandGen rg(map_seed, true);
+  std::vector<NED_s> points, line_ends;
+  std::vector<fillet_s> fils;
+  std::vector<NED_s> w_im1, w_i, w_ip1;
+  for (unsigned int j = 0; j < calls_; j++)
+  {
+    NED_s p = randomPoint(&rg, &col_det);
+    float chi = rg.randLin()*2.0f*M_PI;
+    float chi_turn = chi + (rg.randLin() - 0.5f)*M_PI;
+    NED_s q(p.N + 100.0f*cosf(chi), p.E + 100.0f*sinf(chi), p.D);
+    NED_s r(q.N + 100.0f*cosf(chi_turn), q.E + 100.0f*sinf(chi_turn), q.D);
+    points.push_back(p);
+    line_ends.push_back(q);
+    w_im1.push_back(p);
+    w_i.push_back(q);
+    w_ip1.push_back(r);
+    fillet_s fil;
+    fil.calculate(p, q, r, turn_radius_);
+    fils.push_back(fil);
+  }
+
+  time("checkPoint", obstacles, map_seed, 0, [&](unsigned int j)
+       {return col_det.checkPoint(points[j], clearance_);});
+  time("checkWithinBoundaries", obstacles, map_seed, 0, [&](unsigned int j)
+       {return col_det.checkWithinBoundaries(points[j], clearance_);});
+  time("checkLine", obstacles, map_seed, 0, [&](unsigned int j)
+       {return col_det.checkLine(points[j], line_ends[j], clearance_);});
+  time("checkArc", obstacles, map_seed, 0, [&](unsigned int j)
+       {return col_det.checkArc(fils[j].z1, fils[j].z2, fils[j].R, fils[j].c, fils[j].lambda, clearance_);});
+  time("checkFillet", obstacles, map_seed, 0, [&](unsigned int j)
+       {return col_det.checkFillet(fils[j], clearance_);});
+  time("fillet_s::calculate", obstacles, map_seed, 0, [&](unsigned int j)
+       {fillet_s fil; return fil.calculate(w_im1[j], w_i[j], w_ip1[j], turn_radius_);});
+
+  // Trees with every node hung off the closest one so far, the shape growth gives them without the collision checks.
+  RRT rrt(myWorld.map, map_seed, input_file_);
+  rrt.animating_ = false;
+  for (unsigned int s = 0; s < tree_sizes.size(); s++)
+  {
+    node* root = new node;
+    root->p           = randomPoint(&rg, &col_det);
+    root->parent      = NULL;
+    root->cost        = 0.0f;
+    root->dontConnect = false;
+    root->connects2wp = false;
+    for (int k = 1; k < tree_sizes[s]; k++)
+    {
+      node* new_node    = new node;
+      new_node->p       = randomPoint(&rg, &col_det);
+      float min_d       = (root->p - new_node->p).norm();
+      node* closest     = rrt.findClosestNode(root, new_node->p, root, &min_d);
+      new_node->parent      = closest;
+      new_node->cost        = min_d;
+      new_node->dontConnect = false;
+      new_node->connects2wp = false;
+      closest->children.push_back(new_node);
+    }
+    time("RRT::findClosestNode", obstacles, map_seed, tree_sizes[s], [&](unsigned int j)
+         {float min_d = (root->p - points[j]).norm(); return rrt.findClosestNode(root, points[j], root, &min_d) != root;});
+    rrt.deleteNode(root);
+  }
+
+  gps_struct gps;
+  gps.set_reference(38.144692, -76.428007, 0.0);
+  std::vector<double> lat(calls_), lon(calls_), h(calls_);
+  for (unsigned int j = 0; j < calls_; j++)
+    gps.ned2gps(points[j].N, points[j].E, points[j].D, lat[j], lon[j], h[j]);
+  time("gps_struct::gps2ned", obstacles, map_seed, 0, [&](unsigned int j)
+       {double N, E, D; gps.gps2ned(lat[j], lon[j], h[j], N, E, D); return N > 0.0;});
+  time("gps_struct::ned2gps", obstacles, map_seed, 0, [&](unsigned int j)
+       {double la, lo, al; gps.ned2gps(points[j].N, points[j].E, points[j].D, la, lo, al); return al > 0.0;});
+}
+bool KernelBenchmark::write(std::string file)
+{
+  std::ofstream out(file.c_str());
+  if (!out.is_open())
+    return false;
+  out << "{\n  \"benchmark\": \"theseus_kernels\",\n";
+  out << "  \"calls\": " << calls_ << ",\n  \"repetitions\": " << repetitions_ << ",\n";
+  out << "  \"clearance\": " << clearance_ << ",\n  \"turn_radius\": " << turn_radius_ << ",\n";
+  out << "  \"results\": [\n";
+  for (unsigned int i = 0; i < results_.size(); i++)
+  {
+    out << "    {\"kernel\": \"" << results_[i].kernel << "\", \"obstacles\": " << results_[i].obstacles
+        << ", \"map_seed\": " << results_[i].map_seed << ", \"size\": " << results_[i].size
+        << ", \"calls\": " << results_[i].calls << ", \"median_ns\": " << results_[i].median_ns
+        << ", \"min_ns\": " << results_[i].min_ns << ", \"true_fraction\": " << results_[i].true_fraction << "}"
+        << (i + 1 < results_.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return true;
+}
+} // end namespace theseus
+
+//********************************************************//
+//************************ MAIN **************************//
+//********************************************************//
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "theseus_benchmark");
+  ros::NodeHandle nh("~");
+  std::vector<int> obstacles, seeds, tree_sizes;
+  if (!nh.getParam("obstacles", obstacles))
+  {
+    obstacles.push_back(10);
+    obstacles.push_back(30);
+    obstacles.push_back(60);
+  }
+  if (!nh.getParam("seeds", seeds))
+    seeds.push_back(1);
+  if (!nh.getParam("tree_sizes", tree_sizes))
+  {
+    tree_sizes.push_back(100);
+    tree_sizes.push_back(1000);
+    tree_sizes.push_back(5000);
+  }
+  int calls, repetitions;
+  std::string output;
+  nh.param<int>("calls", calls, 20000);
+  nh.param<int>("repetitions", repetitions, 7);
+  nh.param<std::string>("output", output, "theseus_benchmark.json");
+
+  theseus::KernelBenchmark bench(calls > 0 ? calls : 1, repetitions);
+  for (unsigned int o = 0; o < obstacles.size(); o++)
+    for (unsigned int s = 0; s < seeds.size(); s++)
+      bench.run(obstacles[o], seeds[s], tree_sizes);
+  if (bench.write(output) == false)
+  {
+    ROS_ERROR("couldn't write %s", output.c_str());
+    return 1;
+  }
+  ROS_INFO("results written to %s", output.c_str());
+  return 0;
+} // end main
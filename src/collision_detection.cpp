@@ -5,7 +5,12 @@ namespace theseus
 {
 CollisionDetection::CollisionDetection()
 {
-
+  check_counter_ = NULL;
+}
+CollisionDetection::CollisionDetection(planner_config_s config)
+{
+  input_file_    = config;
+  check_counter_ = NULL;
 }
 CollisionDetection::~CollisionDetection()
 {
@@ -42,7 +47,7 @@ bool CollisionDetection::checkFillet(fillet_s fil, float clearance)
     chi2 -= 2.0f*M_PI;
   if (chi2 < 5.0f*M_PI/180.0 && chi2 > -5.0f*M_PI/180.0)
   {
-    // ROS_DEBUG("line exit 23");
+    // THESEUS_DEBUG("line exit 23");
     return false;
   }
 
@@ -53,9 +58,11 @@ bool CollisionDetection::checkFillet(fillet_s fil, float clearance)
 }
 bool CollisionDetection::checkPoint(NED_s point, float clearance)
 {
+  if (check_counter_ != NULL)
+    check_counter_->fetch_add(1, std::memory_order_relaxed);
   if (checkWithinBoundaries(point, clearance) == false)
   {
-    // ROS_DEBUG("point is not within boundaries");
+    // THESEUS_DEBUG("point is not within boundaries");
     return false;
   }
   // Check to see if the point is within the right fly altitudes
@@ -63,7 +70,7 @@ bool CollisionDetection::checkPoint(NED_s point, float clearance)
   {
     if (-point.D < minFlyHeight_ + clearance || -point.D > maxFlyHeight_ - clearance)
     {
-      // ROS_DEBUG("point is not in flying zone");
+      // THESEUS_DEBUG("point is not in flying zone");
       return false;
     }
   }
@@ -72,7 +79,7 @@ bool CollisionDetection::checkPoint(NED_s point, float clearance)
 	for (unsigned int i = 0; i < map_.cylinders.size(); i++)
 		if (sqrtf(powf(point.N - map_.cylinders[i].N, 2.0f) + powf(point.E - map_.cylinders[i].E, 2.0f)) < map_.cylinders[i].R + clearance && -point.D - clearance < map_.cylinders[i].H)
 		{
-      // ROS_DEBUG("point violates obstacle");
+      // THESEUS_DEBUG("point violates obstacle");
       return false;
     }
 	return true; // The coordinate is in the safe zone if it got to here!
@@ -125,9 +132,11 @@ bool CollisionDetection::checkWithinBoundaries(NED_s point, float clearance)
 }
 bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 {
+  if (check_counter_ != NULL)
+    check_counter_->fetch_add(1, std::memory_order_relaxed);
   if (checkClimbAngle(ps, pe) == false)
   {
-    // ROS_DEBUG("line exit 22, checkClimbAngle");
+    // THESEUS_DEBUG("line exit 22, checkClimbAngle");
     return false;
   }
   // Determines if a line conn ps and pe gets within clearance of any obstacle or boundary
@@ -157,7 +166,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 				crossed_lines_ps++;
 			else if (ps.N == line_Mandb_[i][0] * ps.E + line_Mandb_[i][1])
       {
-        // ROS_DEBUG("line exit 1");
+        // THESEUS_DEBUG("line exit 1");
         return false;
       }
 		}
@@ -167,7 +176,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 				crossed_lines_pe++;
 			else if (pe.N == line_Mandb_[i][0] * pe.E + line_Mandb_[i][1])
       {
-        // ROS_DEBUG("line exit 2");
+        // THESEUS_DEBUG("line exit 2");
         return false;
       }
 		}
@@ -177,12 +186,12 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 		// Check distance between each endpoint
 		if (sqrtf(powf(ps.N - map_.boundary_pts[i].N, 2.0f) + powf(ps.E - map_.boundary_pts[i].E, 2.0f) < clearance))
     {
-      // ROS_DEBUG("line exit 3");
+      // THESEUS_DEBUG("line exit 3");
       return false;
     }
 		if (sqrtf(powf(pe.N - map_.boundary_pts[i].N, 2.0f) + powf(pe.E - map_.boundary_pts[i].E, 2.0f) < clearance))
     {
-      // ROS_DEBUG("line exit 4");
+      // THESEUS_DEBUG("line exit 4");
       return false;
     }
 		// Check if they intersect
@@ -193,13 +202,13 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 			if (Ni > pathMinMax[0] && Ni < pathMinMax[1])
 				if (Ni > lineMinMax_[i][0] && Ni < lineMinMax_[i][1])
         {
-          // ROS_DEBUG("line exit 5");
+          // THESEUS_DEBUG("line exit 5");
 
-          // ROS_DEBUG("Ni %f, Ei %f",Ni, Ei );
-          // ROS_DEBUG("line %f %f, %f %f",ps.N, ps.E, pe.N, pe.E);
-          // ROS_DEBUG("bd %f %f, %f %f", map_.boundary_pts[i].N,map_.boundary_pts[i].E, map_.boundary_pts[(i + 1) % nBPts_].N, map_.boundary_pts[(i + 1) % nBPts_].E);
-          // ROS_DEBUG("pathMinMax %f %f", pathMinMax[0], pathMinMax[1]);
-          // ROS_DEBUG("lineMinMax_ %f %f", lineMinMax_[i][0], lineMinMax_[i][1]);
+          // THESEUS_DEBUG("Ni %f, Ei %f",Ni, Ei );
+          // THESEUS_DEBUG("line %f %f, %f %f",ps.N, ps.E, pe.N, pe.E);
+          // THESEUS_DEBUG("bd %f %f, %f %f", map_.boundary_pts[i].N,map_.boundary_pts[i].E, map_.boundary_pts[(i + 1) % nBPts_].N, map_.boundary_pts[(i + 1) % nBPts_].E);
+          // THESEUS_DEBUG("pathMinMax %f %f", pathMinMax[0], pathMinMax[1]);
+          // THESEUS_DEBUG("lineMinMax_ %f %f", lineMinMax_[i][0], lineMinMax_[i][1]);
           return false;
         }
 		}
@@ -217,20 +226,20 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 		lp_cleared = lineAndPoint2d(map_.boundary_pts[i], map_.boundary_pts[(i + 1) % nBPts_], lMinMax, l_Mandb, ps, clearance);
 		if (lp_cleared == false)
     {
-      // ROS_DEBUG("line exit 6");
+      // THESEUS_DEBUG("line exit 6");
       return false;
     }
 		lp_cleared = lineAndPoint2d(map_.boundary_pts[i], map_.boundary_pts[(i + 1) % nBPts_], lMinMax, l_Mandb, pe, clearance);
 		if (lp_cleared == false)
     {
-      // ROS_DEBUG("line exit 7");
+      // THESEUS_DEBUG("line exit 7");
       return false;
     }
 		// Check distance from pl to each boundary end point
 		lp_cleared = lineAndPoint2d(ps, pe, pathMinMax, path_Mandb, map_.boundary_pts[i], clearance);
 		if (lp_cleared == false)
     {
-      // ROS_DEBUG("line exit 8");
+      // THESEUS_DEBUG("line exit 8");
       return false;
     }
 		//^^^^^^^^^^^^^^^^^^^^^^^^^^^^ Check if any point on the line gets too close to the boundary ^^^^^^^^^^^^^^^^^^^^^^^^^^^^
@@ -241,7 +250,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 	withinBoundaries_pe = crossed_lines_pe % 2;
 	if (withinBoundaries_ps == false || withinBoundaries_pe == false)
   {
-    // ROS_DEBUG("line exit 9");
+    // THESEUS_DEBUG("line exit 9");
     return false;
   }
 	// ^^^^^^^^^^^^^^^^ Finish up checking if the end points were both inside the boundary (ray casting) ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
@@ -251,12 +260,12 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 	{
 		if (-ps.D < minFlyHeight_ + clearance || -ps.D > maxFlyHeight_ - clearance)
     {
-      // ROS_DEBUG("line exit 10");
+      // THESEUS_DEBUG("line exit 10");
       return false;
     }
 		if (-pe.D < minFlyHeight_ + clearance || -pe.D > maxFlyHeight_ - clearance)
     {
-      // ROS_DEBUG("line exit 11");
+      // THESEUS_DEBUG("line exit 11");
       return false;
     }
 	}
@@ -290,12 +299,12 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 			{// if BOTH of the endpoints is within the 2d cylinder
 				if (-ps.D < map_.cylinders[i].H + clearance)
         {
-          // ROS_DEBUG("line exit 12");
+          // THESEUS_DEBUG("line exit 12");
           return false;
         }
-				if (-ps.D < map_.cylinders[i].H + clearance)
+				if (-pe.D < map_.cylinders[i].H + clearance)
         {
-          // ROS_DEBUG("line exit 13");
+          // THESEUS_DEBUG("line exit 13");
           return false;
         }
 			}
@@ -305,7 +314,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 				{// if the starting point is within the 2d cylinder
 					if (-ps.D < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 14");
+            // THESEUS_DEBUG("line exit 14");
             return false;
           }
 					// else (check to see if the line that intersects the cylinder is in or out)
@@ -316,7 +325,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 						d2cyl = bigLength - smallLength;
 					if (-(dD*d2cyl + ps.D) < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 15");
+            // THESEUS_DEBUG("line exit 15");
             return false;
           }
 				}
@@ -324,7 +333,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 				{// if the ending point is within the 2d cylinder
 					if (-pe.D < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 16");
+            // THESEUS_DEBUG("line exit 16");
             return false;
           }
 					// else check to see if the line that intersects the cylinder is in or out
@@ -335,7 +344,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 						d2cyl = bigLength - smallLength;
 					if (-(-dD*d2cyl + pe.D) < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 17");
+            // THESEUS_DEBUG("line exit 17");
             return false;
           }
 				}
@@ -357,17 +366,17 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 
 					if (-(Di + dD*daway_from_int) < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 18");
+            // THESEUS_DEBUG("line exit 18");
             return false;
           }
 					if (-(Di - dD*daway_from_int) < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 19");
+            // THESEUS_DEBUG("line exit 19");
             return false;
           }
 					if (-Di < map_.cylinders[i].H + clearance)
           {
-            // ROS_DEBUG("line exit 20");
+            // THESEUS_DEBUG("line exit 20");
             return false;
           }
 				}
@@ -376,7 +385,7 @@ bool CollisionDetection::checkLine(NED_s ps, NED_s pe, float clearance)
 		}
 		if (clearThisCylinder == false)
     {
-      // ROS_DEBUG("line exit 21");
+      // THESEUS_DEBUG("line exit 21");
       return false;
     }
 	}
@@ -390,7 +399,7 @@ bool CollisionDetection::checkClimbAngle(NED_s beg, NED_s en)
   float slope = atan2f(-1.0f*(en.D - beg.D), sqrtf(powf(beg.N - en.N, 2.0f) + powf(beg.E - en.E, 2.0f)));
   if (slope < -1.0f*input_file_.max_descend_angle || slope > input_file_.max_climb_angle)
   {
-    // ROS_DEBUG("slope %f, de %f, climb %f", slope*180.0/M_PI, -input_file_.max_descend_angle*180.0/M_PI, input_file_.max_climb_angle*180.0/M_PI);
+    // THESEUS_DEBUG("slope %f, de %f, climb %f", slope*180.0/M_PI, -input_file_.max_descend_angle*180.0/M_PI, input_file_.max_climb_angle*180.0/M_PI);
     return false;
   }
   return true;
@@ -469,6 +478,8 @@ bool CollisionDetection::checkAfterWP(NED_s p, float chi, float clearance)
 }
 bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lambda, float clearance)
 {
+  if (check_counter_ != NULL)
+    check_counter_->fetch_add(1, std::memory_order_relaxed);
   float r  = clearance;
   bool ccw = lambda < 0 ? true : false; // ccw = lambda(-1),
   float aradius = R;
@@ -489,7 +500,7 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   			crossed_lines_ps++;
   		else if (ps.N == line_Mandb_[i][0] * ps.E + line_Mandb_[i][1])
   		{
-        // ROS_DEBUG("circle exit 1");
+        // THESEUS_DEBUG("circle exit 1");
         return false;
       }
   	}
@@ -499,7 +510,7 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   			crossed_lines_pe++;
   		else if (pe.N == line_Mandb_[i][0] * pe.E + line_Mandb_[i][1])
       {
-        // ROS_DEBUG("circle exit 2");
+        // THESEUS_DEBUG("circle exit 2");
         return false;
       }
   	}
@@ -520,7 +531,7 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   			{
   				if (sqrtf(powf(Ni - cp.N, 2.0f) + powf(Ei - cp.E, 2.0f)) - aradius < r)
   				{
-            // ROS_DEBUG("circle exit 3");
+            // THESEUS_DEBUG("circle exit 3");
             return false;
   				}
   			}
@@ -533,13 +544,13 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   				{
   					if (sqrtf(powf(Ni - ps.N, 2.0f) + powf(Ei - ps.E, 2.0f)) < r)
   					{
-              // ROS_DEBUG("circle exit 4");
+              // THESEUS_DEBUG("circle exit 4");
   						return false;
   					}
   				}
   				else if (sqrtf(powf(map_.boundary_pts[i].N - ps.N, 2.0f) + powf(map_.boundary_pts[i].E - ps.E, 2.0f)) < r)
   				{
-            // ROS_DEBUG("circle exit 5");
+            // THESEUS_DEBUG("circle exit 5");
   					return false;
   				}
   				else if (sqrtf(powf(map_.boundary_pts[(i + 1) % nBPts_].N - ps.N, 2.0f) + powf(map_.boundary_pts[(i + 1) % nBPts_].E - ps.E, 2.0f)) < r) { return false; }
@@ -550,13 +561,13 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   				{
   					if (sqrtf(powf(Ni - pe.N, 2.0f) + powf(Ei - pe.E, 2.0f)) < r)
   					{
-              // ROS_DEBUG("circle exit 6");
+              // THESEUS_DEBUG("circle exit 6");
   						return false;
   					}
   				}
   				else if (sqrtf(powf(map_.boundary_pts[i].N - pe.N, 2.0f) + powf(map_.boundary_pts[i].E - pe.E, 2.0f)) < r)
   				{
-            // ROS_DEBUG("circle exit 7");
+            // THESEUS_DEBUG("circle exit 7");
   					return false;
   				}
   				//else if (sqrtf(powf(map_.boundary_pts[(i + 1) % nBPts_].N - pe.N, 2.0f) + powf(map_.boundary_pts[(i + 1) % nBPts_].E - pe.E, 2.0f)) < r) { return false; }
@@ -568,7 +579,7 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   			{
   				if (sqrtf(powf(map_.boundary_pts[i].N - cp.N, 2.0f) + powf(map_.boundary_pts[i].E - cp.E, 2.0f)) - aradius < r)
   				{
-            // ROS_DEBUG("circle exit 8");
+            // THESEUS_DEBUG("circle exit 8");
   					return false;
   				}
   			}
@@ -578,12 +589,12 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   			//}
   			if (sqrtf(powf(map_.boundary_pts[i].N - ps.N, 2.0f) + powf(map_.boundary_pts[i].E - ps.E, 2.0f)) - aradius < r)
   			{
-          // ROS_DEBUG("circle exit 9");
+          // THESEUS_DEBUG("circle exit 9");
   				return false;
   			}
   			if (sqrtf(powf(map_.boundary_pts[i].N - pe.N, 2.0f) + powf(map_.boundary_pts[i].E - pe.E, 2.0f)) - aradius < r)
   			{
-          // ROS_DEBUG("circle exit 10");
+          // THESEUS_DEBUG("circle exit 10");
   				return false;
   			}
   			//if (sqrtf(powf(map_.boundary_pts[(i + 1) % nBPts_].N - ps.N, 2.0f) + powf(map_.boundary_pts[(i + 1) % nBPts_].E - ps.E, 2.0f)) - aradius < r) { return false; }
@@ -597,7 +608,7 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   withinBoundaries_pe = crossed_lines_pe % 2;
   if (withinBoundaries_ps == false || withinBoundaries_pe == false)
   {
-    // ROS_DEBUG("circle exit 11");
+    // THESEUS_DEBUG("circle exit 11");
     return false;
   }
   // ^^^^^^^^^^^^^^^^ Finish up checking if the end points were both inside the boundary (ray casting) ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
@@ -607,12 +618,12 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   {
   	if (-ps.D < minFlyHeight_ + r || -ps.D > maxFlyHeight_ - r)
     {
-      // ROS_DEBUG("circle exit 12");
+      // THESEUS_DEBUG("circle exit 12");
       return false;
     }
   	if (-pe.D < minFlyHeight_ + r || -pe.D > maxFlyHeight_ - r)
     {
-      // ROS_DEBUG("circle exit 13");
+      // THESEUS_DEBUG("circle exit 13");
       return false;
     }
   }
@@ -634,44 +645,44 @@ bool CollisionDetection::checkArc(NED_s ps, NED_s pe, float R, NED_s cp, int lam
   	if (sqrtf(powf(map_.cylinders[i].N - cp.N, 2.0f) + powf(map_.cylinders[i].E - cp.E, 2.0f)) > r + aradius + map_.cylinders[i].R)
   	{
       clearThisCylinder = true;
-      // ROS_DEBUG("circle passed clearThisCylinder,%i, arc is too far away from the cylinder", i);
+      // THESEUS_DEBUG("circle passed clearThisCylinder,%i, arc is too far away from the cylinder", i);
     }
   	else if (lineIntersectsArc(map_.cylinders[i].N, map_.cylinders[i].E, cp, ps, pe, ccw))
   	{
-      // ROS_DEBUG("line intersects the arc");
+      // THESEUS_DEBUG("line intersects the arc");
       float d_to_arc = sqrtf(powf(map_.cylinders[i].N - cp.N, 2.0f) + powf(map_.cylinders[i].E - cp.E, 2.0f)) - aradius;
       if (fabs(d_to_arc) < r +  map_.cylinders[i].R)
       {
         clearThisCylinder = false;
-        // ROS_DEBUG("circle exit 900, arc is too close to a cylinder");
+        // THESEUS_DEBUG("circle exit 900, arc is too close to a cylinder");
       }
   	}
   	else
   	{
   		if (sqrtf(powf(map_.cylinders[i].N - ps.N, 2.0f) + powf(map_.cylinders[i].E - ps.E, 2.0f)) - map_.cylinders[i].R < r)
   		{
-        // ROS_DEBUG("circle exit 901, starting point is too close to the cylinder");
+        // THESEUS_DEBUG("circle exit 901, starting point is too close to the cylinder");
   			clearThisCylinder = false;
   		}
   		else if (sqrtf(powf(map_.cylinders[i].N - pe.N, 2.0f) + powf(map_.cylinders[i].E - pe.E, 2.0f)) - map_.cylinders[i].R < r)
   		{
-        // ROS_DEBUG("circle exit 902, ending point is too close to the cylinder");
+        // THESEUS_DEBUG("circle exit 902, ending point is too close to the cylinder");
   			clearThisCylinder = false;
   		}
   		else { clearThisCylinder = true; }
   	}
   	if (clearThisCylinder == false)
   	{
-      // ROS_DEBUG("clearThisCylinder = false if statement");
+      // THESEUS_DEBUG("clearThisCylinder = false if statement");
   		if (ps.D < -map_.cylinders[i].H - r && pe.D < -map_.cylinders[i].H - r)
   		{
-        // ROS_DEBUG("circle clear exception %i", i);
+        // THESEUS_DEBUG("circle clear exception %i", i);
         clearThisCylinder = true;
       }
   	}
   	if (clearThisCylinder == false)
     {
-      // ROS_DEBUG("circle exit 999 %i", i);
+      // THESEUS_DEBUG("circle exit 999 %i", i);
       return false;
     }
   }
@@ -720,10 +731,10 @@ bool CollisionDetection::lineIntersectsArc(float Ni, float Ei, NED_s cp, NED_s p
 	float aC2i = atan2f(Ni - cp.N, Ei - cp.E);
 	// Do they overlap?
 
-  // ROS_DEBUG("aC2s %f, aC2e %f, aC2i %f", aC2s*180.0/M_PI, aC2e*180.0/M_PI, aC2i*180.0/M_PI);
+  // THESEUS_DEBUG("aC2s %f, aC2e %f, aC2i %f", aC2s*180.0/M_PI, aC2e*180.0/M_PI, aC2i*180.0/M_PI);
 	if (ccw)
 	{
-    // ROS_DEBUG("ccw");
+    // THESEUS_DEBUG("ccw");
     aC2i -= aC2s;
     aC2e -= aC2s;
     aC2s -= aC2s;
@@ -736,7 +747,7 @@ bool CollisionDetection::lineIntersectsArc(float Ni, float Ei, NED_s cp, NED_s p
 	}
 	else
 	{
-    // ROS_DEBUG("cw");
+    // THESEUS_DEBUG("cw");
     aC2i -= aC2e;
     aC2s -= aC2e;
     aC2e -= aC2e;
@@ -750,6 +761,10 @@ bool CollisionDetection::lineIntersectsArc(float Ni, float Ei, NED_s cp, NED_s p
 	return false;
 }
 
+void CollisionDetection::countChecks(std::atomic<unsigned long>* counter)
+{
+  check_counter_ = counter;
+}
 void CollisionDetection::newMap(map_s map_in)
 {
   for (unsigned int i = 0; i < lineMinMax_.size(); i++)
@@ -814,15 +829,15 @@ void CollisionDetection::newMap(map_s map_in)
 // Debug print functions
 void CollisionDetection::printBoundsObstacles()
 {
-  ROS_INFO("Number of Boundary Points: %lu",  map_.boundary_pts.size());
+  THESEUS_INFO("Number of Boundary Points: %lu",  map_.boundary_pts.size());
   for (long unsigned int i = 0; i < map_.boundary_pts.size(); i++)
   {
-    ROS_INFO("Boundary: %lu, North: %f, East: %f, Down: %f", i, map_.boundary_pts[i].N, map_.boundary_pts[i].E, map_.boundary_pts[i].D);
+    THESEUS_INFO("Boundary: %lu, North: %f, East: %f, Down: %f", i, map_.boundary_pts[i].N, map_.boundary_pts[i].E, map_.boundary_pts[i].D);
   }
-  ROS_INFO("Number of Cylinders: %lu", map_.cylinders.size());
+  THESEUS_INFO("Number of Cylinders: %lu", map_.cylinders.size());
   for (long unsigned int i = 0; i <  map_.cylinders.size(); i++)
   {
-    ROS_INFO("Cylinder: %lu, North: %f, East: %f, Radius: %f, Height: %f", i, map_.cylinders[i].N, map_.cylinders[i].E, map_.cylinders[i].R,  map_.cylinders[i].H);
+    THESEUS_INFO("Cylinder: %lu, North: %f, East: %f, Radius: %f, Height: %f", i, map_.cylinders[i].N, map_.cylinders[i].E, map_.cylinders[i].R,  map_.cylinders[i].H);
   }
 }
 } // end namespace theseus
@@ -0,0 +1,387 @@
+/*	DESCRIPTION:
+ *	Differential check of CollisionDetection against the CollisionOracle.
+ *	Maps are made by the mapper from consecutive seeds, and on each one
+ *	random points, lines and arcs (fillets and loose arcs) are checked by
+ *	both. Half of them are drawn close to a cylinder, a cylinder top or a
+ *	boundary corner, where the kernels are most likely to be wrong. A case
+ *	where the oracle's margin is within the tolerance of 0 can go either
+ *	way, outside of it the two have to agree.
+ *
+ *	A kernel that says clear where the oracle finds the clearance broken is
+ *	unsafe, one that rejects a clear case is only conservative. Any change
+ *	to the collision kernels (SIMD, spatial indexes, caches, distance
+ *	fields) has to come out of this with no unsafe cases before it is used.
+ *	The counts and the first few mismatches of each kind are written as
+ *	JSON, the exit code is 1 if anything was unsafe.
+ *
+ *	rosrun theseus theseus_collision_differential _maps:=2000 _cases:=100 _tolerance:=0.1 _output:=collision.json
+ *	(the pp and ppsim parameters have to be loaded, see param/path_planning.yaml)
+ *
+ */
+#include <vector>
+#include <string>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <ros/ros.h>
+
+#include <theseus/map_s.h>
+#include <theseus/mapper.h>
+#include <theseus/fillet_s.h>
+#include <theseus/rand_gen.h>
+#include <theseus/param_reader.h>
+#include <theseus/ros_log.h>
+#include <theseus/collision_detection.h>
+#include <theseus/collision_oracle.h>
+
+namespace theseus
+{
+enum diff_kernel_e
+{
+  DIFF_POINT,
+  DIFF_LINE,
+  DIFF_ARC,
+  NUM_DIFF_KERNELS
+};
+static const char* kernel_names[NUM_DIFF_KERNELS] = {"checkPoint", "checkLine", "checkArc"};
+static const char* constraint_names[] = {"none", "boundary", "altitude", "cylinder", "climb"};
+struct diff_counts_s
+{
+  unsigned long cases;
+  unsigned long agree;
+  unsigned long borderline;       // the oracle's margin is within the tolerance, either answer is fine
+  unsigned long unsafe;           // the kernel said clear, the oracle found the clearance broken
+  unsigned long conservative;     // the kernel said no, the oracle found it clear
+  double worst_unsafe;            // most negative margin the kernel said was clear (m)
+};
+struct diff_mismatch_s
+{
+  diff_kernel_e kernel;
+  int seed;
+  unsigned int case_number;
+  bool unsafe;
+  std::string inputs;             // the call, so it can be repeated
+  oracle_margin_s margin;
+};
+class CollisionDifferential
+{
+public:
+  CollisionDifferential(double step, double tolerance, unsigned int cases, unsigned int report);
+  void run(int first_seed, int maps);
+  bool write(std::string file);
+  unsigned long unsafe();
+private:
+  void checkMap(int seed, map_s map);
+  void compare(diff_kernel_e kernel, int seed, unsigned int case_number, bool clear, oracle_margin_s margin, std::string inputs);
+  NED_s randomPoint(RandGen* rg, map_s* map);
+  void randomLine(RandGen* rg, map_s* map, NED_s* ps, NED_s* pe);
+  void randomArc(RandGen* rg, map_s* map, NED_s* ps, NED_s* pe, float* R, NED_s* cp, int* lambda);
+  planner_config_s config_;
+  double step_;
+  double tolerance_;
+  float clearance_;
+  unsigned int cases_;            // of each kernel on each map
+  unsigned int report_;           // mismatches of each kind kept for the output
+  int first_seed_;
+  int maps_;
+  diff_counts_s counts_[NUM_DIFF_KERNELS];
+  std::vector<diff_mismatch_s> mismatches_;
+  unsigned long unsafe_kept_;
+  unsigned long conservative_kept_;
+};
+CollisionDifferential::CollisionDifferential(double step, double tolerance, unsigned int cases, unsigned int report)
+{
+  config_     = ParamReader();
+  logToRosconsole(config_.console_level);
+  step_       = step;
+  tolerance_  = tolerance;
+  clearance_  = config_.clearance;
+  cases_      = cases;
+  report_     = report;
+  first_seed_ = 0;
+  maps_       = 0;
+  unsafe_kept_       = 0;
+  conservative_kept_ = 0;
+  for (unsigned int k = 0; k < NUM_DIFF_KERNELS; k++)
+  {
+    counts_[k].cases        = 0;
+    counts_[k].agree        = 0;
+    counts_[k].borderline   = 0;
+    counts_[k].unsafe       = 0;
+    counts_[k].conservative = 0;
+    counts_[k].worst_unsafe = 0.0;
+  }
+}
+void CollisionDifferential::run(int first_seed, int maps)
+{
+  first_seed_ = first_seed;
+  maps_       = maps;
+  for (int m = 0; m < maps && ros::ok(); m++)
+  {
+    mapper myWorld(first_seed + m, &config_);
+    checkMap(first_seed + m, myWorld.map);
+    if ((m + 1) % 100 == 0)
+      ROS_INFO("%i maps, %lu unsafe, %lu conservative so far", m + 1,
+               counts_[DIFF_POINT].unsafe + counts_[DIFF_LINE].unsafe + counts_[DIFF_ARC].unsafe,
+               counts_[DIFF_POINT].conservative + counts_[DIFF_LINE].conservative + counts_[DIFF_ARC].conservative);
+  }
+}
+void CollisionDifferential::checkMap(int seed, map_s map)
+{
+  CollisionDetection col_det(config_);
+  col_det.newMap(map);
+  CollisionOracle oracle(config_, step_);
+  oracle.newMap(map);
+  RandGen rg(seed, true);         // its own sequence, the cases only depend on the seed
+  char inputs[512];
+  for (unsigned int j = 0; j < cases_; j++)
+  {
+    // Now and then the heights aren't checked, like while taking off or landing.
+    bool no_heights = rg.randLin() < 0.1;
+    col_det.taking_off_  = no_heights;
+    col_det.landing_now_ = false;
+    oracle.taking_off_   = no_heights;
+    oracle.landing_now_  = false;
+
+    NED_s p = randomPoint(&rg, &map);
+    snprintf(inputs, sizeof(inputs), "checkPoint(NED_s(%.9g, %.9g, %.9g), %.9g), taking_off_ %i", p.N, p.E, p.D, clearance_,
+             no_heights);
+    compare(DIFF_POINT, seed, j, col_det.checkPoint(p, clearance_), oracle.point(p, clearance_), inputs);
+
+    NED_s ps, pe;
+    randomLine(&rg, &map, &ps, &pe);
+    snprintf(inputs, sizeof(inputs), "checkLine(NED_s(%.9g, %.9g, %.9g), NED_s(%.9g, %.9g, %.9g), %.9g), taking_off_ %i",
+             ps.N, ps.E, ps.D, pe.N, pe.E, pe.D, clearance_, no_heights);
+    compare(DIFF_LINE, seed, j, col_det.checkLine(ps, pe, clearance_), oracle.line(ps, pe, clearance_), inputs);
+
+    NED_s cp;
+    float R;
+    int lambda;
+    randomArc(&rg, &map, &ps, &pe, &R, &cp, &lambda);
+    snprintf(inputs, sizeof(inputs), "checkArc(NED_s(%.9g, %.9g, %.9g), NED_s(%.9g, %.9g, %.9g), %.9g, NED_s(%.9g, %.9g, %.9g), "
+             "%i, %.9g), taking_off_ %i", ps.N, ps.E, ps.D, pe.N, pe.E, pe.D, R, cp.N, cp.E, cp.D, lambda, clearance_,
+             no_heights);
+    compare(DIFF_ARC, seed, j, col_det.checkArc(ps, pe, R, cp, lambda, clearance_),
+            oracle.arc(ps, pe, R, cp, lambda, clearance_), inputs);
+  }
+}
+void CollisionDifferential::compare(diff_kernel_e kernel, int seed, unsigned int case_number, bool clear, oracle_margin_s margin,
+                                    std::string inputs)
+{
+  diff_counts_s& counts = counts_[kernel];
+  counts.cases++;
+  if (fabs(margin.margin) <= tolerance_)
+  {
+    counts.borderline++;
+    return;
+  }
+  bool oracle_clear = margin.margin > 0.0;
+  if (clear == oracle_clear)
+  {
+    counts.agree++;
+    return;
+  }
+  if (clear)
+  {
+    counts.unsafe++;
+    counts.worst_unsafe = std::min(counts.worst_unsafe, margin.margin);
+    if (unsafe_kept_++ >= report_)
+      return;
+  }
+  else
+  {
+    counts.conservative++;
+    if (conservative_kept_++ >= report_)
+      return;
+  }
+  diff_mismatch_s mismatch;
+  mismatch.kernel      = kernel;
+  mismatch.seed        = seed;
+  mismatch.case_number = case_number;
+  mismatch.unsafe      = clear;
+  mismatch.inputs      = inputs;
+  mismatch.margin      = margin;
+  mismatches_.push_back(mismatch);
+  ROS_WARN("map %i case %u: %s says %s, the oracle's margin is %.3f m (%s %i at N %.2f E %.2f D %.2f)\n  %s", seed,
+           case_number, kernel_names[kernel], clear ? "clear" : "not clear", margin.margin,
+           constraint_names[margin.constraint], margin.index, margin.where.N, margin.where.E, margin.where.D, inputs.c_str());
+}
+NED_s CollisionDifferential::randomPoint(RandGen* rg, map_s* map)
+{
+  // Half anywhere around the map, the other half where the clearance is decided: by a cylinder, over one or by a
+  // boundary corner.
+  double min_N = 0.0, max_N = 0.0, min_E = 0.0, max_E = 0.0;
+  for (unsigned int i = 0; i < map->boundary_pts.size(); i++)
+  {
+    min_N = i == 0 ? map->boundary_pts[i].N : std::min(min_N, map->boundary_pts[i].N);
+    max_N = i == 0 ? map->boundary_pts[i].N : std::max(max_N, map->boundary_pts[i].N);
+    min_E = i == 0 ? map->boundary_pts[i].E : std::min(min_E, map->boundary_pts[i].E);
+    max_E = i == 0 ? map->boundary_pts[i].E : std::max(max_E, map->boundary_pts[i].E);
+  }
+  NED_s p;
+  p.D = -(config_.minFlyHeight - 20.0 + rg->randLin()*(config_.maxFlyHeight - config_.minFlyHeight + 40.0));
+  double where = rg->randLin();
+  if (where < 0.5 || (map->cylinders.size() == 0 && map->boundary_pts.size() == 0))
+  {
+    p.N = min_N - clearance_ + rg->randLin()*(max_N - min_N + 2.0*clearance_);
+    p.E = min_E - clearance_ + rg->randLin()*(max_E - min_E + 2.0*clearance_);
+  }
+  else if ((where < 0.85 && map->cylinders.size() > 0) || map->boundary_pts.size() == 0)
+  {
+    cyl_s cyl = map->cylinders[rg->UINT() % map->cylinders.size()];
+    double angle    = rg->randLin()*2.0*M_PI;
+    double distance = cyl.R + clearance_*(1.0 + 3.0*(rg->randLin() - 0.5));
+    p.N = cyl.N + distance*sin(angle);
+    p.E = cyl.E + distance*cos(angle);
+    if (rg->randLin() < 0.5)
+      p.D = -(cyl.H + clearance_ + 20.0*(rg->randLin() - 0.5));
+  }
+  else
+  {
+    NED_s corner    = map->boundary_pts[rg->UINT() % map->boundary_pts.size()];
+    double angle    = rg->randLin()*2.0*M_PI;
+    double distance = 2.0*clearance_*rg->randLin();
+    p.N = corner.N + distance*sin(angle);
+    p.E = corner.E + distance*cos(angle);
+  }
+  return p;
+}
+void CollisionDifferential::randomLine(RandGen* rg, map_s* map, NED_s* ps, NED_s* pe)
+{
+  double chi;
+  if (rg->randLin() < 0.3 && map->cylinders.size() > 0)
+  {
+    // Passes a cylinder about the clearance away at its closest.
+    cyl_s cyl = map->cylinders[rg->UINT() % map->cylinders.size()];
+    double angle    = rg->randLin()*2.0*M_PI;
+    double distance = cyl.R + clearance_*(1.0 + 2.0*(rg->randLin() - 0.5));
+    NED_s closest(cyl.N + distance*cos(angle), cyl.E + distance*sin(angle), randomPoint(rg, map).D);
+    chi = angle + M_PI/2.0;
+    double before = 10.0 + 190.0*rg->randLin();
+    double after  = 10.0 + 190.0*rg->randLin();
+    *ps = NED_s(closest.N - before*cos(chi), closest.E - before*sin(chi), closest.D);
+    *pe = NED_s(closest.N + after*cos(chi), closest.E + after*sin(chi), closest.D);
+  }
+  else
+  {
+    *ps = randomPoint(rg, map);
+    chi = rg->randLin()*2.0*M_PI;
+    double length = 5.0 + 395.0*rg->randLin();
+    *pe = NED_s(ps->N + length*cos(chi), ps->E + length*sin(chi), ps->D);
+  }
+  // Up to a bit more than the planes can climb or descend, so the climb angle check is on both sides of its limit.
+  double horizontal = sqrt(pow(pe->N - ps->N, 2.0) + pow(pe->E - ps->E, 2.0));
+  double gamma = -1.2*config_.max_descend_angle + rg->randLin()*1.2*(config_.max_climb_angle + config_.max_descend_angle);
+  pe->D = ps->D - horizontal*tan(gamma);
+}
+void CollisionDifferential::randomArc(RandGen* rg, map_s* map, NED_s* ps, NED_s* pe, float* R, NED_s* cp, int* lambda)
+{
+  if (rg->randLin() < 0.5)
+  {
+    // A fillet, like the planner makes.
+    NED_s w_im1 = randomPoint(rg, map);
+    double chi  = rg->randLin()*2.0*M_PI;
+    double turn = (rg->randLin() - 0.5)*300.0*M_PI/180.0;
+    double l1   = 60.0 + 240.0*rg->randLin();
+    double l2   = 60.0 + 240.0*rg->randLin();
+    NED_s w_i(w_im1.N + l1*cos(chi), w_im1.E + l1*sin(chi), w_im1.D);
+    NED_s w_ip1(w_i.N + l2*cos(chi + turn), w_i.E + l2*sin(chi + turn), w_i.D);
+    fillet_s fil;
+    fil.calculate(w_im1, w_i, w_ip1, config_.turn_radius);
+    *ps     = fil.z1;
+    *pe     = fil.z2;
+    *R      = fil.R;
+    *cp     = fil.c;
+    *lambda = fil.lambda;
+    return;
+  }
+  // Any part of a circle, its center anywhere or the clearance away from a cylinder.
+  *R = config_.turn_radius*(0.5 + 1.5*rg->randLin());
+  *cp = randomPoint(rg, map);
+  if (rg->randLin() < 0.5 && map->cylinders.size() > 0)
+  {
+    cyl_s cyl = map->cylinders[rg->UINT() % map->cylinders.size()];
+    double angle    = rg->randLin()*2.0*M_PI;
+    double distance = *R + cyl.R + clearance_*(1.0 + 2.0*(rg->randLin() - 0.5));
+    cp->N = cyl.N + distance*sin(angle);
+    cp->E = cyl.E + distance*cos(angle);
+  }
+  *lambda = rg->randLin() < 0.5 ? 1 : -1;
+  double start = rg->randLin()*2.0*M_PI;
+  double sweep = 0.05 + rg->randLin()*(2.0*M_PI - 0.1);
+  double end   = *lambda < 0 ? start + sweep : start - sweep;
+  *ps = NED_s(cp->N + *R*sin(start), cp->E + *R*cos(start), cp->D);
+  *pe = NED_s(cp->N + *R*sin(end), cp->E + *R*cos(end), cp->D);
+}
+unsigned long CollisionDifferential::unsafe()
+{
+  return counts_[DIFF_POINT].unsafe + counts_[DIFF_LINE].unsafe + counts_[DIFF_ARC].unsafe;
+}
+bool CollisionDifferential::write(std::string file)
+{
+  std::ofstream out(file.c_str());
+  if (!out.is_open())
+    return false;
+  out << "{\n  \"benchmark\": \"theseus_collision_differential\",\n";
+  out << "  \"maps\": " << maps_ << ",\n  \"first_seed\": " << first_seed_ << ",\n  \"cases\": " << cases_ << ",\n";
+  out << "  \"step\": " << step_ << ",\n  \"tolerance\": " << tolerance_ << ",\n  \"clearance\": " << clearance_ << ",\n";
+  out << "  \"kernels\": {\n";
+  for (unsigned int k = 0; k < NUM_DIFF_KERNELS; k++)
+    out << "    \"" << kernel_names[k] << "\": {\"cases\": " << counts_[k].cases << ", \"agree\": " << counts_[k].agree
+        << ", \"borderline\": " << counts_[k].borderline << ", \"unsafe\": " << counts_[k].unsafe << ", \"conservative\": "
+        << counts_[k].conservative << ", \"worst_unsafe\": " << counts_[k].worst_unsafe << "}"
+        << (k + 1 < NUM_DIFF_KERNELS ? ",\n" : "\n");
+  out << "  },\n  \"mismatches\": [\n";
+  for (unsigned int j = 0; j < mismatches_.size(); j++)
+  {
+    out << "    {\"kernel\": \"" << kernel_names[mismatches_[j].kernel] << "\", \"seed\": " << mismatches_[j].seed
+        << ", \"case\": " << mismatches_[j].case_number << ", \"unsafe\": " << (mismatches_[j].unsafe ? "true" : "false")
+        << ", \"margin\": " << mismatches_[j].margin.margin << ", \"constraint\": \""
+        << constraint_names[mismatches_[j].margin.constraint] << "\", \"index\": " << mismatches_[j].margin.index
+        << ", \"where\": [" << mismatches_[j].margin.where.N << ", " << mismatches_[j].margin.where.E << ", "
+        << mismatches_[j].margin.where.D << "], \"call\": \"" << mismatches_[j].inputs << "\"}"
+        << (j + 1 < mismatches_.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return true;
+}
+} // end namespace theseus
+
+//********************************************************//
+//************************ MAIN **************************//
+//********************************************************//
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "theseus_collision_differential");
+  ros::NodeHandle nh("~");
+  int maps, first_seed, cases, report;
+  double step, tolerance;
+  std::string output;
+  nh.param<int>("maps", maps, 1000);
+  nh.param<int>("first_seed", first_seed, 1);
+  nh.param<int>("cases", cases, 100);
+  nh.param<double>("step", step, 0.05);
+  nh.param<double>("tolerance", tolerance, 0.1);
+  nh.param<int>("report", report, 20);
+  nh.param<std::string>("output", output, "theseus_collision_differential.json");
+  if (tolerance < step)
+  {
+    ROS_WARN("the tolerance (%.3f m) can't be less than the step (%.3f m), using %.3f m", tolerance, step, step);
+    tolerance = step;
+  }
+
+  theseus::CollisionDifferential diff(step, tolerance, cases > 0 ? cases : 1, report > 0 ? report : 0);
+  diff.run(first_seed, maps > 0 ? maps : 1);
+  if (diff.write(output) == false)
+  {
+    ROS_ERROR("couldn't write %s", output.c_str());
+    return 1;
+  }
+  ROS_INFO("results written to %s", output.c_str());
+  if (diff.unsafe() > 0)
+  {
+    ROS_ERROR("%lu cases were clear by the collision detection but not by the oracle", diff.unsafe());
+    return 1;
+  }
+  return 0;
+} // end main
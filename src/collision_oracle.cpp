@@ -0,0 +1,130 @@
+#include <theseus/collision_oracle.h>
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+namespace theseus
+{
+CollisionOracle::CollisionOracle(planner_config_s config, double step)
+{
+  config_      = config;
+  step_        = step > 1.0e-4 ? step : 1.0e-4;
+  taking_off_  = false;
+  landing_now_ = false;
+}
+void CollisionOracle::newMap(map_s map)
+{
+  map_ = map;
+}
+oracle_margin_s CollisionOracle::point(NED_s p, double clearance)
+{
+  oracle_margin_s worst;
+  worst.margin     = DBL_MAX;
+  worst.constraint = ORACLE_NONE;
+  worst.index      = -1;
+  worst.where      = p;
+  measure(p, clearance, &worst);
+  return worst;
+}
+oracle_margin_s CollisionOracle::line(NED_s ps, NED_s pe, double clearance)
+{
+  oracle_margin_s worst = point(ps, clearance);
+  double dN = pe.N - ps.N;
+  double dE = pe.E - ps.E;
+  double dD = pe.D - ps.D;
+  double length = sqrt(dN*dN + dE*dE + dD*dD);
+  unsigned int steps = ceil(length/step_);
+  for (unsigned int k = 1; k <= steps; k++)
+  {
+    double t = k/((double) steps);
+    NED_s p;
+    p.N = ps.N + t*dN;
+    p.E = ps.E + t*dE;
+    p.D = ps.D + t*dD;
+    measure(p, clearance, &worst);
+  }
+  // The height that could be climbed (or descended) over the horizontal length, less the one that is.
+  double horizontal = sqrt(dN*dN + dE*dE);
+  if (-dD >= 0.0)
+    worse(horizontal*tan(config_.max_climb_angle) + dD, ORACLE_CLIMB, 0, pe, &worst);
+  else
+    worse(horizontal*tan(config_.max_descend_angle) - dD, ORACLE_CLIMB, 0, pe, &worst);
+  return worst;
+}
+oracle_margin_s CollisionOracle::arc(NED_s ps, NED_s pe, double R, NED_s cp, int lambda, double clearance)
+{
+  // Angles are measured from East towards North, so cw (lambda 1) goes down from the start and ccw goes up.
+  oracle_margin_s worst = point(ps, clearance);
+  double start = atan2(ps.N - cp.N, ps.E - cp.E);
+  double end   = atan2(pe.N - cp.N, pe.E - cp.E);
+  double sweep = lambda < 0 ? end - start : start - end;
+  while (sweep < 0.0)
+    sweep += 2.0*M_PI;
+  while (sweep >= 2.0*M_PI)
+    sweep -= 2.0*M_PI;
+  unsigned int steps = ceil(sweep*R/step_);
+  for (unsigned int k = 1; k <= steps; k++)
+  {
+    double t     = k/((double) steps);
+    double angle = lambda < 0 ? start + t*sweep : start - t*sweep;
+    NED_s p;
+    p.N = cp.N + R*sin(angle);
+    p.E = cp.E + R*cos(angle);
+    p.D = ps.D + t*(pe.D - ps.D);
+    measure(p, clearance, &worst);
+  }
+  measure(pe, clearance, &worst);
+  return worst;
+}
+void CollisionOracle::measure(NED_s p, double clearance, oracle_margin_s* worst)
+{
+  // Boundaries: the distance to the closest line, negative outside of the polygon (even-odd rule).
+  unsigned int num_pts = map_.boundary_pts.size();
+  if (num_pts > 0)
+  {
+    bool inside = false;
+    double closest = DBL_MAX;
+    int closest_line = 0;
+    for (unsigned int i = 0; i < num_pts; i++)
+    {
+      NED_s a = map_.boundary_pts[i];
+      NED_s b = map_.boundary_pts[(i + 1) % num_pts];
+      if ((a.E > p.E) != (b.E > p.E) && p.N < a.N + (b.N - a.N)*(p.E - a.E)/(b.E - a.E))
+        inside = !inside;
+      double abN = b.N - a.N;
+      double abE = b.E - a.E;
+      double length2 = abN*abN + abE*abE;
+      double t = length2 > 0.0 ? ((p.N - a.N)*abN + (p.E - a.E)*abE)/length2 : 0.0;
+      t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+      double d = sqrt(pow(p.N - a.N - t*abN, 2.0) + pow(p.E - a.E - t*abE, 2.0));
+      if (d < closest)
+      {
+        closest      = d;
+        closest_line = i;
+      }
+    }
+    worse((inside ? closest : -closest) - clearance, ORACLE_BOUNDARY, closest_line, p, worst);
+  }
+  if (taking_off_ == false && landing_now_ == false)
+    worse(std::min(-p.D - (config_.minFlyHeight + clearance), config_.maxFlyHeight - clearance + p.D), ORACLE_ALTITUDE, 0,
+          p, worst);
+  // Cylinders: a step is clear of one if it is far enough out to the side or far enough above it.
+  for (unsigned int i = 0; i < map_.cylinders.size(); i++)
+  {
+    cyl_s cyl = map_.cylinders[i];
+    double side  = sqrt(pow(p.N - cyl.N, 2.0) + pow(p.E - cyl.E, 2.0)) - cyl.R - clearance;
+    double above = -p.D - cyl.H - clearance;
+    worse(std::max(side, above), ORACLE_CYLINDER, i, p, worst);
+  }
+}
+void CollisionOracle::worse(double margin, oracle_constraint_e constraint, int index, NED_s p, oracle_margin_s* worst)
+{
+  if (margin >= worst->margin)
+    return;
+  worst->margin     = margin;
+  worst->constraint = constraint;
+  worst->index      = index;
+  worst->where      = p;
+}
+} // end namespace theseus
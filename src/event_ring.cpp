@@ -0,0 +1,147 @@
+#include <theseus/event_ring.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+
+namespace theseus
+{
+// Every argument is printed from a float, the formats only use %f and %.Nf (%.0f for counts and indices).
+static const char* event_formats[NUM_PLANNER_EVENTS] =
+{
+  "solve from N %.1f E %.1f D %.1f, chi %.3f",              // EV_SOLVE_START
+  "%.0f primary waypoints, %.0f legs, taking off %.0f",     // EV_SOLVE_SETUP
+  "solved, %.0f waypoints",                                 // EV_SOLVE_DONE
+  "solve failed at leg %.0f",                               // EV_SOLVE_FAILED
+  "solve cancelled at leg %.0f",                            // EV_SOLVE_CANCELLED
+  "leg %.0f: fan created %.0f",                             // EV_FAN
+  "leg %.0f: to N %.1f E %.1f D %.1f",                      // EV_LEG_START
+  "leg %.0f: from the leg cache",                           // EV_LEG_CACHED
+  "leg %.0f: the cached leg doesn't fit the turn, planning it again", // EV_CACHE_MISFIT
+  "leg %.0f: planned ahead",                                // EV_LEG_SPECULATED
+  "leg %.0f: reached with another heading than predicted, planning it again", // EV_SPECULATION_MISSED
+  "leg %.0f: the leg planned ahead doesn't fit the turn, planning it again",  // EV_SPECULATION_MISFIT
+  "leg %.0f: connected directly",                           // EV_DIRECT
+  "leg %.0f: connected through the visibility graph",       // EV_VIS_GRAPH
+  "leg %.0f: reused %.0f nodes, connected %.0f",            // EV_REUSED
+  "leg %.0f: connected through the roadmap",                // EV_ROADMAP
+  "leg %.0f: %.0f nodes (limit %.0f)",                      // EV_NODES
+  "leg %.0f: clearance decreased to %.2f after %.0f nodes", // EV_CLEARANCE
+  "leg %.0f: no new node in %.0f test points, starting again", // EV_TEST_POINTS
+  "leg %.0f: gave up after %.0f nodes",                     // EV_TOO_MANY_NODES
+  "leg %.0f: the tree reached the waypoint with %.0f nodes", // EV_CONNECTED
+  "leg %.0f: landing connection rejected (%.0f: 1 heading, 2 fillet)", // EV_LANDING_REJECTED
+  "leg %.0f: rough path of %.0f nodes",                     // EV_MIN_PATH
+  "leg %.0f: smoothing %.0f nodes, from a fan %.0f",        // EV_SMOOTH_START
+  "leg %.0f: smoother at %.0f of %.0f, collision %.0f",     // EV_SMOOTH_STEP
+  "leg %.0f: smoothed the fan",                             // EV_SMOOTH_FAN
+  "leg %.0f: smoothed to %.0f nodes",                       // EV_SMOOTH_DONE
+  "leg %.0f: the smoother ran out of time",                 // EV_SMOOTH_TIMEOUT
+  "leg %.0f: the smoother moved the approach, growing it again", // EV_APPROACH_MOVED
+  "leg %.0f: done taking off at %.1f m",                    // EV_TAKE_OFF_DONE
+  "leg %.0f: waypoint raised from %.1f m to %.1f m",        // EV_ALTITUDE
+  "loiter spot N %.1f E %.1f D %.1f",                       // EV_LOITER_SPOT
+  "bomb approach at %.1f m, %.1f m long, value %.1f, chi %.3f" // EV_BOMB_APPROACH
+};
+static std::atomic<uint32_t> next_thread(0);
+
+EventRing::EventRing(unsigned int capacity)
+{
+  uint64_t size = 1;
+  while (size < capacity)
+    size = size << 1;
+  slots_.reset(new slot_s[size]);
+  mask_ = size - 1;
+  for (uint64_t j = 0; j < size; j++)
+  {
+    slots_[j].seq.store(0, std::memory_order_relaxed);
+    for (unsigned int k = 0; k < 4; k++)
+      slots_[j].words[k].store(0, std::memory_order_relaxed);
+  }
+  head_.store(0, std::memory_order_release);
+}
+void EventRing::record(uint32_t id, float a0, float a1, float a2, float a3)
+{
+  static thread_local uint32_t thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+  event_record_s event;
+  event.stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  event.id       = id;
+  event.thread   = thread;
+  event.args[0]  = a0;
+  event.args[1]  = a1;
+  event.args[2]  = a2;
+  event.args[3]  = a3;
+  uint64_t words[4];
+  memcpy(words, &event, sizeof(words));
+
+  uint64_t n = head_.fetch_add(1, std::memory_order_relaxed);
+  slot_s& slot = slots_[n & mask_];
+  slot.seq.store(2*n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (unsigned int k = 0; k < 4; k++)
+    slot.words[k].store(words[k], std::memory_order_relaxed);
+  slot.seq.store(2*n + 2, std::memory_order_release);
+}
+std::vector<event_record_s> EventRing::last(unsigned int n)
+{
+  std::vector<event_record_s> events;
+  uint64_t head  = head_.load(std::memory_order_acquire);
+  uint64_t first = head > mask_ + 1 ? head - (mask_ + 1) : 0;
+  if (head - first > n)
+    first = head - n;
+  for (uint64_t r = first; r < head; r++)
+  {
+    slot_s& slot = slots_[r & mask_];
+    uint64_t words[4];
+    uint64_t seq_start = slot.seq.load(std::memory_order_acquire);
+    for (unsigned int k = 0; k < 4; k++)
+      words[k] = slot.words[k].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t seq_end = slot.seq.load(std::memory_order_relaxed);
+    if (seq_start != 2*r + 2 || seq_end != seq_start) // still being written, or already written over
+      continue;
+    event_record_s event;
+    memcpy(&event, words, sizeof(words));
+    events.push_back(event);
+  }
+  return events;
+}
+std::string EventRing::format(unsigned int n)
+{
+  std::vector<event_record_s> events = last(n);
+  std::string out;
+  char line[256];
+  // Threads can record slightly out of order, the times are from the earliest stamp.
+  uint64_t first_ns = events.empty() ? 0 : events[0].stamp_ns;
+  for (unsigned int j = 1; j < events.size(); j++)
+    first_ns = std::min(first_ns, events[j].stamp_ns);
+  for (unsigned int j = 0; j < events.size(); j++)
+  {
+    int len = snprintf(line, sizeof(line), "%10.3f ms [%u] ", ((int64_t) (events[j].stamp_ns - first_ns))*1.0e-6,
+                       events[j].thread);
+    if (events[j].id < NUM_PLANNER_EVENTS)
+      snprintf(line + len, sizeof(line) - len, event_formats[events[j].id], events[j].args[0], events[j].args[1],
+               events[j].args[2], events[j].args[3]);
+    else
+      snprintf(line + len, sizeof(line) - len, "event %u: %f %f %f %f", events[j].id, events[j].args[0],
+               events[j].args[1], events[j].args[2], events[j].args[3]);
+    out += line;
+    out += "\n";
+  }
+  return out;
+}
+bool EventRing::dump(std::string file_name)
+{
+  FILE* file = fopen(file_name.c_str(), "w");
+  if (file == NULL)
+    return false;
+  std::string text = format(mask_ + 1);
+  bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+  return fclose(file) == 0 && written;
+}
+unsigned long EventRing::recorded()
+{
+  return head_.load(std::memory_order_acquire);
+}
+} // end namespace theseus
@@ -8,7 +8,8 @@ Groundstation::Groundstation() :
   //********************** PARAMETERS **********************//
 
   //************** SUBSCRIBERS AND PUBLISHERS **************//
-  ground_pub_             = nh_.advertise<visualization_msgs::Marker>("groundstation/visualization_marker", 10);
+  ground_pub_             = nh_.advertise<visualization_msgs::MarkerArray>("groundstation/visualization_marker_array", 10);
+  trail_pub_              = nh_.advertise<visualization_msgs::Marker>("groundstation/visualization_marker_trail", 1, true);
   state_subscriber_       = nh_.subscribe("/state",100,&theseus::Groundstation::stateCallback, this);
   fstate_subscriber_      = nh_.subscribe("/fixedwing/state",100,&theseus::Groundstation::stateCallback, this);
   mobs_subscriber_        = nh_.subscribe("/moving_obstacles",100,&theseus::Groundstation::movingObsCallback, this);
@@ -18,6 +19,7 @@ Groundstation::Groundstation() :
 
   //********************** FUNCTIONS ***********************//
   recieved_state_ = false;
+  num_mobs_       = 0;
 
   odom_mkr_.header.frame_id    = "/local_ENU";
   odom_mkr_.ns                 = "plane_odom";
@@ -34,6 +36,13 @@ Groundstation::Groundstation() :
   odom_mkr_.lifetime           = ros::Duration();
   odom_mkr_.scale.x            = 2.5; //5.0; // point width
   odom_mkr_.scale.y            = 2.5; //5.0; // point width
+  int trail_capacity, trail_tail;
+  float trail_distance, trail_period;
+  nh_.param<int>("pp/trail_capacity", trail_capacity, 5000);
+  nh_.param<float>("pp/trail_distance", trail_distance, 5.0);
+  nh_.param<float>("pp/trail_period", trail_period, 2.0);
+  nh_.param<int>("pp/trail_tail", trail_tail, 100);
+  odom_trail_.setup(odom_mkr_, trail_capacity, trail_distance, trail_period, trail_tail);
 
   mobs_mkr_.header.frame_id    = "/local_ENU";
   mobs_mkr_.ns                 = "moving_obstacle";
@@ -88,7 +97,9 @@ void Groundstation::movingObsCallback(const uav_msgs::MovingObstacleCollection &
   NED_s mobs_pos;
   std::vector<NED_s> points;
   std::vector<float> radius;
+  visualization_msgs::MarkerArray mobs_array;
   mobs_mkr_.header.stamp = ros::Time::now();
+  mobs_mkr_.action       = visualization_msgs::Marker::ADD;
   for (int i = 0; i < msg.moving_obstacles.size(); i++)
   {
     radius.push_back(msg.moving_obstacles[i].sphere_radius);
@@ -102,10 +113,16 @@ void Groundstation::movingObsCallback(const uav_msgs::MovingObstacleCollection &
     mobs_mkr_.pose.position.y = points[i].N;
     mobs_mkr_.pose.position.z = -points[i].D;
     mobs_mkr_.id = i;
-    ground_pub_.publish(mobs_mkr_);
-
-    ros::Duration(0.01).sleep();
+    mobs_array.markers.push_back(mobs_mkr_);
+  }
+  mobs_mkr_.action = visualization_msgs::Marker::DELETE;
+  for (int i = msg.moving_obstacles.size(); i < num_mobs_; i++)
+  {
+    mobs_mkr_.id = i;
+    mobs_array.markers.push_back(mobs_mkr_);
   }
+  num_mobs_ = msg.moving_obstacles.size();
+  ground_pub_.publish(mobs_array);
 }
 void Groundstation::stateCallback(const rosplane_msgs::State &msg)
 {
@@ -147,17 +164,27 @@ void Groundstation::updateViz(const ros::WallTimerEvent&)
     // p.y =  odometry_.N;
     // p.z = -odometry_.D;
     // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    odom_mkr_.header.stamp = ros::Time::now();
-    odom_mkr_.points.push_back(p);
-    ground_pub_.publish(odom_mkr_);
-    ros::Duration(0.005).sleep();
-    pose_mkr_.header.stamp = ros::Time::now();
+    ros::Time now = ros::Time::now();
+    visualization_msgs::MarkerArray plane;
+    trail_update_e update = odom_trail_.add(p, now.toSec());
+    if (update == TRAIL_HISTORY)
+    {
+      visualization_msgs::Marker history = odom_trail_.history();
+      history.header.stamp = now;
+      trail_pub_.publish(history);
+    }
+    if (update != TRAIL_NONE)
+    {
+      plane.markers.push_back(odom_trail_.tail());
+      plane.markers.back().header.stamp = now;
+    }
+    pose_mkr_.header.stamp = now;
     // pose_mkr_.pose.position.x = p.x;
     // pose_mkr_.pose.position.y = p.y;
     // pose_mkr_.pose.position.z = p.z;
     pose_mkr_.pose = odometry_;
-    ros::Duration(0.005).sleep();
-    ground_pub_.publish(pose_mkr_);
+    plane.markers.push_back(pose_mkr_);
+    ground_pub_.publish(plane);
   }
 }
 } // end namespace theseus
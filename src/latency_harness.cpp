@@ -0,0 +1,441 @@
+/*	DESCRIPTION:
+ *	End to end latency of the planning services, the way a user sees them.
+ *	This node stands in for the autopilot: it serves /waypoint_path (the
+ *	reply can be held back by upload_delay, like a slow path manager) and
+ *	publishes a synthetic /state that flies the last path it was given and
+ *	loiters at its end. It calls the planning services one at a time and
+ *	times each request from the call to the service response, to the first
+ *	and last waypoint upload of that job and to the job being over on
+ *	planner_progress. Everything goes through the ROS master, the services
+ *	and topics, so the ROS overhead is in the numbers. The percentiles for
+ *	every service and every request are written as JSON.
+ *
+ *	roslaunch theseus latency_harness.launch repetitions:=20 output:=latency.json
+ *	(or rosrun theseus theseus_latency_harness __ns:=theseus next to a running path planner)
+ *
+ *	The planner reads landing.txt and bomb.txt from the .ros folder, they are
+ *	written from the landing and bomb parameters when they aren't there.
+ *
+ */
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <math.h>
+#include <ros/ros.h>
+#include <std_srvs/Trigger.h>
+#include <rosplane_msgs/State.h>
+#include <rosplane_msgs/NewWaypoints.h>
+#include <uav_msgs/GeneratePath.h>
+#include <theseus/PlannerProgress.h>
+
+#include <theseus/map_s.h>
+#include <theseus/gps_struct.h>
+
+namespace theseus
+{
+struct latency_run_s
+{
+  std::string service;
+  unsigned int job_id;            // 0 if the planner never queued it
+  int result;                     // PlannerProgress state it ended in, -1 if it timed out
+  bool called;                    // the service call went through
+  double response;                // from the call to the service response (s)
+  double first_upload;            // from the call to the first upload reaching the autopilot (s), -1 if there was none
+  double last_upload;             // (s), -1 if there was none
+  unsigned int uploads;
+  unsigned int waypoints;         // in all of the uploads
+  double done;                    // from the call to the job being over (s), -1 if it timed out
+};
+class LatencyHarness
+{
+public:
+  LatencyHarness();
+  void run(std::vector<std::string> services, int repetitions, double pause, double timeout);
+  bool write(std::string file);
+private:
+  latency_run_s request(std::string service, double timeout);
+  bool callService(std::string service);
+  bool waypointPath(rosplane_msgs::NewWaypoints::Request &req, rosplane_msgs::NewWaypoints::Response &res);
+  void progressCallback(const PlannerProgress &msg);
+  void publishState(const ros::WallTimerEvent& event);
+  void writeStat(std::ofstream& out, std::string name, std::vector<double> values, bool last);
+  ros::NodeHandle nh_;            // the planner's namespace
+  ros::NodeHandle private_nh_;
+  ros::ServiceServer waypoint_server_;
+  ros::Subscriber progress_subscriber_;
+  ros::Publisher state_publisher_;
+  ros::WallTimer state_timer_;
+  gps_struct gps_converter_;
+  std::vector<double> mission_wps_;        // N, E, D of each plan_mission waypoint
+  std::vector<double> mission_boundary_;   // N, E of each boundary point
+  std::vector<double> mission_cylinders_;  // N, E, R, H of each obstacle
+  int mission_type_;
+  bool mission_now_;
+  double upload_delay_;           // the autopilot holds its reply back this long (s)
+  double state_period_;           // (s)
+  std::vector<latency_run_s> runs_;
+
+  //******************** SHARED WITH THE CALLBACKS *******************//
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+  bool active_;                   // a request is being timed
+  latency_run_s current_;
+  double request_start_;          // wall time of the call
+  std::vector<NED_s> path_;       // the waypoints the plane was given, it flies towards path_[target_]
+  unsigned int target_;
+  NED_s position_;
+  float chi_;
+  float Va_;
+  float loiter_radius_;
+};
+LatencyHarness::LatencyHarness() :
+  nh_(ros::NodeHandle()),
+  private_nh_(ros::NodeHandle("~"))
+{
+  double lat_ref, lon_ref, h_ref, state_rate;
+  nh_.param<double>("lat_ref", lat_ref, 38.144692);
+  nh_.param<double>("lon_ref", lon_ref, -76.428007);
+  nh_.param<double>("h_ref", h_ref, 0.0);
+  gps_converter_.set_reference(lat_ref, lon_ref, h_ref);
+  nh_.param<float>("pp/Va", Va_, 20.0);
+  nh_.param<float>("pp/loiter_radius", loiter_radius_, 75.0);
+  private_nh_.param<double>("upload_delay", upload_delay_, 0.0);
+  private_nh_.param<double>("state_rate", state_rate, 50.0);
+  private_nh_.param<int>("mission_type", mission_type_, uav_msgs::JudgeMission::MISSION_TYPE_WAYPOINT);
+  private_nh_.param<bool>("mission_now", mission_now_, false);
+  // Inside the default (Webster Field) boundaries, away from the flight tent.
+  double default_wps[]       = {0.0, -200.0, -60.0, 400.0, -250.0, -80.0, -300.0, 200.0, -60.0};
+  double default_boundary[]  = {175.0, -14.0, 770.0, -59.0, 799.0, -302.0, 655.0, -642.0, 319.0, -378.0, -3.0, -431.0,
+                                -159.0, -590.0, -469.0, -404.0, -441.0, 174.0, -103.0, 594.0, 295.0, 419.0, 160.0, 118.0};
+  double default_cylinders[] = {200.0, -100.0, 30.0, 100.0, -200.0, -200.0, 40.0, 150.0};
+  if (private_nh_.getParam("mission_wps", mission_wps_) == false)
+    mission_wps_.assign(default_wps, default_wps + 9);
+  if (private_nh_.getParam("mission_boundary", mission_boundary_) == false)
+    mission_boundary_.assign(default_boundary, default_boundary + 24);
+  if (private_nh_.getParam("mission_cylinders", mission_cylinders_) == false)
+    mission_cylinders_.assign(default_cylinders, default_cylinders + 8);
+
+  std::vector<double> start;
+  if (private_nh_.getParam("start", start) == false || start.size() < 4)
+  {
+    double default_start[] = {-300.0, -300.0, -50.0, 0.2};
+    start.assign(default_start, default_start + 4);
+  }
+  position_ = NED_s(start[0], start[1], start[2]);
+  chi_      = start[3];
+  target_   = 0;
+  active_   = false;
+  request_start_ = 0.0;
+
+  // The planner reads these from the .ros folder, which is where this node runs too.
+  std::vector<double> landing, bomb;
+  private_nh_.getParam("landing", landing);
+  private_nh_.getParam("bomb", bomb);
+  if (landing.size() < 4)
+  {
+    double default_landing[] = {-300.0, -300.0, -30.0, 0.21};
+    landing.assign(default_landing, default_landing + 4);
+  }
+  if (bomb.size() < 3)
+  {
+    double default_bomb[] = {100.0, -250.0, -40.0};
+    bomb.assign(default_bomb, default_bomb + 3);
+  }
+  if (std::ifstream("landing.txt").good() == false)
+    std::ofstream("landing.txt") << landing[0] << " " << landing[1] << " " << landing[2] << " " << landing[3] << "\n";
+  if (std::ifstream("bomb.txt").good() == false)
+    std::ofstream("bomb.txt") << bomb[0] << " " << bomb[1] << " " << bomb[2] << "\n";
+
+  waypoint_server_     = nh_.advertiseService("/waypoint_path", &theseus::LatencyHarness::waypointPath, this);
+  progress_subscriber_ = nh_.subscribe("planner_progress", 100, &theseus::LatencyHarness::progressCallback, this);
+  state_publisher_     = nh_.advertise<rosplane_msgs::State>("/state", 1);
+  state_period_        = 1.0/(state_rate > 1.0 ? state_rate : 1.0);
+  state_timer_         = nh_.createWallTimer(ros::WallDuration(state_period_), &LatencyHarness::publishState, this);
+}
+void LatencyHarness::run(std::vector<std::string> services, int repetitions, double pause, double timeout)
+{
+  for (int r = 0; r < repetitions && ros::ok(); r++)
+    for (unsigned int s = 0; s < services.size() && ros::ok(); s++)
+    {
+      latency_run_s run = request(services[s], timeout);
+      runs_.push_back(run);
+      ROS_INFO("%s (job %u): response %.1f ms, first upload %.1f ms, over %.1f ms, %u uploads, result %i",
+               run.service.c_str(), run.job_id, run.response*1.0e3, run.first_upload*1.0e3, run.done*1.0e3, run.uploads,
+               run.result);
+      ros::WallDuration(pause).sleep();
+    }
+}
+latency_run_s LatencyHarness::request(std::string service, double timeout)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_.service      = service;
+    current_.job_id       = 0;
+    current_.result       = -1;
+    current_.called       = false;
+    current_.response     = -1.0;
+    current_.first_upload = -1.0;
+    current_.last_upload  = -1.0;
+    current_.uploads      = 0;
+    current_.waypoints    = 0;
+    current_.done         = -1.0;
+    request_start_        = ros::WallTime::now().toSec();
+    active_               = true;
+  }
+  // The progress can come in before the response, the callbacks match the job by the service name.
+  bool called = callService(service);
+  double response = ros::WallTime::now().toSec() - request_start_;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  current_.called   = called;
+  current_.response = response;
+  if (called)
+  {
+    double deadline = request_start_ + timeout;
+    while (current_.done < 0.0 && ros::ok() && ros::WallTime::now().toSec() < deadline)
+      done_cv_.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  else
+    ROS_ERROR("couldn't call %s", service.c_str());
+  active_ = false;
+  return current_;
+}
+bool LatencyHarness::callService(std::string service)
+{
+  if (service != "plan_mission")
+  {
+    std_srvs::Trigger srv;
+    return ros::service::call(nh_.resolveName(service), srv);
+  }
+  uav_msgs::GeneratePath srv;
+  srv.request.mission.mission_type = mission_type_;
+  srv.request.mission.now          = mission_now_;
+  uav_msgs::OrderedPoint point;
+  for (unsigned int i = 0; i + 2 < mission_wps_.size(); i += 3)
+  {
+    if (mission_type_ == uav_msgs::JudgeMission::MISSION_TYPE_LAND) // the planner takes these as N, E, height
+    {
+      point.point.latitude  =  mission_wps_[i];
+      point.point.longitude =  mission_wps_[i + 1];
+      point.point.altitude  = -mission_wps_[i + 2];
+      point.point.chi       =  chi_;
+    }
+    else
+      gps_converter_.ned2gps(mission_wps_[i], mission_wps_[i + 1], mission_wps_[i + 2], point.point.latitude,
+                             point.point.longitude, point.point.altitude);
+    point.ordinal = i/3 + 1;
+    srv.request.mission.waypoints.push_back(point);
+  }
+  for (unsigned int i = 0; i + 1 < mission_boundary_.size(); i += 2)
+  {
+    gps_converter_.ned2gps(mission_boundary_[i], mission_boundary_[i + 1], 0.0, point.point.latitude,
+                           point.point.longitude, point.point.altitude);
+    point.ordinal = i/2 + 1;
+    srv.request.mission.boundaries.push_back(point);
+  }
+  uav_msgs::Obstacle obstacle;
+  for (unsigned int i = 0; i + 3 < mission_cylinders_.size(); i += 4)
+  {
+    gps_converter_.ned2gps(mission_cylinders_[i], mission_cylinders_[i + 1], 0.0, obstacle.point.latitude,
+                           obstacle.point.longitude, obstacle.point.altitude);
+    obstacle.cylinder_radius = mission_cylinders_[i + 2];
+    obstacle.cylinder_height = mission_cylinders_[i + 3];
+    srv.request.mission.stationary_obstacles.push_back(obstacle);
+  }
+  return ros::service::call(nh_.resolveName("plan_mission"), srv);
+}
+bool LatencyHarness::waypointPath(rosplane_msgs::NewWaypoints::Request &req, rosplane_msgs::NewWaypoints::Response &res)
+{
+  double arrived = ros::WallTime::now().toSec();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ && current_.job_id != 0)
+    {
+      if (current_.first_upload < 0.0)
+        current_.first_upload = arrived - request_start_;
+      current_.last_upload = arrived - request_start_;
+      current_.uploads++;
+      current_.waypoints += req.waypoints.size();
+    }
+    // A path that sets its first waypoint as the current one replaces the old one, like the path manager does.
+    if (req.waypoints.size() > 0 && req.waypoints[0].set_current)
+    {
+      path_.clear();
+      target_ = 0;
+    }
+    for (unsigned int i = 0; i < req.waypoints.size(); i++)
+      path_.push_back(NED_s(req.waypoints[i].w[0], req.waypoints[i].w[1], req.waypoints[i].w[2]));
+  }
+  ros::WallDuration(upload_delay_).sleep();
+  res.success = true;
+  return true;
+}
+void LatencyHarness::progressCallback(const PlannerProgress &msg)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (active_ == false)
+    return;
+  if (current_.job_id == 0 && msg.job == current_.service && msg.state == PlannerProgress::QUEUED)
+    current_.job_id = msg.job_id;
+  if (msg.job_id != current_.job_id || msg.state == PlannerProgress::QUEUED || msg.state == PlannerProgress::RUNNING)
+    return;
+  current_.result = msg.state;
+  current_.done   = ros::WallTime::now().toSec() - request_start_;
+  done_cv_.notify_all();
+}
+void LatencyHarness::publishState(const ros::WallTimerEvent& event)
+{
+  rosplane_msgs::State msg;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Straight at the next waypoint, once there are none left it circles where it is.
+    float step = Va_*state_period_;
+    while (target_ < path_.size() && (path_[target_] - position_).norm() < step)
+      target_++;
+    if (target_ < path_.size())
+      chi_ = (path_[target_] - position_).getChi();
+    else
+      chi_ += step/loiter_radius_;
+    chi_ = atan2f(sinf(chi_), cosf(chi_));
+    position_.N += step*cosf(chi_);
+    position_.E += step*sinf(chi_);
+    if (target_ < path_.size())
+      position_.D = path_[target_].D;
+    msg.position[0] = position_.N;
+    msg.position[1] = position_.E;
+    msg.position[2] = position_.D;
+    msg.chi         = chi_;
+    msg.chi_deg     = chi_*180.0f/M_PI;
+    msg.psi         = chi_;
+    msg.psi_deg     = msg.chi_deg;
+    msg.Va          = Va_;
+    msg.Vg          = Va_;
+  }
+  msg.header.stamp = ros::Time::now();
+  state_publisher_.publish(msg);
+}
+void LatencyHarness::writeStat(std::ofstream& out, std::string name, std::vector<double> values, bool last)
+{
+  // Nearest rank percentiles.
+  out << "      \"" << name << "\": {";
+  std::sort(values.begin(), values.end());
+  if (values.size() > 0)
+  {
+    const double percentiles[] = {50.0, 90.0, 99.0};
+    for (unsigned int k = 0; k < 3; k++)
+    {
+      unsigned int rank = ceil(percentiles[k]/100.0*values.size());
+      out << "\"p" << percentiles[k] << "\": " << values[rank > 0 ? rank - 1 : 0] << ", ";
+    }
+    out << "\"min\": " << values.front() << ", \"max\": " << values.back();
+  }
+  out << "}" << (last ? "\n" : ",\n");
+}
+bool LatencyHarness::write(std::string file)
+{
+  std::ofstream out(file.c_str());
+  if (!out.is_open())
+    return false;
+  std::vector<std::string> services;
+  for (unsigned int j = 0; j < runs_.size(); j++)
+    if (std::find(services.begin(), services.end(), runs_[j].service) == services.end())
+      services.push_back(runs_[j].service);
+
+  out << "{\n  \"benchmark\": \"theseus_latency\",\n";
+  out << "  \"upload_delay\": " << upload_delay_ << ",\n  \"state_rate\": " << 1.0/state_period_ << ",\n";
+  out << "  \"services\": {\n";
+  for (unsigned int s = 0; s < services.size(); s++)
+  {
+    // The times to the end of the job are over the ones that finished, a cut short job would look fast.
+    std::vector<double> response, first_upload, last_upload, done;
+    unsigned int requests = 0, finished = 0, failed = 0, timed_out = 0;
+    for (unsigned int j = 0; j < runs_.size(); j++)
+    {
+      if (runs_[j].service != services[s])
+        continue;
+      requests++;
+      if (runs_[j].called)
+        response.push_back(runs_[j].response);
+      if (runs_[j].first_upload >= 0.0)
+      {
+        first_upload.push_back(runs_[j].first_upload);
+        last_upload.push_back(runs_[j].last_upload);
+      }
+      if (runs_[j].result == PlannerProgress::DONE || runs_[j].result == PlannerProgress::FAILED)
+        done.push_back(runs_[j].done);
+      if (runs_[j].result == PlannerProgress::DONE)
+        finished++;
+      else if (runs_[j].result == PlannerProgress::FAILED)
+        failed++;
+      else if (runs_[j].result < 0)
+        timed_out++;
+    }
+    out << "    \"" << services[s] << "\": {\n";
+    out << "      \"requests\": " << requests << ", \"done\": " << finished << ", \"failed\": " << failed
+        << ", \"timed_out\": " << timed_out << ",\n";
+    writeStat(out, "response", response, false);
+    writeStat(out, "first_upload", first_upload, false);
+    writeStat(out, "last_upload", last_upload, false);
+    writeStat(out, "done", done, true);
+    out << "    }" << (s + 1 < services.size() ? ",\n" : "\n");
+  }
+  out << "  },\n  \"runs\": [\n";
+  for (unsigned int j = 0; j < runs_.size(); j++)
+  {
+    out << "    {\"service\": \"" << runs_[j].service << "\", \"job_id\": " << runs_[j].job_id << ", \"result\": "
+        << runs_[j].result << ", \"response\": " << runs_[j].response << ", \"first_upload\": " << runs_[j].first_upload
+        << ", \"last_upload\": " << runs_[j].last_upload << ", \"uploads\": " << runs_[j].uploads << ", \"waypoints\": "
+        << runs_[j].waypoints << ", \"done\": " << runs_[j].done << "}" << (j + 1 < runs_.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return true;
+}
+} // end namespace theseus
+
+//********************************************************//
+//************************ MAIN **************************//
+//********************************************************//
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "theseus_latency_harness");
+  ros::NodeHandle nh("~");
+  std::vector<std::string> services;
+  int repetitions;
+  double pause, timeout, warm_up;
+  std::string output;
+  if (nh.getParam("services", services) == false)
+  {
+    services.push_back("plan_mission");
+    services.push_back("add_wps");
+    services.push_back("wps_now");
+    services.push_back("land_now");
+    services.push_back("bomb_now");
+  }
+  nh.param<int>("repetitions", repetitions, 10);
+  nh.param<double>("pause", pause, 1.0);
+  nh.param<double>("timeout", timeout, 60.0);
+  nh.param<double>("warm_up", warm_up, 2.0);
+  nh.param<std::string>("output", output, "theseus_latency.json");
+
+  theseus::LatencyHarness harness;
+  ros::AsyncSpinner spinner(3);   // the autopilot can hold its reply back while the state keeps going out
+  spinner.start();
+  if (ros::service::waitForService(ros::NodeHandle().resolveName("wps_now"), ros::Duration(30.0)) == false)
+  {
+    ROS_ERROR("the path planner isn't running");
+    return 1;
+  }
+  ros::WallDuration(warm_up).sleep();   // the planner needs a state before it plans
+  harness.run(services, repetitions, pause, timeout);
+  if (harness.write(output) == false)
+  {
+    ROS_ERROR("couldn't write %s", output.c_str());
+    return 1;
+  }
+  ROS_INFO("results written to %s", output.c_str());
+  return 0;
+} // end main
@@ -0,0 +1,105 @@
+#include <theseus/latency_window.h>
+
+#include <math.h>
+#include <algorithm>
+
+namespace theseus
+{
+// The values below 8 us get a bucket each, above that every power of 2 is split in 8.
+static unsigned int bucketOf(uint64_t us)
+{
+  if (us < 8)
+    return us;
+  unsigned int e = 3;
+  while ((us >> (e + 1)) > 0)
+    e++;
+  return (e - 2)*8 + ((us >> (e - 3)) & 7);
+}
+static double bucketTop(unsigned int b)
+{
+  if (b < 8)
+    return (b + 1)*1.0e-6;
+  unsigned int e   = b/8 + 2;
+  unsigned int sub = b%8;
+  return ldexp(9.0 + sub, e - 3)*1.0e-6;
+}
+latency_histogram_s::latency_histogram_s()
+{
+  clear();
+}
+void latency_histogram_s::clear()
+{
+  for (unsigned int b = 0; b < num_buckets_; b++)
+    buckets[b] = 0;
+  count  = 0;
+  failed = 0;
+  max    = 0.0;
+}
+void latency_histogram_s::add(double seconds, bool failed_job)
+{
+  double us = std::max(0.0, seconds*1.0e6);
+  unsigned int b = us < ldexp(1.0, 40) ? bucketOf((uint64_t) us) : num_buckets_ - 1;
+  buckets[std::min(b, num_buckets_ - 1)]++;
+  count++;
+  if (failed_job)
+    failed++;
+  max = std::max(max, seconds);
+}
+void latency_histogram_s::merge(const latency_histogram_s& other)
+{
+  for (unsigned int b = 0; b < num_buckets_; b++)
+    buckets[b] += other.buckets[b];
+  count  += other.count;
+  failed += other.failed;
+  max     = std::max(max, other.max);
+}
+double latency_histogram_s::percentile(double p) const
+{
+  if (count == 0)
+    return 0.0;
+  uint64_t rank = ceil(p/100.0*count);
+  uint64_t seen = 0;
+  for (unsigned int b = 0; b < num_buckets_; b++)
+  {
+    seen += buckets[b];
+    if (seen >= rank && seen > 0)
+      return std::min(max, bucketTop(b));
+  }
+  return max;
+}
+LatencyWindow::LatencyWindow(double window, unsigned int num_slices)
+{
+  num_slices    = std::max(num_slices, 1u);
+  slices_.resize(num_slices);
+  slice_length_ = std::max(window, 1.0e-3)/num_slices;
+  current_      = 0;
+}
+void LatencyWindow::advance(double now)
+{
+  long slice = floor(now/slice_length_);
+  if (slice <= current_)
+    return;
+  // The slices that were skipped over are empty, the one that is reused starts over.
+  long num_slices = slices_.size();
+  for (long s = std::max(current_ + 1, slice - num_slices + 1); s <= slice; s++)
+    slices_[s%num_slices].clear();
+  current_ = slice;
+}
+void LatencyWindow::add(double now, double seconds, bool failed_job)
+{
+  advance(now);
+  slices_[current_%slices_.size()].add(seconds, failed_job);
+}
+latency_histogram_s LatencyWindow::window(double now)
+{
+  advance(now);
+  latency_histogram_s total;
+  for (unsigned int s = 0; s < slices_.size(); s++)
+    total.merge(slices_[s]);
+  return total;
+}
+double LatencyWindow::length()
+{
+  return slice_length_*slices_.size();
+}
+} // end namespace theseus
@@ -0,0 +1,97 @@
+/*	DESCRIPTION:
+ *	This is the cpp for the LegCache class. The legs are kept in a small
+ *	least recently used list, a search is a linear scan of the keys.
+ *
+ */
+#include <theseus/leg_cache.h>
+
+namespace theseus
+{
+LegCache::LegCache()
+{
+  size_ = 64;
+}
+LegCache::~LegCache()
+{
+}
+void LegCache::setSize(unsigned int size)
+{
+  size_ = size;
+  while (legs_.size() > size_)
+    legs_.pop_back();
+}
+bool LegCache::find(leg_key_s key, leg_s* leg)
+{
+  for (unsigned int j = 0; j < legs_.size(); j++)
+    if (sameKey(legs_[j].key, key))
+    {
+      *leg = legs_[j];
+      legs_.erase(legs_.begin() + j);
+      legs_.push_front(*leg);
+      return true;
+    }
+  return false;
+}
+void LegCache::add(leg_s leg)
+{
+  if (size_ == 0)
+    return;
+  for (unsigned int j = 0; j < legs_.size(); j++)
+    if (sameKey(legs_[j].key, leg.key))
+    {
+      legs_.erase(legs_.begin() + j);
+      break;
+    }
+  legs_.push_front(leg);
+  while (legs_.size() > size_)
+    legs_.pop_back();
+}
+void LegCache::clear()
+{
+  legs_.clear();
+}
+unsigned long LegCache::hashMap(map_s map)
+{
+  // FNV-1a over the raw bytes of the boundaries and cylinders
+  unsigned long long hash = 14695981039346656037ULL;
+  std::vector<double> values;
+  for (unsigned int j = 0; j < map.boundary_pts.size(); j++)
+  {
+    values.push_back(map.boundary_pts[j].N);
+    values.push_back(map.boundary_pts[j].E);
+    values.push_back(map.boundary_pts[j].D);
+  }
+  for (unsigned int j = 0; j < map.cylinders.size(); j++)
+  {
+    values.push_back(map.cylinders[j].N);
+    values.push_back(map.cylinders[j].E);
+    values.push_back(map.cylinders[j].R);
+    values.push_back(map.cylinders[j].H);
+  }
+  if (values.empty())
+    return (unsigned long) hash;
+  const unsigned char* bytes = (const unsigned char*) &values[0];
+  for (unsigned int j = 0; j < values.size()*sizeof(double); j++)
+  {
+    hash ^= bytes[j];
+    hash *= 1099511628211ULL;
+  }
+  return (unsigned long) hash;
+}
+bool LegCache::sameKey(leg_key_s a, leg_key_s b, float chi_tol)
+{
+  float pos_tol = 0.01f;          // m
+  if (a.flags != b.flags || a.map_hash != b.map_hash || fabs(a.clearance - b.clearance) > pos_tol)
+    return false;
+  if ((a.tuning == b.tuning) == false)
+    return false;
+  if ((a.start - b.start).norm() > pos_tol || (a.goal - b.goal).norm() > pos_tol)
+    return false;
+  float dchi = a.chi - b.chi;
+  while (dchi > M_PI)
+    dchi -= 2.0f*M_PI;
+  while (dchi < -M_PI)
+    dchi += 2.0f*M_PI;
+  return fabs(dchi) < chi_tol;
+}
+}
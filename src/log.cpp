@@ -0,0 +1,42 @@
+#include <theseus/log.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <atomic>
+#include <mutex>
+
+namespace theseus
+{
+static std::atomic<int> log_level(LOG_LEVEL_INFO);
+static std::mutex sink_mutex;                   // guards log_sink, a message is passed on whole
+static std::function<void(int, const char*)> log_sink;
+
+void setLogLevel(int level)
+{
+  log_level = level;
+}
+void setLogSink(std::function<void(int, const char*)> sink)
+{
+  std::lock_guard<std::mutex> lock(sink_mutex);
+  log_sink = sink;
+}
+bool logEnabled(int level)
+{
+  return level >= log_level;
+}
+void logPrintf(int level, const char* format, ...)
+{
+  static const char* names[] = {"DEBUG", " INFO", " WARN", "ERROR", "FATAL"};
+  char message[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  std::lock_guard<std::mutex> lock(sink_mutex);
+  if (log_sink)
+    log_sink(level, message);
+  else
+    fprintf(level >= LOG_LEVEL_WARN ? stderr : stdout, "[%s] %s\n",
+            names[level < LOG_LEVEL_DEBUG ? 0 : (level > LOG_LEVEL_FATAL ? 4 : level)], message);
+}
+} // end namespace theseus
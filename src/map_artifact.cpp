@@ -0,0 +1,182 @@
+#include <theseus/map_artifact.h>
+#include <theseus/leg_cache.h>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <theseus/log.h>
+
+namespace theseus
+{
+MapArtifact::MapArtifact()
+{
+  data_ = NULL;
+  size_ = 0;
+}
+MapArtifact::~MapArtifact()
+{
+  close();
+}
+bool MapArtifact::open(std::string file_name, map_s map, float clearance)
+{
+  close();
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(map_artifact_header_s))
+  {
+    ::close(fd);
+    return false;
+  }
+  void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  data_ = (const char*) data;
+  size_  = st.st_size;
+
+  const map_artifact_header_s* header = (const map_artifact_header_s*) data_;
+  if (memcmp(header->magic, "THSMAP", 6) != 0 || header->version != version_)
+  {
+    THESEUS_WARN("%s is not a compiled map of this version", file_name.c_str());
+    close();
+    return false;
+  }
+  if (header->map_hash != (uint64_t) LegCache::hashMap(map) || header->clearance != clearance ||
+      sizeof(map_artifact_header_s) + header->num_sections*sizeof(map_artifact_section_s) > size_)
+  {
+    THESEUS_WARN("%s was compiled from a different map", file_name.c_str());
+    close();
+    return false;
+  }
+  // The hash only rules out other maps with high probability, the arrays rule it out completely.
+  std::vector<char> boundary  = boundarySection(map);
+  std::vector<char> cylinders = cylinderSection(map);
+  size_t boundary_size, cylinder_size;
+  const char* boundary_data = section(MAP_SECTION_BOUNDARY, &boundary_size);
+  const char* cylinder_data = section(MAP_SECTION_CYLINDERS, &cylinder_size);
+  if (boundary_data == NULL || cylinder_data == NULL || boundary_size != boundary.size() || cylinder_size != cylinders.size() ||
+      (boundary.size() > 0 && memcmp(boundary_data, &boundary[0], boundary.size()) != 0) ||
+      (cylinders.size() > 0 && memcmp(cylinder_data, &cylinders[0], cylinders.size()) != 0))
+  {
+    THESEUS_WARN("%s was compiled from a different map", file_name.c_str());
+    close();
+    return false;
+  }
+  return true;
+}
+void MapArtifact::close()
+{
+  if (data_ != NULL)
+    munmap((void*) data_, size_);
+  data_ = NULL;
+  size_ = 0;
+}
+bool MapArtifact::isOpen()
+{
+  return data_ != NULL;
+}
+const char* MapArtifact::section(uint32_t id, size_t* size)
+{
+  if (data_ == NULL)
+    return NULL;
+  const map_artifact_header_s* header    = (const map_artifact_header_s*) data_;
+  const map_artifact_section_s* sections = (const map_artifact_section_s*) (data_ + sizeof(map_artifact_header_s));
+  for (uint32_t j = 0; j < header->num_sections; j++)
+    if (sections[j].id == id && sections[j].offset + sections[j].size <= size_)
+    {
+      *size = sections[j].size;
+      return data_ + sections[j].offset;
+    }
+  return NULL;
+}
+bool MapArtifact::write(std::string file_name, map_s map, float clearance, std::vector<std::pair<uint32_t, std::vector<char> > > sections)
+{
+  sections.insert(sections.begin(), std::make_pair((uint32_t) MAP_SECTION_CYLINDERS, cylinderSection(map)));
+  sections.insert(sections.begin(), std::make_pair((uint32_t) MAP_SECTION_BOUNDARY, boundarySection(map)));
+
+  map_artifact_header_s header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "THSMAP", 6);
+  header.version      = version_;
+  header.num_sections = sections.size();
+  header.map_hash     = LegCache::hashMap(map);
+  header.clearance    = clearance;
+  std::vector<map_artifact_section_s> table(sections.size());
+  uint64_t offset = sizeof(header) + sections.size()*sizeof(map_artifact_section_s);
+  for (unsigned int j = 0; j < sections.size(); j++)
+  {
+    offset = (offset + 7) & ~((uint64_t) 7);
+    table[j].id       = sections[j].first;
+    table[j].reserved = 0;
+    table[j].offset   = offset;
+    table[j].size     = sections[j].second.size();
+    offset           += table[j].size;
+  }
+  std::vector<char> blob;
+  blob.reserve(offset);
+  appendBlob(&blob, &header, 1);
+  appendBlob(&blob, table.empty() ? NULL : &table[0], table.size());
+  for (unsigned int j = 0; j < sections.size(); j++)
+  {
+    blob.resize(table[j].offset, 0);
+    appendBlob(&blob, sections[j].second.empty() ? NULL : &sections[j].second[0], sections[j].second.size());
+  }
+
+  // Write next to it and rename, so a half written file is never opened.
+  std::string temp_name = file_name + ".tmp";
+  FILE* file = fopen(temp_name.c_str(), "wb");
+  if (file == NULL)
+    return false;
+  bool written = fwrite(&blob[0], 1, blob.size(), file) == blob.size();
+  written = (fclose(file) == 0) && written;
+  if (written == false || rename(temp_name.c_str(), file_name.c_str()) != 0)
+  {
+    remove(temp_name.c_str());
+    return false;
+  }
+  return true;
+}
+std::string MapArtifact::fileName(std::string directory, map_s map, float clearance)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "/map_%016llx_%d.bin", (unsigned long long) LegCache::hashMap(map), (int) (clearance*100.0f));
+  return directory + name;
+}
+std::vector<char> MapArtifact::boundarySection(map_s map)
+{
+  std::vector<double> N, E, D;
+  for (unsigned int j = 0; j < map.boundary_pts.size(); j++)
+  {
+    N.push_back(map.boundary_pts[j].N);
+    E.push_back(map.boundary_pts[j].E);
+    D.push_back(map.boundary_pts[j].D);
+  }
+  std::vector<char> blob;
+  appendBlob(&blob, N.empty() ? NULL : &N[0], N.size());
+  appendBlob(&blob, E.empty() ? NULL : &E[0], E.size());
+  appendBlob(&blob, D.empty() ? NULL : &D[0], D.size());
+  return blob;
+}
+std::vector<char> MapArtifact::cylinderSection(map_s map)
+{
+  std::vector<double> N, E, R, H;
+  for (unsigned int j = 0; j < map.cylinders.size(); j++)
+  {
+    N.push_back(map.cylinders[j].N);
+    E.push_back(map.cylinders[j].E);
+    R.push_back(map.cylinders[j].R);
+    H.push_back(map.cylinders[j].H);
+  }
+  std::vector<char> blob;
+  appendBlob(&blob, N.empty() ? NULL : &N[0], N.size());
+  appendBlob(&blob, E.empty() ? NULL : &E[0], E.size());
+  appendBlob(&blob, R.empty() ? NULL : &R[0], R.size());
+  appendBlob(&blob, H.empty() ? NULL : &H[0], H.size());
+  return blob;
+}
+} // end namespace theseus
@@ -16,7 +16,7 @@ mapper::mapper()
 {
 
 }
-mapper::mapper(unsigned int seed, ParamReader *input_file_in)
+mapper::mapper(unsigned int seed, planner_config_s *input_file_in)
 {
   rPhi_ = 38.144692;
   rLam_ = -76.428007;
@@ -234,7 +234,7 @@ void mapper::translateBoundaries(double lat, double lon, double height)
     D = (double) map.boundary_pts[i].D;
     double temp_lat, temp_long, temp_h;
     gps_converter.ned2gps(N, E, D, temp_lat, temp_long, temp_h);
-    ROS_INFO("point %i, latitude: %f, longitude: %f, height: %f", i, temp_lat, temp_long, temp_h);
+    THESEUS_INFO("point %i, latitude: %f, longitude: %f, height: %f", i, temp_lat, temp_long, temp_h);
 	}
 }
 } // end namespace theseus
@@ -0,0 +1,83 @@
+/*	DESCRIPTION:
+ *	This is the cpp for the OdomTrail class. The history is a ring of points
+ *	that is only unrolled into a marker when the tail is moved into it.
+ *
+ */
+#include <theseus/odom_trail.h>
+
+namespace theseus
+{
+OdomTrail::OdomTrail()
+{
+  visualization_msgs::Marker style;
+  setup(style, 5000, 5.0f, 2.0f, 100);
+}
+OdomTrail::~OdomTrail()
+{
+}
+void OdomTrail::setup(visualization_msgs::Marker style, unsigned int capacity, float min_distance, float max_period, unsigned int tail_length)
+{
+  style_        = style;
+  style_.points.clear();
+  tail_length_  = tail_length < 2 ? 2 : tail_length;
+  capacity_     = capacity < tail_length_ ? tail_length_ : capacity;
+  min_distance_ = min_distance;
+  max_period_   = max_period;
+  ring_.reserve(capacity_ - tail_length_);
+  tail_.reserve(tail_length_);
+  clear();
+}
+trail_update_e OdomTrail::add(geometry_msgs::Point p, double t)
+{
+  if (has_last_)
+  {
+    float d = sqrtf(powf(p.x - last_.x, 2.0f) + powf(p.y - last_.y, 2.0f) + powf(p.z - last_.z, 2.0f));
+    if (d < min_distance_ && (t - last_t_ < max_period_ || d == 0.0f))
+      return TRAIL_NONE;
+  }
+  last_     = p;
+  last_t_   = t;
+  has_last_ = true;
+  tail_.push_back(p);
+  if (tail_.size() < tail_length_)
+    return TRAIL_TAIL;
+
+  // The tail is full, all but its last point move into the history so the two still join up.
+  unsigned int history_size = capacity_ - tail_length_;
+  for (unsigned int i = 0; i + 1 < tail_.size() && history_size > 0; i++)
+  {
+    if (ring_.size() < history_size)
+      ring_.push_back(tail_[i]);
+    else
+    {
+      ring_[head_] = tail_[i];
+      head_ = (head_ + 1) % history_size;
+    }
+  }
+  tail_.erase(tail_.begin(), tail_.end() - 1);
+  return TRAIL_HISTORY;
+}
+visualization_msgs::Marker OdomTrail::history()
+{
+  visualization_msgs::Marker mkr = style_;
+  mkr.id = 0;
+  mkr.points.reserve(ring_.size());
+  mkr.points.insert(mkr.points.end(), ring_.begin() + head_, ring_.end());
+  mkr.points.insert(mkr.points.end(), ring_.begin(), ring_.begin() + head_);
+  return mkr;
+}
+visualization_msgs::Marker OdomTrail::tail()
+{
+  visualization_msgs::Marker mkr = style_;
+  mkr.id     = 1;
+  mkr.points = tail_;
+  return mkr;
+}
+void OdomTrail::clear()
+{
+  ring_.clear();
+  tail_.clear();
+  head_     = 0;
+  has_last_ = false;
+}
+} // end namespace theseus
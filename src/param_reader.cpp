@@ -11,10 +11,16 @@ ParamReader::ParamReader() :
     ROS_WARN("No param named 'turn_radius'");
   if (!(ros::param::get("pp/loiter_radius",loiter_radius)))
     ROS_WARN("No param named 'loiter_radius'");
+  // The angles are in degrees on the parameter server, the defaults already are in radians.
+	double deg2rad    = M_PI/180.0;
   if (!(ros::param::get("pp/max_climb_angle",max_climb_angle)))
     ROS_WARN("No param named 'max_climb_angle'");
+  else
+    max_climb_angle = max_climb_angle*deg2rad;
   if (!(ros::param::get("pp/max_descend_angle",max_descend_angle)))
     ROS_WARN("No param named 'max_descend_angle'");
+  else
+    max_descend_angle = max_descend_angle*deg2rad;
   if (!(ros::param::get("pp/clearance",clearance)))
     ROS_WARN("No param named 'clearance'");
   if (!(ros::param::get("pp/iters_limit",iters_limit)))
@@ -53,9 +59,25 @@ ParamReader::ParamReader() :
   nh_.param<double>("lon_ref", lon_ref, -76.428007);
   nh_.param<double>("h_ref", h_ref, 0.0);
 
-	double deg2rad    = M_PI/180.0;
-	max_climb_angle   = max_climb_angle*deg2rad;
-	max_descend_angle = max_descend_angle*deg2rad;
+  nh_.param<float>("pp/segment_length", segment_length, segment_length);
+  nh_.param<int>("pp/max_test_points", max_test_points, max_test_points);
+  nh_.param<float>("pp/clearance_shrink", clearance_shrink, clearance_shrink);
+  nh_.param<float>("pp/clearance_patience", clearance_patience, clearance_patience);
+  nh_.param<bool>("pp/reuse_trees", reuse_trees, reuse_trees);
+  nh_.param<int>("pp/leg_cache_size", leg_cache_size, leg_cache_size);
+  nh_.param<bool>("pp/visibility_graph", visibility_graph, visibility_graph);
+  nh_.param<bool>("pp/pipeline_smoothing", pipeline_smoothing, pipeline_smoothing);
+  nh_.param<int>("pp/speculative_legs", speculative_legs, speculative_legs);
+  float speculation_tolerance_deg;
+  nh_.param<float>("pp/speculation_tolerance", speculation_tolerance_deg, speculation_tolerance/deg2rad);
+  speculation_tolerance = speculation_tolerance_deg*deg2rad;
+  nh_.param<float>("pp/comfortable_altitude", comfortable_altitude, comfortable_altitude);
+  nh_.param<float>("pp/chi_take_off", chi_take_off, chi_take_off);
+  nh_.param<float>("pp/loiter_serch_alt", loiter_serch_alt, loiter_serch_alt);
+  nh_.param<int>("pp/roadmap_nodes", roadmap_nodes, roadmap_nodes);
+  nh_.param<float>("pp/roadmap_radius", roadmap_radius, roadmap_radius);
+  nh_.param<int>("pp/console_level", console_level, console_level);
+  nh_.param<int>("pp/event_ring_size", event_ring_size, event_ring_size);
 }
 ParamReader::~ParamReader()
 {
@@ -3,30 +3,51 @@
 namespace theseus
 {
 PathPlannerBase::PathPlannerBase() :
-  nh_(ros::NodeHandle())
+  nh_(ros::NodeHandle()),
+  state_nh_(ros::NodeHandle()),
+  state_spinner_(1, &state_queue_),
+  job_nh_(ros::NodeHandle()),
+  job_spinner_(11, &job_queue_)
 {
   //********************** PARAMETERS **********************//
+  logToRosconsole(input_file_.console_level);   // the planner's own messages
 
   //************** SUBSCRIBERS AND PUBLISHERS **************//
   recieved_state_         = false;
+  has_ending_point_       = false;
   has_map_                = false;
-  state_subscriber_       = nh_.subscribe("/state",100,&theseus::PathPlannerBase::stateCallback, this);
-  fstate_subscriber_      = nh_.subscribe("/fixedwing/state",100,&theseus::PathPlannerBase::stateCallback, this);
+  // The state has its own queue and thread so it never waits behind anything else, only the latest one matters.
+  state_nh_.setCallbackQueue(&state_queue_);
+  state_subscriber_       = state_nh_.subscribe("/state",1,&theseus::PathPlannerBase::stateCallback, this, ros::TransportHints().tcpNoDelay());
+  fstate_subscriber_      = state_nh_.subscribe("/fixedwing/state",1,&theseus::PathPlannerBase::stateCallback, this, ros::TransportHints().tcpNoDelay());
   mobs_subscriber_        = nh_.subscribe("/moving_obstacles",100,&theseus::PathPlannerBase::movingObsCallback, this);
   waypoint_client_        = nh_.serviceClient<rosplane_msgs::NewWaypoints>("/waypoint_path");
 
-  path_solver_service1_   = nh_.advertiseService("wps_now",&theseus::PathPlannerBase::wpsNow, this);
-  path_solver_service2_   = nh_.advertiseService("add_wps",&theseus::PathPlannerBase::addWps, this);
-  path_solver_service3_   = nh_.advertiseService("add_landing",&theseus::PathPlannerBase::addLanding, this);
-  path_solver_service4_   = nh_.advertiseService("add_textfile",&theseus::PathPlannerBase::addTextfile, this);
-  path_solver_service5_   = nh_.advertiseService("land_now",&theseus::PathPlannerBase::landNow, this);
-  path_solver_service6_   = nh_.advertiseService("textfile_now",&theseus::PathPlannerBase::textfileNow, this);
-  path_solver_service7_   = nh_.advertiseService("add_bomb",&theseus::PathPlannerBase::addBomb, this);
-  path_solver_service8_   = nh_.advertiseService("bomb_now",&theseus::PathPlannerBase::bombNow, this);
+  // The services that wait for their job have a thread each (11), so one that waits never holds up another
+  // (land_now can always preempt) or the timers and callbacks on nh_.
+  job_nh_.setCallbackQueue(&job_queue_);
+  path_solver_service1_   = job_nh_.advertiseService("wps_now",&theseus::PathPlannerBase::wpsNow, this);
+  path_solver_service2_   = job_nh_.advertiseService("add_wps",&theseus::PathPlannerBase::addWps, this);
+  path_solver_service3_   = job_nh_.advertiseService("add_landing",&theseus::PathPlannerBase::addLanding, this);
+  path_solver_service4_   = job_nh_.advertiseService("add_textfile",&theseus::PathPlannerBase::addTextfile, this);
+  path_solver_service5_   = job_nh_.advertiseService("land_now",&theseus::PathPlannerBase::landNow, this);
+  path_solver_service6_   = job_nh_.advertiseService("textfile_now",&theseus::PathPlannerBase::textfileNow, this);
+  path_solver_service7_   = job_nh_.advertiseService("add_bomb",&theseus::PathPlannerBase::addBomb, this);
+  path_solver_service8_   = job_nh_.advertiseService("bomb_now",&theseus::PathPlannerBase::bombNow, this);
+  plan_mission_service_   = job_nh_.advertiseService("plan_mission",&theseus::PathPlannerBase::planMission, this);
+  send_wps_service_       = job_nh_.advertiseService("send_waypoints",&theseus::PathPlannerBase::sendWaypoints, this);
+  tune_map_srv_           = job_nh_.advertiseService("tune_map",&theseus::PathPlannerBase::tuneMap, this);
+  // The same jobs without the wait, the message is the job id to look for on planner_progress.
+  const plan_job_e async_types[] = {JOB_WPS, JOB_WPS, JOB_LANDING, JOB_LANDING, JOB_TEXTFILE, JOB_TEXTFILE, JOB_BOMB, JOB_BOMB, JOB_TUNE};
+  const bool async_now[]         = {true,    false,   false,       true,        false,        true,         false,    true,     false};
+  const char* async_names[]      = {"wps_now_async", "add_wps_async", "add_landing_async", "land_now_async", "add_textfile_async",
+                                    "textfile_now_async", "add_bomb_async", "bomb_now_async", "tune_map_async"};
+  for (int i = 0; i < 9; i++)
+    async_services_.push_back(nh_.advertiseService<std_srvs::Trigger::Request, std_srvs::Trigger::Response>(async_names[i],
+      std::bind(&PathPlannerBase::queueAsync, this, async_types[i], async_now[i], std::string(async_names[i]),
+                std::placeholders::_1, std::placeholders::_2)));
 
   new_map_service_        = nh_.advertiseService("new_random_map",&theseus::PathPlannerBase::newRandomMap, this);
-  plan_mission_service_   = nh_.advertiseService("plan_mission",&theseus::PathPlannerBase::planMission, this);
-  send_wps_service_       = nh_.advertiseService("send_waypoints",&theseus::PathPlannerBase::sendWaypoints, this);
   replot_map_service_     = nh_.advertiseService("replot_map",&theseus::PathPlannerBase::displayMapService, this);
   wp_distance_service_    = nh_.advertiseService("display_wp_distance",&theseus::PathPlannerBase::displayD2WP, this);
 
@@ -34,6 +55,11 @@ PathPlannerBase::PathPlannerBase() :
   translate_map_srv_      = nh_.advertiseService("translate_map",&theseus::PathPlannerBase::translateMap, this);
   convert_ned_srv_        = nh_.advertiseService("convert_ned",&theseus::PathPlannerBase::convertNED, this);
   convert_gps_srv_        = nh_.advertiseService("convert_gps",&theseus::PathPlannerBase::convertGPS, this);
+  phase_stats_srv_        = nh_.advertiseService("phase_stats",&theseus::PathPlannerBase::phaseStats, this);
+  dump_events_srv_        = nh_.advertiseService("dump_events",&theseus::PathPlannerBase::dumpEvents, this);
+  progress_publisher_     = nh_.advertise<theseus::PlannerProgress>("planner_progress", 10);
+  metrics_publisher_      = nh_.advertise<theseus::PlannerMetrics>("planner_metrics", 10);
+  latency_publisher_      = nh_.advertise<theseus::PlannerLatency>("planner_latency", 1, true);
 
 
   //******************** CLASS VARIABLES *******************//
@@ -45,8 +71,60 @@ PathPlannerBase::PathPlannerBase() :
   update_viz_timer_ = nh_.createWallTimer(ros::WallDuration(1.0/4.0), &PathPlannerBase::updateViz, this);
 
   //********************** FUNCTIONS ***********************//
-  RRT rrt_obj(myWorld_, input_file_.seed);
+  RRT rrt_obj(myWorld_, input_file_.seed, input_file_);
   rrt_obj_ = rrt_obj;
+  rrt_obj_.setVizSink(&rrt_plt_);
+  nh_.param<bool>("pp/animate", rrt_obj_.animating_, true);
+  checks_ = 0;
+  rrt_obj_.col_det_.countChecks(&checks_);
+  roadmap_.setNumNodes(input_file_.roadmap_nodes > 0 ? input_file_.roadmap_nodes : 0);
+  roadmap_.setConnectionRadius(input_file_.roadmap_radius);
+  roadmap_.setConfig(input_file_);
+  rrt_obj_.setRoadmap(&roadmap_);
+  std::string ros_home = getenv("ROS_HOME") != NULL ? getenv("ROS_HOME") : std::string(getenv("HOME") != NULL ? getenv("HOME") : ".") + "/.ros";
+  nh_.param<std::string>("pp/map_artifact_dir", map_artifact_dir_, ros_home + "/theseus_maps");
+  map_artifact_pending_ = false;
+  nh_.param<bool>("pp/auto_tune", auto_tune_, false);
+  nh_.param<double>("pp/tune_time", tune_time_, 60.0);
+  nh_.param<float>("pp/tune_success_rate", tune_success_rate_, 0.95);
+  nh_.param<int>("pp/tune_problems", tune_problems_, 10);
+  tuning_    = planner_tuning_s(input_file_);
+  map_tuned_ = false;
+  nh_.param<bool>("pp/stream_legs", stream_legs_, false);
+  streamed_wps_ = 0;
+  sent_path_version_ = 0;
+  nh_.param<bool>("pp/latency_compensation", latency_compensation_, false);
+  nh_.param<double>("pp/initial_latency", latency_, 1.0);
+  latency_pending_ = false;
+  plan_requests_   = 0;
+  std::string request_log_dir;
+  nh_.param<std::string>("pp/request_log_dir", request_log_dir, "");
+  if (request_log_dir.empty() == false)
+  {
+    char name[64];
+    time_t now = time(NULL);
+    strftime(name, sizeof(name), "/theseus_requests_%Y%m%d_%H%M%S.bin", localtime(&now));
+    mkdir(request_log_dir.c_str(), 0755);
+    if (plan_log_.open(request_log_dir + name))
+      ROS_INFO("recording the planning requests to %s%s", request_log_dir.c_str(), name);
+    else
+      ROS_ERROR("couldn't open %s%s, the planning requests aren't recorded", request_log_dir.c_str(), name);
+  }
+  std::string trace_dir;
+  nh_.param<bool>("pp/phase_timers", phase_timers_, false);
+  nh_.param<std::string>("pp/trace_dir", trace_dir, "");
+  nh_.param<int>("pp/trace_max_events", trace_max_events_, 200000);
+  request_trace_ = NULL;
+  if (trace_dir.empty() == false)
+  {
+    char name[64];
+    time_t now = time(NULL);
+    strftime(name, sizeof(name), "/theseus_trace_%Y%m%d_%H%M%S_", localtime(&now));
+    mkdir(trace_dir.c_str(), 0755);
+    trace_prefix_ = trace_dir + name;
+    phase_timers_ = true;
+    ROS_INFO("writing a trace of every planning request to %s<request>.json", trace_prefix_.c_str());
+  }
 
   nh_.param<double>("lat_ref", lat_ref_, 38.144692);
   nh_.param<double>("lon_ref", lon_ref_, -76.428007);
@@ -67,26 +145,74 @@ PathPlannerBase::PathPlannerBase() :
     nh_.param<float>("testing/E_init", E_init, 0.0);
     nh_.param<float>("testing/D_init", D_init, -6.0);
     ROS_WARN("testing = true, initializing reference and initial position");
-    recieved_state_ =  true;
-    odometry_.N     = N_init;
-    odometry_.E     = E_init;
-    odometry_.D     = D_init;
-    chi0_           =  0.0f;
-    ending_point_ = odometry_;
-    ending_chi_   = chi0_;
+    vehicle_state_s state;
+    state.position.N  = N_init;
+    state.position.E  = E_init;
+    state.position.D  = D_init;
+    state.chi         = 0.0f;
+    nh_.param<float>("pp/Va", state.Va, 20.0);
+    state.stamp       = 0.0;
+    vehicle_state_.write(state);
+    recieved_state_   = true;
+    ending_point_     = state.position;
+    ending_chi_       = state.chi;
+    has_ending_point_ = true;
   }
+  state_spinner_.start();
+
+  //******************** PLANNING WORKER *******************//
+  job_running_        = false;
+  shutdown_           = false;
+  next_job_id_        = 1;
+  running_.id         = 0;
+  progress_.cancel    = false;
+  progress_.leg       = 0;
+  progress_.num_legs  = 0;
+  progress_.nodes     = 0;
+  progress_.total_nodes = 0;
+  progress_.smooth_us   = 0;
+  rrt_obj_.setProgress(&progress_);
+  double latency_report_period;
+  nh_.param<double>("pp/latency_window", latency_window_, 300.0);
+  nh_.param<double>("pp/latency_report_period", latency_report_period, 10.0);
+  if (latency_report_period > 0.0)
+    latency_timer_ = nh_.createWallTimer(ros::WallDuration(latency_report_period), &PathPlannerBase::publishLatency, this);
+  worker_ = std::thread(&PathPlannerBase::plannerThread, this);
+  job_spinner_.start();
 }
 PathPlannerBase::~PathPlannerBase()
 {
-
+  state_spinner_.stop();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    shutdown_        = true;
+    progress_.stop();
+  }
+  queue_cv_.notify_all();
+  finished_cv_.notify_all();                  // the services that wait give up
+  if (worker_.joinable())
+    worker_.join();
+  job_spinner_.stop();
 }
 bool PathPlannerBase::planMission(uav_msgs::GeneratePath::Request &req, uav_msgs::GeneratePath::Response &res)
+{
+  plan_job_s job = makeJob(JOB_MISSION, req.mission.now, "plan_mission");
+  if (req.mission.mission_type == req.mission.MISSION_TYPE_LAND && req.mission.now)
+    job.priority = PRIORITY_LAND_NOW;
+  job.mission = req;
+  std_srvs::Trigger::Response result;
+  waitForJob(job, result);
+  if (result.success == false)
+    ROS_ERROR("plan_mission: %s", result.message.c_str());
+  return result.success;                      // GeneratePath has nothing to put the result in, a failed plan fails the call
+}
+bool PathPlannerBase::mission(uav_msgs::GeneratePath::Request req)
 {
   rrtOptions options;
   if (recieved_state_ == false)
   {
     ROS_ERROR("PATH PLANNER HAS NOT RECIEVED AN INITIAL STATE");
-    return true;
+    return false;
   }
   int num_waypoints  = req.mission.waypoints.size();
   int num_boundaries = req.mission.boundaries.size();
@@ -213,27 +339,31 @@ bool PathPlannerBase::planMission(uav_msgs::GeneratePath::Request &req, uav_msgs
   else
   {
     ROS_FATAL("unknown mission type");
-    return true;
+    return false;
   }
   ROS_INFO("RECIEVED JUDGES' MAP");
   myWorld_ = mission_map;
-  rrt_obj_.newMap(mission_map);
-  if (has_map_ == false)
+  prepareMap(mission_map);
   {
-    cyl_distances_.clear();
-    for (int i = 0; i < rrt_obj_.map_.cylinders.size(); i++)
-      cyl_distances_.push_back(INFINITY);
-    min_cyl_dis_ = INFINITY;
-  }
-  has_map_ = true;
-  if (req.mission.mission_type == req.mission.MISSION_TYPE_WAYPOINT)
-  {
-    wp_distances_.clear();
-    waypoints_to_hit_.clear();
-    for (int i = 0; i < rrt_obj_.map_.wps.size(); i++)
+    std::lock_guard<std::mutex> distance_lock(distance_mutex_);
+    if (has_map_ == false)
     {
-      wp_distances_.push_back(INFINITY);
-      waypoints_to_hit_.push_back(rrt_obj_.map_.wps[i]);
+      distance_cylinders_ = rrt_obj_.map_.cylinders;
+      cyl_distances_.clear();
+      for (int i = 0; i < distance_cylinders_.size(); i++)
+        cyl_distances_.push_back(INFINITY);
+      min_cyl_dis_ = INFINITY;
+    }
+    has_map_ = true;
+    if (req.mission.mission_type == req.mission.MISSION_TYPE_WAYPOINT)
+    {
+      wp_distances_.clear();
+      waypoints_to_hit_.clear();
+      for (int i = 0; i < rrt_obj_.map_.wps.size(); i++)
+      {
+        wp_distances_.push_back(INFINITY);
+        waypoints_to_hit_.push_back(rrt_obj_.map_.wps[i]);
+      }
     }
   }
   NED_s ref_zero(0.0f, 0.0f, 0.0f);
@@ -244,15 +374,22 @@ bool PathPlannerBase::planMission(uav_msgs::GeneratePath::Request &req, uav_msgs
     if ((myWorld_.boundary_pts[0] - ref_zero).norm() > 160934.0f)
     {
       ROS_FATAL("GPS REFERENCE POINT IS MORE THAN 100 MILES FROM FIRST BOUNDARY POINT");
-      return true;
+      return false;
     }
   }
-  solveStatic(options);
+  bool solved_path = solveStatic(options);
   ROS_INFO("End of planMisison");
-  return true;
+  return solved_path;
 }
 bool PathPlannerBase::newRandomMap(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
 {
+  std::unique_lock<std::mutex> planner_lock(planner_mutex_, std::try_to_lock);
+  if (planner_lock.owns_lock() == false)
+  {
+    res.success = false;
+    res.message = "the planner is busy";
+    return true;
+  }
   getInitialMap();
   ROS_INFO("RECIEVED NEW RANDOM MAP");
   plt.clearRViz(myWorld_);
@@ -282,12 +419,40 @@ bool PathPlannerBase::solveStatic(rrtOptions options)
     rrt_obj_.newMap(myWorld_);
   }
 
+  vehicle_state_s state = vehicle_state_.read();
+  if (has_ending_point_ == false)
+  {
+    ending_point_     = state.position;
+    ending_chi_       = state.chi;
+    has_ending_point_ = true;
+  }
   float initial_chi;
   NED_s initial_pos;
   if (options.now)
   {
-    initial_chi = chi0_;
-    initial_pos = odometry_;
+    initial_chi = state.chi;
+    initial_pos = state.position;
+    if (latency_compensation_)
+    {
+      // The plane keeps flying the old path while this one is planned and uploaded, start where it will be by then.
+      // Everything is timed on the clock of the state messages, which is sim time in simulation.
+      double now       = ros::Time::now().toSec();
+      double lead_time = latency_;
+      if (state.stamp > 0.0)
+        lead_time += std::max(0.0, now - state.stamp);
+      vehicle_state_s predicted = predictState(state, lead_time);
+      if (rrt_obj_.checkPoint(predicted.position, 1.0f))
+      {
+        ROS_INFO("planning from %.1f m ahead of the plane (%.2f s)", (predicted.position - state.position).norm(), lead_time);
+        initial_chi = predicted.chi;
+        initial_pos = predicted.position;
+      }
+      else
+        ROS_WARN("the predicted position violates an obstacle or boundary, planning from the current one");
+      plan_start_      = now;
+      latency_pending_ = true;
+      now_start_       = initial_pos;
+    }
   }
   else
   {
@@ -298,39 +463,133 @@ bool PathPlannerBase::solveStatic(rrtOptions options)
   for (int j = 0; j < myWorld_.wps.size(); j++)
     all_primary_wps_.push_back(myWorld_.wps[j]);
   plt.displayPrimaryWaypoints(all_primary_wps_);
+  streamed_wps_ = 0;
+  if (stream_legs_ && options.now)
+    rrt_obj_.setLegCallback(std::bind(&PathPlannerBase::streamLeg, this, std::placeholders::_1));
+
+  // Every request gets a random sequence of its own, so what it plans only depends on what is in the request log.
+  plan_request_s request;
+  request.id             = plan_requests_++;
+  request.stamp          = ros::WallTime::now().toSec();
+  request.seed           = input_file_.seed + request.id;
+  request.pos            = initial_pos;
+  request.chi            = initial_chi;
+  request.now            = options.now;
+  request.direct_hit     = options.direct_hit;
+  request.landing        = options.landing;
+  request.drop_bomb      = options.drop_bomb;
+  request.loiter_mission = options.loiter_mission;
+  request.roadmap_ready  = roadmap_.ready(LegCache::hashMap(rrt_obj_.map_));
+  request.animating      = rrt_obj_.animating_;
+  request.map            = rrt_obj_.map_;
+  request.config         = input_file_;
+  tuning_.apply(&request.config);
+  rrt_obj_.setRoadmap(request.roadmap_ready ? &roadmap_ : NULL); // as the request log has it, the build could finish mid-solve
+  rrt_obj_.newSeed(request.seed, true);
+  if (plan_log_.isOpen() && plan_log_.write(request) == false)
+    ROS_WARN("couldn't record planning request %u", request.id);
+  if (phase_timers_)
+  {
+    phase_trace_.start(trace_max_events_ > 0 ? trace_max_events_ : 0);
+    request_trace_ = &phase_trace_;
+    rrt_obj_.setTrace(request_trace_);
+  }
+  std::chrono::steady_clock::time_point solve_start = std::chrono::steady_clock::now();
   bool solved_path = rrt_obj_.solveStatic(initial_pos, initial_chi, options.direct_hit, options.landing, options.drop_bomb, options.loiter_mission);
+  double solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - solve_start).count();
+  plan_time_   += solve_time;
+  smooth_time_ += progress_.smooth_us*1.0e-6;
+  plan_nodes_  += progress_.total_nodes;
+  rrt_obj_.setLegCallback(std::function<void(unsigned int)>());
+  if (plan_log_.isOpen())
+  {
+    plan_result_s result;
+    result.id         = request.id;
+    result.solved     = solved_path;
+    result.solve_time = solve_time;
+    result.nodes      = progress_.total_nodes;
+    result.wps        = rrt_obj_.all_wps_;
+    if (plan_log_.write(result) == false)
+      ROS_WARN("couldn't record the result of planning request %u", request.id);
+  }
+  if (solved_path == false && streamed_wps_ > 0)
+  {
+    // The autopilot would fly off the end of what it has, it loiters there until it gets a new path.
+    ROS_ERROR("the path failed after %u waypoints were streamed to the autopilot", streamed_wps_);
+    job_note_ = "the path failed after " + std::to_string(streamed_wps_) + " waypoints were streamed, ";
+    job_note_ += loiterAtStreamed() ? "the plane loiters at the last one" : "the loiter point couldn't be sent";
+  }
   if (solved_path)
   {
     if (options.now)
-    sendWaypointsCore(options.now);
+      sendWaypointsCore(streamed_wps_ == 0, streamed_wps_, rrt_obj_.all_wps_.size());
     plt.displayPath(initial_pos, rrt_obj_.all_wps_, clr.green, 8.0);
     // plt.addFinalPath(initial_pos, rrt_obj_.all_wps_);
     if (rrt_obj_.landing_now_ == false)
       plt.drawCircle(rrt_obj_.all_wps_.back(), input_file_.loiter_radius);
   }
+  finishTrace(request.id);
+  return solved_path;
+}
+void PathPlannerBase::finishTrace(unsigned int id)
+{
+  if (request_trace_ == NULL)
+    return;
+  rrt_obj_.setTrace(NULL);
+  request_trace_ = NULL;
+  phase_stats_.add(phase_trace_.histograms());
+  if (trace_prefix_.empty())
+    return;
+  char label[64];
+  snprintf(label, sizeof(label), "planning request %u", id);
+  std::string file_name = trace_prefix_ + std::to_string(id) + ".json";
+  if (phase_trace_.writeChromeTrace(file_name, label) == false)
+    ROS_WARN("couldn't write the trace of planning request %u to %s", id, file_name.c_str());
+  else if (phase_trace_.dropped() > 0)
+    ROS_WARN("the trace of planning request %u is missing its last %lu events (pp/trace_max_events)", id, phase_trace_.dropped());
+}
+bool PathPlannerBase::phaseStats(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
+{
+  if (phase_timers_ == false)
+  {
+    res.success = false;
+    res.message = "the phase timers are off (pp/phase_timers)";
+    return true;
+  }
+  res.success = true;
+  res.message = phase_stats_.report();
   return true;
 }
-bool PathPlannerBase::wpsNow(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
+bool PathPlannerBase::dumpEvents(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  if (has_map_ == false)
-    getInitialMap();
-  else
+  // The ring is written without locks, it can be read while a request is planning.
+  std::shared_ptr<EventRing> events = rrt_obj_.events_;
+  if (!events)
   {
-    myWorld_.wps.clear();
-    myWorld_.wps = last_primary_wps_;
-    rrt_obj_.newMap(myWorld_);
+    res.success = false;
+    res.message = "the planner events are off (pp/event_ring_size)";
+    return true;
   }
-  rrtOptions options;
-  options.landing = false;
-  options.direct_hit = true;
-  options.now = true;
-  options.check_wps = false;
-  options.drop_bomb = false;
-  options.loiter_mission = false;
-  res.success = solveStatic(options);
+  char name[64];
+  time_t now = time(NULL);
+  strftime(name, sizeof(name), "theseus_events_%Y%m%d_%H%M%S.txt", localtime(&now));
+  res.success = events->dump(name);
+  res.message = res.success ? name : std::string("couldn't write ") + name;
   return true;
 }
+bool PathPlannerBase::tuneMap(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
+{
+  return waitForJob(makeJob(JOB_TUNE, false, "tune_map"), res);
+}
+bool PathPlannerBase::wpsNow(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
+{
+  return waitForJob(makeJob(JOB_WPS, true, "wps_now"), res);
+}
 bool PathPlannerBase::addWps(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
+{
+  return waitForJob(makeJob(JOB_WPS, false, "add_wps"), res);
+}
+bool PathPlannerBase::wps(bool now)
 {
   if (has_map_ == false)
     getInitialMap();
@@ -343,12 +602,11 @@ bool PathPlannerBase::addWps(std_srvs::Trigger::Request &req, std_srvs::Trigger:
   rrtOptions options;
   options.landing = false;
   options.direct_hit = true;
-  options.now = false;
+  options.now = now;
   options.check_wps = false;
   options.drop_bomb = false;
   options.loiter_mission = false;
-  res.success = solveStatic(options);
-  return true;
+  return solveStatic(options);
 }
 bool PathPlannerBase::landing(bool now)
 {
@@ -395,13 +653,11 @@ bool PathPlannerBase::landing(bool now)
 }
 bool PathPlannerBase::addLanding(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = landing(false);
-  return true;
+  return waitForJob(makeJob(JOB_LANDING, false, "add_landing"), res);
 }
 bool PathPlannerBase::landNow(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = landing(true);
-  return true;
+  return waitForJob(makeJob(JOB_LANDING, true, "land_now"), res);
 }
 bool PathPlannerBase::textfile(bool now)
 {
@@ -436,23 +692,19 @@ bool PathPlannerBase::textfile(bool now)
 }
 bool PathPlannerBase::addTextfile(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = textfile(false);
-  return true;
+  return waitForJob(makeJob(JOB_TEXTFILE, false, "add_textfile"), res);
 }
 bool PathPlannerBase::textfileNow(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = textfile(true);
-  return true;
+  return waitForJob(makeJob(JOB_TEXTFILE, true, "textfile_now"), res);
 }
 bool PathPlannerBase::bombNow(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = bomb(true);
-  return true;
+  return waitForJob(makeJob(JOB_BOMB, true, "bomb_now"), res);
 }
 bool PathPlannerBase::addBomb(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
-  res.success = bomb(false);
-  return true;
+  return waitForJob(makeJob(JOB_BOMB, false, "add_bomb"), res);
 }
 bool PathPlannerBase::bomb(bool now)
 {
@@ -482,16 +734,26 @@ bool PathPlannerBase::bomb(bool now)
 }
 bool PathPlannerBase::displayMapService(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
+  std::unique_lock<std::mutex> planner_lock(planner_mutex_, std::try_to_lock);
+  if (planner_lock.owns_lock() == false)
+  {
+    res.success = false;
+    res.message = "the planner is busy";
+    return true;
+  }
   if (has_map_ == false)
     getInitialMap();
   plt.displayMap(myWorld_);
   if (all_primary_wps_.size() > 0)
     plt.displayPrimaryWaypoints(all_primary_wps_);
+  if (sent_path_version_ > 0)
+    plt.redrawPath(sent_path_version_, clr.purple, 5.0);  // the path isn't latched, a new rviz hasn't seen it
   res.success = true;
   return true;
 }
 bool PathPlannerBase::displayD2WP(std_srvs::Trigger::Request &req, std_srvs::Trigger:: Response &res)
 {
+  std::lock_guard<std::mutex> distance_lock(distance_mutex_);
   float avg_min_wp_dis_ = 0.0;
   float waypoint_count = 0.0;
   for (int i = 0; i < wp_distances_.size(); i++)
@@ -510,25 +772,44 @@ bool PathPlannerBase::displayD2WP(std_srvs::Trigger::Request &req, std_srvs::Tri
 }
 bool PathPlannerBase::sendWaypointsCore(bool now)
 {
+  return sendWaypointsCore(now, 0, rrt_obj_.all_wps_.size());
+}
+bool PathPlannerBase::sendWaypointsCore(bool now, unsigned int first, unsigned int end)
+{
+  // Sends all_wps_[first, end), the end of the path (loiter or landing) is only handled once end reaches it.
+  ScopedPhase phase(request_trace_, "upload");
+  bool last_batch = end == rrt_obj_.all_wps_.size();
+  if (now && latency_pending_)
+  {
+    // The plane may have flown past the predicted start already, it shouldn't turn back for what it passed.
+    NED_s position = vehicle_state_.read().position;
+    NED_s previous = now_start_;
+    while (first + 1 < end && rrt_obj_.all_drop_bombs_[first] == false && \
+           (position - rrt_obj_.all_wps_[first]).dot(rrt_obj_.all_wps_[first] - previous) > 0.0f)
+    {
+      previous = rrt_obj_.all_wps_[first];
+      first++;
+    }
+  }
   rosplane_msgs::NewWaypoints srv;
   rosplane_msgs::Waypoint new_waypoint;
   NED_s in_front;
-  for (long unsigned int i = 0; i < rrt_obj_.all_wps_.size(); i++)
+  for (long unsigned int i = first; i < end; i++)
   {
     new_waypoint.drop_bomb = rrt_obj_.all_drop_bombs_[i];
     new_waypoint.landing = false;
-    if (rrt_obj_.landing_now_ && i >= rrt_obj_.all_wps_.size() - 1 - 1) // landing = true on the last 2 waypoints
+    if (last_batch && rrt_obj_.landing_now_ && i >= rrt_obj_.all_wps_.size() - 1 - 1) // landing = true on the last 2 waypoints
       new_waypoint.landing = true;
     new_waypoint.w[0] = rrt_obj_.all_wps_[i].N;
     new_waypoint.w[1] = rrt_obj_.all_wps_[i].E;
     new_waypoint.w[2] = rrt_obj_.all_wps_[i].D;
     nh_.param<float>("pp/Va", new_waypoint.Va_d, 20.0);
-    if (rrt_obj_.landing_now_ == false && i == rrt_obj_.all_wps_.size() - 1)
+    if (last_batch && rrt_obj_.landing_now_ == false && i == rrt_obj_.all_wps_.size() - 1)
       new_waypoint.loiter_point  = true;
     else
       new_waypoint.loiter_point  = false;
     new_waypoint.priority = rrt_obj_.all_priorities_[i];
-    if (now == true && i == 0)
+    if (now == true && i == first)
       new_waypoint.set_current = true;
     else
       new_waypoint.set_current = false;
@@ -572,19 +853,37 @@ bool PathPlannerBase::sendWaypointsCore(bool now)
     srv.request.waypoints.push_back(new_waypoint); // new_waypoint.loiter_point already = true
   }
   bool found_service = ros::service::waitForService("/waypoint_path", ros::Duration(1.0));
-  while (found_service == false)
+  while (found_service == false && progress_.cancel == false && ros::ok())
   {
     ROS_WARN("No waypoint server found. Checking again.");
     found_service = ros::service::waitForService("/waypoint_path", ros::Duration(1.0));
   }
+  if (found_service == false)
+  {
+    ROS_ERROR("the job stopped before a waypoint server was found, the waypoints weren't sent");
+    return false;
+  }
+  std::chrono::steady_clock::time_point upload_start = std::chrono::steady_clock::now();
   bool sent_correctly = waypoint_client_.call(srv);
+  upload_time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - upload_start).count();
+  uploads_++;
   if (sent_correctly)
     ROS_INFO("Waypoints succesfully sent");
   else
     ROS_ERROR("Waypoint server unsuccessful");
+  if (now && latency_pending_)
+  {
+    double latency   = ros::Time::now().toSec() - plan_start_;
+    latency_        += 0.3*(latency - latency_);
+    latency_pending_ = false;
+    ROS_INFO("the now path was uploaded %.2f s after the state was read, expecting %.2f s next time", latency, latency_);
+  }
 
-  ending_point_ = rrt_obj_.ending_point_;
-  ending_chi_ = rrt_obj_.ending_chi_;
+  if (last_batch)
+  {
+    ending_point_ = rrt_obj_.ending_point_;
+    ending_chi_ = rrt_obj_.ending_chi_;
+  }
   int priority_level = 0;
   for (int i = 0; i < srv.request.waypoints.size(); i++)
     if (srv.request.waypoints[i].priority > priority_level)
@@ -607,7 +906,7 @@ bool PathPlannerBase::sendWaypointsCore(bool now)
     if (all_sent_wps_.size() == 0)
     {
       all_sent_priorities_.push_back(4);
-      all_sent_wps_.push_back(odometry_);
+      all_sent_wps_.push_back(vehicle_state_.read().position);
     }
     NED_s next_wp;
     next_wp.N = srv.request.waypoints[i].w[0];
@@ -618,14 +917,122 @@ bool PathPlannerBase::sendWaypointsCore(bool now)
   }
   plt.display_on_judges_map_ = true;
   plt.clearRViz(myWorld_, all_sent_wps_, clr.purple, 5.0);
+  sent_path_version_ = plt.pathVersion();
   plt.displayPrimaryWaypoints(all_primary_wps_);
   if (srv.request.waypoints.back().loiter_point == true)
     plt.drawCircle(in_front, input_file_.loiter_radius);
   return sent_correctly;
 }
+vehicle_state_s PathPlannerBase::predictState(vehicle_state_s state, double lead_time)
+{
+  // Moves the state lead_time along the path the autopilot was last given (all_sent_wps_), or straight ahead
+  // if the plane isn't following it.
+  float Va = state.Va;
+  if (Va < 1.0f)
+    nh_.param<float>("pp/Va", Va, 20.0);
+  float distance = Va*lead_time;
+  vehicle_state_s predicted = state;
+  int closest       = -1;
+  float closest_d   = INFINITY;
+  NED_s on_path;
+  for (int j = 0; j + 1 < (int) all_sent_wps_.size(); j++)
+  {
+    NED_s a  = all_sent_wps_[j];
+    NED_s ab = all_sent_wps_[j + 1] - a;
+    float length2 = ab.N*ab.N + ab.E*ab.E;
+    if (length2 < 0.0001f)
+      continue;
+    float t = ((state.position.N - a.N)*ab.N + (state.position.E - a.E)*ab.E)/length2;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    NED_s q = a + ab*t;
+    float d = sqrtf(powf(state.position.N - q.N, 2.0f) + powf(state.position.E - q.E, 2.0f));
+    if (d < closest_d)
+    {
+      closest   = j;
+      closest_d = d;
+      on_path   = q;
+    }
+  }
+  if (closest < 0 || closest_d > 2.0f*input_file_.turn_radius)
+  {
+    predicted.position.N += distance*cosf(state.chi);
+    predicted.position.E += distance*sinf(state.chi);
+    return predicted;
+  }
+  // If the path runs out the plane is about to loiter at its end, that's as far as it's predicted.
+  NED_s p = on_path;
+  for (int j = closest; j + 1 < (int) all_sent_wps_.size() && distance > 0.0f; j++)
+  {
+    NED_s b    = all_sent_wps_[j + 1];
+    float left = (b - p).norm();
+    if (left > 0.0001f)
+      predicted.chi = (b - all_sent_wps_[j]).getChi();
+    if (left >= distance)
+    {
+      p = p + (b - p).normalize()*distance;
+      distance = 0.0f;
+    }
+    else
+    {
+      p = b;
+      distance -= left;
+    }
+  }
+  predicted.position = p;
+  return predicted;
+}
+void PathPlannerBase::streamLeg(unsigned int i)
+{
+  // The last waypoint is held back, it is the loiter point if this turns out to be the last leg.
+  unsigned int end = rrt_obj_.all_wps_.size() - 1;
+  if (end <= streamed_wps_)
+    return;
+  ROS_INFO("streaming the route to waypoint %u to the autopilot", i + 1);
+  sendWaypointsCore(streamed_wps_ == 0, streamed_wps_, end);
+  streamed_wps_ = end;
+}
+bool PathPlannerBase::loiterAtStreamed()
+{
+  if (all_sent_wps_.size() < 2)
+    return false;
+  NED_s last     = all_sent_wps_.back();
+  NED_s heading  = (last - all_sent_wps_[all_sent_wps_.size() - 2]).normalize();
+  NED_s in_front = last + heading*0.1;
+  rosplane_msgs::NewWaypoints srv;
+  rosplane_msgs::Waypoint new_waypoint;
+  new_waypoint.drop_bomb     = false;
+  new_waypoint.landing       = false;
+  new_waypoint.w[0]          = in_front.N;
+  new_waypoint.w[1]          = in_front.E;
+  new_waypoint.w[2]          = in_front.D;
+  nh_.param<float>("pp/Va", new_waypoint.Va_d, 20.0);
+  new_waypoint.loiter_point  = true;
+  new_waypoint.priority      = 3;
+  new_waypoint.set_current   = false;
+  new_waypoint.clear_wp_list = false;
+  srv.request.waypoints.push_back(new_waypoint);
+  bool sent_correctly = waypoint_client_.call(srv);
+  if (sent_correctly == false)
+  {
+    ROS_ERROR("the loiter point at the end of the streamed path wasn't sent");
+    return false;
+  }
+  uploads_++;
+  all_sent_priorities_.push_back(3);
+  all_sent_wps_.push_back(in_front);
+  ending_point_ = last;                       // the next path that is added starts there
+  ending_chi_   = heading.getChi();
+  plt.clearRViz(myWorld_, all_sent_wps_, clr.purple, 5.0);
+  sent_path_version_ = plt.pathVersion();
+  plt.displayPrimaryWaypoints(all_primary_wps_);
+  plt.drawCircle(in_front, input_file_.loiter_radius);
+  return true;
+}
 bool PathPlannerBase::sendWaypoints(uav_msgs::UploadPath::Request &req, uav_msgs::UploadPath::Response &res)
 {
-  res.success = sendWaypointsCore(false);
+  std_srvs::Trigger::Response result;
+  waitForJob(makeJob(JOB_SEND, false, "send_waypoints"), result); // goes after the jobs that are already queued
+  res.success = result.success;
   return true;
 }
 bool PathPlannerBase::translateBoundaries(theseus::GPS::Request &req, theseus::GPS::Response &res)
@@ -655,6 +1062,12 @@ bool PathPlannerBase::translateMap(theseus::GPS::Request &req, theseus::GPS::Res
     ROS_INFO("Reference height: %f", req.height);
     gps_converter.set_reference(req.lat, req.lon, req.height);
   }
+  std::unique_lock<std::mutex> planner_lock(planner_mutex_, std::try_to_lock);
+  if (planner_lock.owns_lock() == false)
+  {
+    ROS_WARN("the planner is busy, try again once it is done");
+    return false;                 // the response has no field to say so, the call fails instead
+  }
   if (has_map_ == false)
     getInitialMap();
   for (int i = 0; i < myWorld_.boundary_pts.size(); i++)
@@ -723,6 +1136,228 @@ bool PathPlannerBase::convertGPS(theseus::GPS::Request &req, theseus::GPS::Respo
   ROS_INFO("point north: %f, east: %f, down: %f", N, E, D);
   return true;
 }
+void PathPlannerBase::plannerThread()
+{
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  while (true)
+  {
+    while (jobs_.empty() && shutdown_ == false)
+      queue_cv_.wait(lock);
+    if (shutdown_)
+      break;
+    running_ = jobs_.front();
+    jobs_.pop_front();
+    job_running_       = true;
+    progress_.cancel   = false;
+    progress_.leg      = 0;
+    progress_.num_legs = 0;
+    progress_.nodes    = 0;
+    progress_.total_nodes = 0;
+    progress_.smooth_us   = 0;
+    plan_job_s job     = running_;
+    publishProgress(job, PlannerProgress::RUNNING, jobs_.size());
+    lock.unlock();
+
+    ROS_INFO("running job %u (%s)", job.id, job.name.c_str());
+    job_note_.clear();
+    std::chrono::steady_clock::time_point job_start = std::chrono::steady_clock::now();
+    unsigned long checks_at_start = checks_;
+    plan_time_   = 0.0;
+    smooth_time_ = 0.0;
+    upload_time_ = 0.0;
+    uploads_     = 0;
+    plan_nodes_  = 0;
+    bool success;
+    {
+      // Tuning takes the lock itself, it waits for the roadmap and plans its problems without it.
+      std::unique_lock<std::mutex> planner_lock(planner_mutex_, std::defer_lock);
+      if (job.type != JOB_TUNE)
+        planner_lock.lock();
+      success = runJob(job);
+    }
+
+    lock.lock();
+    job_running_ = false;
+    uint8_t state;
+    if (success)
+      state = PlannerProgress::DONE;
+    else if (progress_.cancel)
+      state = PlannerProgress::PREEMPTED;
+    else
+      state = PlannerProgress::FAILED;
+    finishJob(job, state, jobs_.size(), job_note_);
+    publishMetrics(job, state, job_start, checks_at_start);
+  }
+}
+plan_job_s PathPlannerBase::makeJob(plan_job_e type, bool now, std::string name)
+{
+  plan_job_s job;
+  job.type     = type;
+  job.now      = now;
+  job.id       = 0;
+  job.name     = name;
+  job.priority = PRIORITY_ADD;
+  job.queued   = std::chrono::steady_clock::now();
+  job.wait     = false;
+  if (now)
+    job.priority = PRIORITY_NOW;
+  if (now && type == JOB_LANDING)
+    job.priority = PRIORITY_LAND_NOW;
+  if (type == JOB_TUNE)
+    job.priority = PRIORITY_TUNE;
+  return job;
+}
+unsigned int PathPlannerBase::queueJob(plan_job_s job)
+{
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  job.id = next_job_id_++;
+  // A request of the same kind replaces the queued one, a now job makes the queued now jobs below it pointless
+  // and landing now drops everything.
+  for (int j = 0; j < jobs_.size(); j++)
+    if ((jobs_[j].type == job.type && jobs_[j].now == job.now) ||
+        (job.now && jobs_[j].now && jobs_[j].priority <= job.priority) ||
+        job.priority == PRIORITY_LAND_NOW)
+    {
+      ROS_INFO("job %u (%s) was replaced by job %u (%s)", jobs_[j].id, jobs_[j].name.c_str(), job.id, job.name.c_str());
+      finishJob(jobs_[j], PlannerProgress::COALESCED, jobs_.size() - 1, "");
+      jobs_.erase(jobs_.begin() + j);
+      j--;
+    }
+  std::deque<plan_job_s>::iterator it = jobs_.begin();
+  while (it != jobs_.end() && it->priority >= job.priority)
+    it++;
+  jobs_.insert(it, job);
+  if (job_running_ && (job.now || running_.type == JOB_TUNE) && running_.priority < job.priority)
+  {
+    ROS_WARN("job %u (%s) preempts job %u (%s)", job.id, job.name.c_str(), running_.id, running_.name.c_str());
+    progress_.stop();
+  }
+  publishProgress(job, PlannerProgress::QUEUED, jobs_.size());
+  queue_cv_.notify_one();
+  return job.id;
+}
+void PathPlannerBase::finishJob(plan_job_s job, uint8_t state, unsigned int queued, std::string note)
+{
+  publishProgress(job, state, queued);
+  if (job.wait)
+  {
+    finished_[job.id].state = state;
+    finished_[job.id].note  = note;
+    finished_cv_.notify_all();
+  }
+}
+bool PathPlannerBase::waitForJob(plan_job_s job, std_srvs::Trigger::Response &res)
+{
+  job.wait = true;
+  unsigned int id = queueJob(job);
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  while (finished_.count(id) == 0 && shutdown_ == false)
+    finished_cv_.wait(lock);
+  res.success = false;
+  if (finished_.count(id) == 0)
+  {
+    res.message = "job " + std::to_string(id) + " didn't run, the planner is shutting down";
+    return true;
+  }
+  uint8_t state    = finished_[id].state;
+  std::string note = finished_[id].note;
+  finished_.erase(id);
+  res.success = state == PlannerProgress::DONE;
+  if (state == PlannerProgress::DONE)
+    res.message = "job " + std::to_string(id) + " is done";
+  else if (state == PlannerProgress::PREEMPTED)
+    res.message = "job " + std::to_string(id) + " was preempted by a request of higher priority";
+  else if (state == PlannerProgress::COALESCED)
+    res.message = "job " + std::to_string(id) + " was replaced by a newer request of the same kind before it ran";
+  else
+    res.message = "job " + std::to_string(id) + " failed";
+  if (note.empty() == false)
+    res.message += ", " + note;
+  return true;
+}
+bool PathPlannerBase::queueAsync(plan_job_e type, bool now, std::string name, std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
+{
+  unsigned int id = queueJob(makeJob(type, now, name));
+  res.success = true;                         // queued, how the job ends is on planner_progress
+  res.message = std::to_string(id);
+  return true;
+}
+bool PathPlannerBase::runJob(plan_job_s job)
+{
+  switch (job.type)
+  {
+    case JOB_WPS:      return wps(job.now);
+    case JOB_LANDING:  return landing(job.now);
+    case JOB_TEXTFILE: return textfile(job.now);
+    case JOB_BOMB:     return bomb(job.now);
+    case JOB_MISSION:  return mission(job.mission);
+    case JOB_SEND:     return sendWaypointsCore(false);
+    case JOB_TUNE:     return tune();
+  }
+  return false;
+}
+void PathPlannerBase::publishProgress(plan_job_s job, uint8_t state, unsigned int queued)
+{
+  PlannerProgress msg;
+  msg.job_id   = job.id;
+  msg.job      = job.name;
+  msg.state    = state;
+  if (job.id == running_.id)      // the others haven't started
+  {
+    msg.leg      = progress_.leg;
+    msg.num_legs = progress_.num_legs;
+    msg.nodes    = progress_.nodes;
+  }
+  msg.queued   = queued;
+  progress_publisher_.publish(msg);
+}
+void PathPlannerBase::publishMetrics(plan_job_s job, uint8_t state, std::chrono::steady_clock::time_point start, unsigned long checks_at_start)
+{
+  PlannerMetrics msg;
+  msg.job_id      = job.id;
+  msg.job         = job.name;
+  msg.result      = state;
+  msg.queue_wait  = std::chrono::duration<double>(start - job.queued).count();
+  msg.plan_time   = plan_time_;
+  msg.smooth_time = smooth_time_;
+  msg.upload_time = upload_time_;
+  msg.uploads     = uploads_;
+  msg.total_time  = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.queued).count();
+  msg.nodes       = plan_nodes_;
+  msg.checks      = checks_ - checks_at_start;
+  msg.waypoints   = rrt_obj_.all_wps_.size();
+  metrics_publisher_.publish(msg);
+  // A preempted job didn't finish, its time says nothing about how long the service takes. Tuning isn't planning.
+  if ((state != PlannerProgress::DONE && state != PlannerProgress::FAILED) || job.type == JOB_TUNE)
+    return;
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  std::map<std::string, LatencyWindow>::iterator it = service_latency_.find(job.name);
+  if (it == service_latency_.end())
+    it = service_latency_.insert(std::make_pair(job.name, LatencyWindow(latency_window_, 10))).first;
+  it->second.add(ros::WallTime::now().toSec(), msg.total_time, state == PlannerProgress::FAILED);
+}
+void PathPlannerBase::publishLatency(const ros::WallTimerEvent&)
+{
+  PlannerLatency msg;
+  msg.window = latency_window_;
+  double now = ros::WallTime::now().toSec();
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  for (std::map<std::string, LatencyWindow>::iterator it = service_latency_.begin(); it != service_latency_.end(); it++)
+  {
+    latency_histogram_s hist = it->second.window(now);
+    ServiceLatency service;
+    service.job    = it->first;
+    service.count  = hist.count;
+    service.failed = hist.failed;
+    service.p50    = hist.percentile(50.0);
+    service.p90    = hist.percentile(90.0);
+    service.p99    = hist.percentile(99.0);
+    service.p999   = hist.percentile(99.9);
+    service.max    = hist.max;
+    msg.services.push_back(service);
+  }
+  latency_publisher_.publish(msg);
+}
 void PathPlannerBase::getInitialMap()
 {
   unsigned int seed = rg_.UINT();
@@ -736,21 +1371,141 @@ void PathPlannerBase::getInitialMap()
   // myWorld.map.cylinders.push_back(cyl);
   // ROS_WARN("FLIGHT TENT cylinder:: %f %f", cyl.N, cyl.E);
   myWorld_ = myWorld.map;
-  rrt_obj_.newMap(myWorld_);
+  prepareMap(myWorld_);
+  std::lock_guard<std::mutex> distance_lock(distance_mutex_);
   has_map_ = true;
   wp_distances_.clear();
   waypoints_to_hit_.clear();
   cyl_distances_.clear();
+  distance_cylinders_ = rrt_obj_.map_.cylinders;
   for (int i = 0; i < rrt_obj_.map_.wps.size(); i++)
   {
     wp_distances_.push_back(INFINITY);
     waypoints_to_hit_.push_back(rrt_obj_.map_.wps[i]);
   }
-  for (int i = 0; i < rrt_obj_.map_.cylinders.size(); i++)
+  for (int i = 0; i < distance_cylinders_.size(); i++)
     cyl_distances_.push_back(INFINITY);
   min_cyl_dis_ = INFINITY;
   last_primary_wps_ = myWorld_.wps;
 }
+void PathPlannerBase::prepareMap(map_s map)
+{
+  // Loads the compiled map if there is one, otherwise everything is built and the map is compiled once the roadmap is done.
+  map_artifact_pending_ = false;
+  tuning_map_           = map;
+  tuning_               = planner_tuning_s(input_file_);
+  map_tuned_            = false;
+  bool compiled = false;
+  if (map_artifact_dir_.empty() == false)
+    compiled = map_artifact_.open(MapArtifact::fileName(map_artifact_dir_, map, input_file_.clearance), map, input_file_.clearance);
+  rrt_obj_.newMap(map, compiled ? &map_artifact_ : NULL);
+  size_t size;
+  const char* data = map_artifact_.section(MAP_SECTION_ROADMAP, &size);
+  if (data != NULL && roadmap_.load(data, size, map, LegCache::hashMap(map), input_file_.clearance))
+    ROS_INFO("loaded the compiled map");
+  else
+  {
+    roadmap_.build(map, LegCache::hashMap(map), input_file_.clearance);
+    map_artifact_pending_ = map_artifact_dir_.empty() == false;
+    map_artifact_map_     = map;
+  }
+  data = map_artifact_.section(MAP_SECTION_TUNING, &size);
+  if (data != NULL && AutoTuner::load(data, size, &tuning_result_))
+  {
+    tuning_    = tuning_result_.tuning;
+    map_tuned_ = true;
+    ROS_INFO("planning with the settings tuned for this map");
+  }
+  rrt_obj_.setTuning(tuning_);
+  map_artifact_.close();          // everything was copied out of it
+  if (auto_tune_ && map_tuned_ == false)
+    queueJob(makeJob(JOB_TUNE, false, "auto_tune"));
+}
+void PathPlannerBase::compileMap()
+{
+  map_artifact_pending_ = false;
+  std::vector<std::pair<uint32_t, std::vector<char> > > sections;
+  std::vector<char> blob;
+  if (rrt_obj_.vis_graph_.pack(&blob))
+    sections.push_back(std::make_pair((uint32_t) MAP_SECTION_VISIBILITY, blob));
+  blob.clear();
+  if (roadmap_.pack(&blob))
+    sections.push_back(std::make_pair((uint32_t) MAP_SECTION_ROADMAP, blob));
+  blob.clear();
+  if (map_tuned_)
+  {
+    AutoTuner::pack(tuning_result_, &blob);
+    sections.push_back(std::make_pair((uint32_t) MAP_SECTION_TUNING, blob));
+  }
+  mkdir(map_artifact_dir_.c_str(), 0755);
+  std::string file_name = MapArtifact::fileName(map_artifact_dir_, map_artifact_map_, input_file_.clearance);
+  if (MapArtifact::write(file_name, map_artifact_map_, input_file_.clearance, sections))
+    ROS_INFO("compiled the map to %s", file_name.c_str());
+  else
+    ROS_WARN("could not write the compiled map to %s", file_name.c_str());
+}
+bool PathPlannerBase::tune()
+{
+  std::unique_lock<std::mutex> planner_lock(planner_mutex_);
+  if (has_map_ == false)
+  {
+    ROS_WARN("there is no map to tune for yet");
+    return false;
+  }
+  // The problems are planned the way the services plan, with the roadmap of the map once it is built. The other
+  // services can use the planner in the meantime.
+  unsigned long map_hash = LegCache::hashMap(tuning_map_);
+  planner_lock.unlock();
+  while (roadmap_.numNodes() > 0 && roadmap_.ready(map_hash) == false && progress_.cancel == false)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  planner_lock.lock();
+  if (progress_.cancel)
+    return false;
+  if (LegCache::hashMap(tuning_map_) != map_hash)
+  {
+    ROS_WARN("the map changed while tuning waited for its roadmap");
+    return false;
+  }
+  AutoTuner tuner(tuning_map_, input_file_, tune_problems_ > 0 ? tune_problems_ : 1, input_file_.seed);
+  tuner.setRoadmap(roadmap_.numNodes() > 0 ? &roadmap_ : NULL);
+  tuner.setProgress(&progress_);
+  // The tuner only plans on copies and the roadmap, so the planner is left to the other services while it runs.
+  // Between problems it checks that the map it tunes for is still the one being planned on.
+  tuner.setProblemCallback([this, map_hash]()
+  {
+    std::lock_guard<std::mutex> lock(planner_mutex_);
+    return LegCache::hashMap(tuning_map_) == map_hash;
+  });
+  ROS_INFO("tuning the planner for this map for up to %.0f s", tune_time_);
+  planner_lock.unlock();
+  bool tuned = tuner.tune(tune_time_, tune_success_rate_);
+  planner_lock.lock();
+  if (tuned && LegCache::hashMap(tuning_map_) != map_hash)
+  {
+    ROS_WARN("the map changed while it was tuned");
+    tuned = false;
+  }
+  if (tuned == false)
+  {
+    ROS_WARN("the map wasn't tuned, it keeps the settings it had");
+    return false;
+  }
+  tuning_result_ = tuner.result();
+  tuning_        = tuning_result_.tuning;
+  map_tuned_     = true;
+  rrt_obj_.setTuning(tuning_);
+  ROS_INFO("tuned the map over %u settings: segment %.0f m, clearance x%.2f after %.0f%% of the nodes, %i nodes, %i test points "
+           "take %.3f s a problem (%.3f s before), %.0f%% solved", tuning_result_.settings, tuning_.segment_length,
+           tuning_.clearance_shrink, tuning_.clearance_patience*100.0f, tuning_.iters_limit, tuning_.max_test_points,
+           tuning_result_.mean_time, tuning_result_.untuned_time, tuning_result_.success_rate*100.0f);
+  // A map that is compiled already is compiled again with the tuning, one that isn't gets it when it is.
+  if (map_artifact_dir_.empty() == false && map_artifact_pending_ == false)
+  {
+    map_artifact_map_ = tuning_map_;
+    compileMap();
+  }
+  return true;
+}
 void PathPlannerBase::movingObsCallback(const uav_msgs::MovingObstacleCollection &msg)
 {
   NED_s mobs_pos;
@@ -767,10 +1522,15 @@ void PathPlannerBase::movingObsCallback(const uav_msgs::MovingObstacleCollection
 }
 void PathPlannerBase::stateCallback(const rosplane_msgs::State &msg)
 {
-  odometry_.N = msg.position[0];
-  odometry_.E = msg.position[1];
-  odometry_.D = msg.position[2];
-  chi0_       =  msg.chi;
+  vehicle_state_s state;
+  state.position.N = msg.position[0];
+  state.position.E = msg.position[1];
+  state.position.D = msg.position[2];
+  state.chi        = msg.chi;
+  state.Va         = msg.Va;
+  state.stamp      = msg.header.stamp.toSec();
+  vehicle_state_.write(state);
+  NED_s odometry   = state.position;
 
 
   // // Check if the ned conversion is okay
@@ -783,41 +1543,40 @@ void PathPlannerBase::stateCallback(const rosplane_msgs::State &msg)
   // double e_alt = -msg.position[2];
   // NED_s e_ned;
   // gps_converter_.gps2ned(e_lat, e_lon, e_alt, e_ned.N, e_ned.E, e_ned.D);
-  // ROS_INFO("offset = %f", (odometry_ - e_ned).norm());
+  // ROS_INFO("offset = %f", (odometry - e_ned).norm());
 
   if (recieved_state_ == false)
   {
-    recieved_state_ = true;
-    ending_point_ = odometry_;
-    ending_chi_   = msg.chi;
+    recieved_state_ = true;       // ending_point_ is set from it by the first plan
     ROS_INFO("Initial state of the UAV recieved.");
   }
+  std::lock_guard<std::mutex> distance_lock(distance_mutex_);
   if (has_map_)
   {
     for (int i = 0; i < waypoints_to_hit_.size(); i++)
     {
-      float d = (odometry_ - waypoints_to_hit_[i]).norm();
+      float d = (odometry - waypoints_to_hit_[i]).norm();
       if (d < wp_distances_[i])
         wp_distances_[i] = d;
     }
-    for (int i = 0; i < rrt_obj_.map_.cylinders.size(); i++)
+    for (int i = 0; i < distance_cylinders_.size(); i++)
     {
       float d;
       NED_s c;
-      c.N = rrt_obj_.map_.cylinders[i].N;
-      c.E = rrt_obj_.map_.cylinders[i].E;
-      c.D = odometry_.D;
-      d = (odometry_ - c).norm() - rrt_obj_.map_.cylinders[i].R;
-      if (-odometry_.D <= rrt_obj_.map_.cylinders[i].H)
+      c.N = distance_cylinders_[i].N;
+      c.E = distance_cylinders_[i].E;
+      c.D = odometry.D;
+      d = (odometry - c).norm() - distance_cylinders_[i].R;
+      if (-odometry.D <= distance_cylinders_[i].H)
       {
         if (d < 0.0f)
           d = 0.0f;
       }
       else if (d < 0.0f)
-        d = -odometry_.D - rrt_obj_.map_.cylinders[i].H;
+        d = -odometry.D - distance_cylinders_[i].H;
       else
       {
-        float h = -odometry_.D - rrt_obj_.map_.cylinders[i].H;
+        float h = -odometry.D - distance_cylinders_[i].H;
         d = sqrtf(d*d + h*h);
       }
       if (d < cyl_distances_[i])
@@ -829,12 +1588,24 @@ void PathPlannerBase::stateCallback(const rosplane_msgs::State &msg)
 }
 void PathPlannerBase::updateViz(const ros::WallTimerEvent&)
 {
+  {
+    std::unique_lock<std::mutex> planner_lock(planner_mutex_, std::try_to_lock);
+    if (planner_lock.owns_lock() && map_artifact_pending_ &&
+        (roadmap_.ready(LegCache::hashMap(map_artifact_map_)) || roadmap_.numNodes() == 0))
+      compileMap();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (job_running_)
+      publishProgress(running_, PlannerProgress::RUNNING, jobs_.size());
+  }
   if (recieved_state_)
   {
+    NED_s odometry = vehicle_state_.read().position;
     geometry_msgs::Point p;
-    p.x =  odometry_.E;
-    p.y =  odometry_.N;
-    p.z = -odometry_.D;
+    p.x =  odometry.E;
+    p.y =  odometry.N;
+    p.z = -odometry.D;
     plt.odomCallback(p);
     // plt.pingBoundaries(); // this seems to cause segfault
     // plt.pingPath();
@@ -854,6 +1625,9 @@ int main(int argc, char** argv)
   ros::init(argc, argv, "path_planner");
   theseus::PathPlannerBase path_planner_obj;
 
-  ros::spin();
+  int spinner_threads;
+  ros::NodeHandle().param<int>("pp/spinner_threads", spinner_threads, 2);
+  ros::MultiThreadedSpinner spinner(spinner_threads > 0 ? spinner_threads : 0); // 0 is one thread per core
+  ros::spin(spinner);
   return 0;
 } // end main
@@ -0,0 +1,192 @@
+#include <theseus/phase_timer.h>
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+namespace theseus
+{
+phase_hist_s::phase_hist_s()
+{
+  count = 0;
+  total = 0.0;
+  min   = 0.0;
+  max   = 0.0;
+  for (unsigned int k = 0; k < 32; k++)
+    buckets[k] = 0;
+}
+void phase_hist_s::add(double seconds)
+{
+  min    = count == 0 ? seconds : std::min(min, seconds);
+  max    = count == 0 ? seconds : std::max(max, seconds);
+  total += seconds;
+  count++;
+  uint64_t us = seconds*1.0e6;
+  unsigned int k = 0;
+  while (us > 1 && k < 31)
+  {
+    us = us >> 1;
+    k++;
+  }
+  buckets[k]++;
+}
+void phase_hist_s::merge(const phase_hist_s& other)
+{
+  if (other.count == 0)
+    return;
+  min    = count == 0 ? other.min : std::min(min, other.min);
+  max    = count == 0 ? other.max : std::max(max, other.max);
+  total += other.total;
+  count += other.count;
+  for (unsigned int k = 0; k < 32; k++)
+    buckets[k] += other.buckets[k];
+}
+double phase_hist_s::percentile(double p)
+{
+  uint64_t rank = ceil(p/100.0*count);
+  uint64_t seen = 0;
+  for (unsigned int k = 0; k < 32; k++)
+  {
+    seen += buckets[k];
+    if (seen >= rank && seen > 0)
+      return std::min(max, ldexp(2.0, k)*1.0e-6);
+  }
+  return max;
+}
+PhaseTrace::PhaseTrace()
+{
+  max_events_ = 0;
+  dropped_    = 0;
+  t0_         = std::chrono::steady_clock::now();
+}
+void PhaseTrace::start(unsigned int max_events)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+  threads_.clear();
+  threads_.push_back(std::this_thread::get_id()); // the one that plans is thread 0
+  names_.clear();
+  hists_.clear();
+  max_events_ = max_events;
+  dropped_    = 0;
+  t0_         = std::chrono::steady_clock::now();
+}
+void PhaseTrace::add(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+  std::thread::id thread = std::this_thread::get_id();
+  std::lock_guard<std::mutex> lock(mutex_);
+  unsigned int h = 0;
+  while (h < names_.size() && names_[h] != name)
+    h++;
+  if (h == names_.size())
+  {
+    names_.push_back(name);
+    hists_.push_back(phase_hist_s());
+    hists_.back().name = name;
+  }
+  hists_[h].add(std::chrono::duration<double>(end - start).count());
+  if (events_.size() >= max_events_)
+  {
+    dropped_++;
+    return;
+  }
+  unsigned int tid = 0;
+  while (tid < threads_.size() && threads_[tid] != thread)
+    tid++;
+  if (tid == threads_.size())
+    threads_.push_back(thread);
+  phase_event_s event;
+  event.name     = name;
+  event.tid      = tid;
+  event.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start - t0_).count();
+  event.dur_ns   = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  events_.push_back(event);
+}
+bool PhaseTrace::writeChromeTrace(std::string file_name, std::string label)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  FILE* file = fopen(file_name.c_str(), "w");
+  if (file == NULL)
+    return false;
+  // Complete ("X") events in microseconds, the viewer nests the ones of a thread by their times.
+  fprintf(file, "{\"displayTimeUnit\": \"ms\",\n \"otherData\": {\"label\": \"%s\", \"dropped_events\": %lu},\n \"traceEvents\": [\n",
+          label.c_str(), dropped_);
+  for (unsigned int t = 0; t < threads_.size(); t++)
+    fprintf(file, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}},\n", t,
+            t == 0 ? "planner" : "helper");
+  for (unsigned int j = 0; j < events_.size(); j++)
+    fprintf(file, "  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}%s\n", events_[j].name,
+            events_[j].tid, events_[j].start_ns*1.0e-3, events_[j].dur_ns*1.0e-3, j + 1 < events_.size() ? "," : "");
+  fprintf(file, " ]}\n");
+  return fclose(file) == 0;
+}
+std::vector<phase_hist_s> PhaseTrace::histograms()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hists_;
+}
+unsigned long PhaseTrace::dropped()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+PhaseStats::PhaseStats()
+{
+  requests_ = 0;
+}
+void PhaseStats::add(std::vector<phase_hist_s> hists)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  requests_++;
+  for (unsigned int j = 0; j < hists.size(); j++)
+  {
+    unsigned int h = 0;
+    while (h < hists_.size() && hists_[h].name != hists[j].name)
+      h++;
+    if (h == hists_.size())
+    {
+      hists_.push_back(phase_hist_s());
+      hists_.back().name = hists[j].name;
+    }
+    hists_[h].merge(hists[j]);
+  }
+}
+static bool slowerTotal(const phase_hist_s& a, const phase_hist_s& b)
+{
+  return a.total > b.total;
+}
+std::string PhaseStats::report()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<phase_hist_s> hists = hists_;
+  std::sort(hists.begin(), hists.end(), slowerTotal);
+  char line[512];
+  snprintf(line, sizeof(line), "%lu requests\n%-18s %9s %10s %10s %10s %10s %10s %10s\n", requests_, "phase", "count",
+           "total s", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+  std::string out = line;
+  for (unsigned int j = 0; j < hists.size(); j++)
+  {
+    snprintf(line, sizeof(line), "%-18s %9lu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", hists[j].name.c_str(),
+             (unsigned long) hists[j].count, hists[j].total, hists[j].total/hists[j].count*1.0e3,
+             hists[j].percentile(50.0)*1.0e3, hists[j].percentile(90.0)*1.0e3, hists[j].percentile(99.0)*1.0e3,
+             hists[j].max*1.0e3);
+    out += line;
+    // the buckets that have anything in them, as <upper edge in us>:<count>
+    out += "  ";
+    for (unsigned int k = 0; k < 32; k++)
+      if (hists[j].buckets[k] > 0)
+      {
+        snprintf(line, sizeof(line), " <%.0fus:%lu", ldexp(2.0, k), (unsigned long) hists[j].buckets[k]);
+        out += line;
+      }
+    out += "\n";
+  }
+  return out;
+}
+void PhaseStats::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  hists_.clear();
+  requests_ = 0;
+}
+} // end namespace theseus
@@ -0,0 +1,196 @@
+#include <theseus/plan_log.h>
+#include <theseus/log.h>
+
+namespace theseus
+{
+PlanLog::PlanLog()
+{
+  file_ = NULL;
+}
+PlanLog::~PlanLog()
+{
+  close();
+}
+bool PlanLog::open(std::string file_name)
+{
+  close();
+  file_ = fopen(file_name.c_str(), "wb");
+  if (file_ == NULL)
+    return false;
+  plan_log_header_s header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "THSLOG", 6);
+  header.version     = version_;
+  header.config_size = sizeof(planner_config_s);
+  if (fwrite(&header, sizeof(header), 1, file_) != 1 || fflush(file_) != 0)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+void PlanLog::close()
+{
+  if (file_ != NULL)
+    fclose(file_);
+  file_ = NULL;
+}
+bool PlanLog::isOpen()
+{
+  return file_ != NULL;
+}
+bool PlanLog::write(plan_request_s request)
+{
+  std::vector<char> blob;
+  double pos[3] = {request.pos.N, request.pos.E, request.pos.D};
+  uint8_t flags[7] = {request.now, request.direct_hit, request.landing, request.drop_bomb, request.loiter_mission,
+                      request.roadmap_ready, request.animating};
+  appendBlob(&blob, &request.id, 1);
+  appendBlob(&blob, &request.stamp, 1);
+  appendBlob(&blob, &request.seed, 1);
+  appendBlob(&blob, pos, 3);
+  appendBlob(&blob, &request.chi, 1);
+  appendBlob(&blob, flags, 7);
+  appendPoints(&blob, request.map.boundary_pts);
+  uint32_t num_cylinders = request.map.cylinders.size();
+  appendBlob(&blob, &num_cylinders, 1);
+  appendBlob(&blob, request.map.cylinders.empty() ? NULL : &request.map.cylinders[0], num_cylinders);
+  appendPoints(&blob, request.map.wps);
+  appendBlob(&blob, &request.config, 1);
+  return writeRecord(PLAN_RECORD_REQUEST, blob);
+}
+bool PlanLog::write(plan_result_s result)
+{
+  std::vector<char> blob;
+  uint8_t solved = result.solved;
+  appendBlob(&blob, &result.id, 1);
+  appendBlob(&blob, &solved, 1);
+  appendBlob(&blob, &result.solve_time, 1);
+  appendBlob(&blob, &result.nodes, 1);
+  appendPoints(&blob, result.wps);
+  return writeRecord(PLAN_RECORD_RESULT, blob);
+}
+bool PlanLog::writeRecord(uint32_t kind, std::vector<char> payload)
+{
+  if (file_ == NULL)
+    return false;
+  plan_log_record_s record;
+  record.kind = kind;
+  record.size = payload.size();
+  // Flushed every time, the request of a plan that brings the node down is the one that matters most.
+  bool written = fwrite(&record, sizeof(record), 1, file_) == 1 &&
+                 (payload.empty() || fwrite(&payload[0], 1, payload.size(), file_) == payload.size());
+  return fflush(file_) == 0 && written;
+}
+void PlanLog::appendPoints(std::vector<char>* blob, std::vector<NED_s> points)
+{
+  uint32_t n = points.size();
+  appendBlob(blob, &n, 1);
+  for (uint32_t j = 0; j < n; j++)
+  {
+    double p[3] = {points[j].N, points[j].E, points[j].D};
+    appendBlob(blob, p, 3);
+  }
+}
+bool PlanLog::readPoints(blob_reader_s* reader, std::vector<NED_s>* points)
+{
+  uint32_t n;
+  if (reader->read(&n, 1) == false)
+    return false;
+  points->clear();
+  for (uint32_t j = 0; j < n; j++)
+  {
+    double p[3];
+    if (reader->read(p, 3) == false)
+      return false;
+    NED_s point;
+    point.N = p[0];
+    point.E = p[1];
+    point.D = p[2];
+    points->push_back(point);
+  }
+  return true;
+}
+bool PlanLog::read(std::string file_name, std::vector<plan_request_s>* requests, std::vector<plan_result_s>* results)
+{
+  FILE* file = fopen(file_name.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  std::vector<char> data;
+  char buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    data.insert(data.end(), buffer, buffer + n);
+  fclose(file);
+
+  blob_reader_s reader(data.empty() ? NULL : &data[0], data.size());
+  plan_log_header_s header;
+  if (reader.read(&header, 1) == false || memcmp(header.magic, "THSLOG", 6) != 0 || header.version != version_)
+  {
+    THESEUS_ERROR("%s is not a request log of this version", file_name.c_str());
+    return false;
+  }
+  if (header.config_size != sizeof(planner_config_s))
+  {
+    THESEUS_ERROR("%s was written by a build with a different planner_config_s", file_name.c_str());
+    return false;
+  }
+  plan_log_record_s record;
+  while (reader.read(&record, 1))
+  {
+    if ((size_t) (reader.end - reader.p) < record.size)
+    {
+      THESEUS_WARN("%s ends in the middle of a record", file_name.c_str());
+      break;
+    }
+    blob_reader_s payload(reader.p, record.size);
+    reader.p += record.size;
+    bool good = true;
+    if (record.kind == PLAN_RECORD_REQUEST)
+    {
+      plan_request_s request;
+      double pos[3];
+      uint8_t flags[7];
+      uint32_t num_cylinders;
+      good = payload.read(&request.id, 1) && payload.read(&request.stamp, 1) && payload.read(&request.seed, 1) &&
+             payload.read(pos, 3) && payload.read(&request.chi, 1) && payload.read(flags, 7) &&
+             readPoints(&payload, &request.map.boundary_pts) && payload.read(&num_cylinders, 1);
+      if (good)
+      {
+        request.map.cylinders.resize(num_cylinders);
+        good = payload.read(request.map.cylinders.empty() ? NULL : &request.map.cylinders[0], num_cylinders) &&
+               readPoints(&payload, &request.map.wps) && payload.read(&request.config, 1);
+      }
+      if (good)
+      {
+        request.pos.N          = pos[0];
+        request.pos.E          = pos[1];
+        request.pos.D          = pos[2];
+        request.now            = flags[0];
+        request.direct_hit     = flags[1];
+        request.landing        = flags[2];
+        request.drop_bomb      = flags[3];
+        request.loiter_mission = flags[4];
+        request.roadmap_ready  = flags[5];
+        request.animating      = flags[6];
+        requests->push_back(request);
+      }
+    }
+    else if (record.kind == PLAN_RECORD_RESULT)
+    {
+      plan_result_s result;
+      uint8_t solved;
+      good = payload.read(&result.id, 1) && payload.read(&solved, 1) && payload.read(&result.solve_time, 1) &&
+             payload.read(&result.nodes, 1) && readPoints(&payload, &result.wps);
+      if (good)
+      {
+        result.solved = solved;
+        results->push_back(result);
+      }
+    }
+    if (good == false)
+      THESEUS_WARN("skipped a damaged record in %s", file_name.c_str());
+  }
+  return true;
+}
+} // end namespace theseus
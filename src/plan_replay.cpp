@@ -0,0 +1,185 @@
+/*	DESCRIPTION:
+ *	Runs the planning requests of a log recorded by the path planner
+ *	(pp/request_log_dir) through the planner again and compares the
+ *	timing and the paths with what the node got. The requests are planned
+ *	in order on one planner, the way the node planned them, so the reused
+ *	trees and the leg cache are the same. It doesn't need a ROS master.
+ *
+ *	rosrun theseus theseus_plan_replay ~/.ros/theseus_requests_20180614_101500.bin
+ *	rosrun theseus theseus_plan_replay <log> <id> [trace.json]
+ *	(with an id the earlier requests are planned quietly and only that one is timed, to profile it,
+ *	 its phases are written to the Chrome trace file if there is one)
+ *
+ */
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <theseus/log.h>
+#include <theseus/map_s.h>
+#include <theseus/plan_log.h>
+#include <theseus/leg_cache.h>
+#include <theseus/roadmap.h>
+#include <theseus/phase_timer.h>
+#include <theseus/RRT.h>
+
+namespace theseus
+{
+class PlanReplay
+{
+public:
+  PlanReplay(std::vector<plan_request_s> requests, std::vector<plan_result_s> results);
+  unsigned int run(long only, std::string trace_file); // returns the number of requests that planned differently
+private:
+  void prepareRoadmap(plan_request_s request);
+  const plan_result_s* recorded(uint32_t id);
+  std::vector<plan_request_s> requests_;
+  std::vector<plan_result_s> results_;
+  RRT* rrt_;
+  Roadmap roadmap_;
+};
+PlanReplay::PlanReplay(std::vector<plan_request_s> requests, std::vector<plan_result_s> results)
+{
+  requests_ = requests;
+  results_  = results;
+  rrt_      = NULL;
+}
+const plan_result_s* PlanReplay::recorded(uint32_t id)
+{
+  for (unsigned int j = 0; j < results_.size(); j++)
+    if (results_[j].id == id)
+      return &results_[j];
+  return NULL;
+}
+void PlanReplay::prepareRoadmap(plan_request_s request)
+{
+  // The node only had the roadmap if it was finished building, and that depends on timing, so it is in the request.
+  unsigned long map_hash = LegCache::hashMap(request.map);
+  if (request.roadmap_ready == false)
+  {
+    rrt_->setRoadmap(NULL);
+    return;
+  }
+  if (roadmap_.ready(map_hash) == false)
+  {
+    roadmap_.build(request.map, map_hash, request.config.clearance);
+    while (roadmap_.ready(map_hash) == false)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  rrt_->setRoadmap(&roadmap_);
+}
+unsigned int PlanReplay::run(long only, std::string trace_file)
+{
+  if (requests_.empty())
+    return 0;
+  // A log is one run of the node, the configuration is read once at startup, the tuning of each map is applied
+  // before each request.
+  planner_config_s config = requests_[0].config;
+  if (config.console_level >= LOG_LEVEL_DEBUG && config.console_level <= LOG_LEVEL_FATAL)
+    setLogLevel(config.console_level);
+  RRT rrt(requests_[0].map, requests_[0].seed, config);
+  rrt_ = &rrt;
+  rrt.animating_ = false;
+  roadmap_.setNumNodes(config.roadmap_nodes > 0 ? config.roadmap_nodes : 0);
+  roadmap_.setConnectionRadius(config.roadmap_radius);
+  roadmap_.setConfig(config);
+  rrt_progress_s progress;
+  progress.cancel      = false;
+  progress.leg         = 0;
+  progress.num_legs    = 0;
+  progress.nodes       = 0;
+  progress.total_nodes = 0;
+  progress.smooth_us   = 0;
+  rrt.setProgress(&progress);
+
+  unsigned int differences = 0;
+  double recorded_total = 0.0, replayed_total = 0.0;
+  for (unsigned int r = 0; r < requests_.size(); r++)
+  {
+    plan_request_s request = requests_[r];
+    if (only >= 0 && request.id > only)
+      break;
+    rrt.newMap(request.map);
+    rrt.setTuning(planner_tuning_s(request.config));
+    prepareRoadmap(request);
+    rrt.newSeed(request.seed, true);
+    PhaseTrace trace;
+    if (request.id == only && trace_file.empty() == false)
+    {
+      trace.start(1000000);
+      rrt.setTrace(&trace);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool solved = rrt.solveStatic(request.pos, request.chi, request.direct_hit, request.landing, request.drop_bomb,
+                                  request.loiter_mission);
+    double solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    rrt.setTrace(NULL);
+    if (request.id == only && trace_file.empty() == false)
+    {
+      char label[64];
+      snprintf(label, sizeof(label), "replayed planning request %u", request.id);
+      if (trace.writeChromeTrace(trace_file, label))
+        THESEUS_INFO("wrote the phases of request %u to %s", request.id, trace_file.c_str());
+      else
+        THESEUS_ERROR("couldn't write %s", trace_file.c_str());
+    }
+    if (only >= 0 && request.id != only)
+      continue;
+
+    const plan_result_s* result = recorded(request.id);
+    if (result == NULL)
+    {
+      // The node never finished it, this is the one to look at.
+      THESEUS_WARN("request %u: %s in %.3f s, %lu nodes, NOT FINISHED when it was recorded", request.id,
+               solved ? "solved" : "failed", solve_time, (unsigned long) progress.total_nodes);
+      differences++;
+      continue;
+    }
+    float max_miss = 0.0f;
+    bool same = solved == result->solved && rrt.all_wps_.size() == result->wps.size();
+    for (unsigned int j = 0; same && j < result->wps.size(); j++)
+      max_miss = std::max(max_miss, (rrt.all_wps_[j] - result->wps[j]).norm());
+    same = same && max_miss < 1.0e-3f;
+    if (same == false)
+      differences++;
+    recorded_total += result->solve_time;
+    replayed_total += solve_time;
+    THESEUS_INFO("request %u: %s in %.3f s (recorded %.3f s%s), %lu nodes (recorded %lu), %lu waypoints (recorded %lu)%s",
+             request.id, solved ? "solved" : "failed", solve_time, result->solve_time,
+             request.animating ? ", animated" : "", (unsigned long) progress.total_nodes, (unsigned long) result->nodes,
+             rrt.all_wps_.size(), result->wps.size(), same ? "" : " DIFFERENT");
+    if (same == false && solved && result->solved && rrt.all_wps_.size() == result->wps.size())
+      THESEUS_INFO("  the waypoints are up to %.3f m apart", max_miss);
+  }
+  THESEUS_INFO("%u requests planned differently, %.3f s replayed, %.3f s recorded", differences, replayed_total, recorded_total);
+  rrt_ = NULL;
+  return differences;
+}
+} // end namespace theseus
+
+//********************************************************//
+//************************ MAIN **************************//
+//********************************************************//
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    THESEUS_ERROR("usage: theseus_plan_replay <request log> [request id [trace.json]]");
+    return 2;
+  }
+  std::vector<theseus::plan_request_s> requests;
+  std::vector<theseus::plan_result_s> results;
+  if (theseus::PlanLog::read(argv[1], &requests, &results) == false)
+  {
+    THESEUS_ERROR("couldn't read %s", argv[1]);
+    return 2;
+  }
+  THESEUS_INFO("%lu requests, %lu results in %s", requests.size(), results.size(), argv[1]);
+  theseus::PlanReplay replay(requests, results);
+  unsigned int differences = replay.run(argc > 2 ? atol(argv[2]) : -1, argc > 3 ? argv[3] : "");
+  return differences == 0 ? 0 : 1;
+} // end main
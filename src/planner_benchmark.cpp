@@ -0,0 +1,241 @@
+/*	DESCRIPTION:
+ *	Monte-Carlo benchmark of the whole planner. Maps are made by the mapper
+ *	from consecutive seeds and RRT::solveStatic plans through the waypoints
+ *	of each one, spread over a few threads. The success rate and the
+ *	percentiles of the time to the first leg, the total time, the nodes, the
+ *	collision checks and the path length go to a JSON file along with every
+ *	run, so two planner modes (or two commits) can be compared on the same
+ *	maps.
+ *
+ *	rosrun theseus theseus_planner_benchmark _maps:=200 _threads:=4 _output:=planner.json
+ *	(the pp and ppsim parameters have to be loaded, the pp ones pick the planner mode)
+ *
+ */
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <ros/ros.h>
+
+#include <theseus/map_s.h>
+#include <theseus/mapper.h>
+#include <theseus/param_reader.h>
+#include <theseus/ros_log.h>
+#include <theseus/RRT.h>
+
+namespace theseus
+{
+struct planner_run_s
+{
+  int seed;
+  bool solved;
+  double first_leg_time;          // from the start of solveStatic to the first leg being in all_wps_ (s), -1 if it never was
+  double total_time;              // solveStatic (s)
+  unsigned long nodes;            // nodes added to all of the trees
+  unsigned long checks;           // collision checks
+  float path_length;              // along the waypoints from the start (m)
+  unsigned int num_wps;
+};
+class PlannerBenchmark
+{
+public:
+  PlannerBenchmark(int first_seed, int maps, NED_s start, float chi0, bool direct_hit);
+  void run(unsigned int threads);
+  bool write(std::string file);
+private:
+  void planMap(unsigned int m);
+  void worker();
+  void writeStat(std::ofstream& out, std::string name, std::vector<double> values, bool last);
+  std::vector<map_s> maps_;
+  std::vector<planner_run_s> runs_;
+  planner_config_s config_;       // read once, the planners on the other threads don't touch the parameter server
+  std::atomic<unsigned int> next_map_;
+  int first_seed_;
+  NED_s start_;
+  float chi0_;
+  bool direct_hit_;
+  double wall_time_;
+  unsigned int threads_;
+};
+PlannerBenchmark::PlannerBenchmark(int first_seed, int maps, NED_s start, float chi0, bool direct_hit)
+{
+  // The mapper draws from the shared rand() sequence, so the maps are made here before any thread starts.
+  config_ = ParamReader();
+  logToRosconsole(config_.console_level);
+  for (int m = 0; m < maps; m++)
+  {
+    mapper myWorld(first_seed + m, &config_);
+    maps_.push_back(myWorld.map);
+  }
+  runs_.resize(maps_.size());
+  first_seed_ = first_seed;
+  start_      = start;
+  chi0_       = chi0;
+  direct_hit_ = direct_hit;
+  wall_time_  = 0.0;
+  threads_    = 1;
+}
+void PlannerBenchmark::planMap(unsigned int m)
+{
+  int seed = first_seed_ + m;
+  RRT rrt(maps_[m], seed, config_);
+  rrt.newSeed(seed, true);        // the other threads' planners don't change this sequence
+  rrt.animating_ = false;
+  rrt_progress_s progress;
+  progress.cancel      = false;
+  progress.leg         = 0;
+  progress.num_legs    = 0;
+  progress.nodes       = 0;
+  progress.total_nodes = 0;
+  progress.smooth_us   = 0;
+  rrt.setProgress(&progress);
+  std::atomic<unsigned long> checks(0);
+  rrt.col_det_.countChecks(&checks);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double first_leg_time = -1.0;
+  rrt.setLegCallback([&](unsigned int i)
+  {
+    if (first_leg_time < 0.0)
+      first_leg_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  });
+  bool solved = rrt.solveStatic(start_, chi0_, direct_hit_, false, false, false);
+  double total_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  planner_run_s run;
+  run.seed           = seed;
+  run.solved         = solved;
+  run.first_leg_time = first_leg_time;
+  run.total_time     = total_time;
+  run.nodes          = progress.total_nodes;
+  run.checks         = checks;
+  run.num_wps        = rrt.all_wps_.size();
+  run.path_length    = 0.0f;
+  NED_s previous = start_;
+  for (unsigned int j = 0; j < rrt.all_wps_.size(); j++)
+  {
+    run.path_length += (rrt.all_wps_[j] - previous).norm();
+    previous = rrt.all_wps_[j];
+  }
+  runs_[m] = run;
+  ROS_INFO("map %i %s in %.3f s, %lu nodes, %lu checks, %.0f m", seed, solved ? "solved" : "FAILED", total_time,
+           run.nodes, run.checks, run.path_length);
+}
+void PlannerBenchmark::worker()
+{
+  for (unsigned int m = next_map_++; m < maps_.size(); m = next_map_++)
+    planMap(m);
+}
+void PlannerBenchmark::run(unsigned int threads)
+{
+  threads_  = threads < 1 ? 1 : threads;
+  next_map_ = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned int t = 0; t < threads_; t++)
+    pool.push_back(std::thread(&PlannerBenchmark::worker, this));
+  for (unsigned int t = 0; t < pool.size(); t++)
+    pool[t].join();
+  wall_time_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+void PlannerBenchmark::writeStat(std::ofstream& out, std::string name, std::vector<double> values, bool last)
+{
+  // Nearest rank percentiles.
+  out << "    \"" << name << "\": {";
+  std::sort(values.begin(), values.end());
+  if (values.size() > 0)
+  {
+    const double percentiles[] = {50.0, 90.0, 95.0, 99.0};
+    for (unsigned int k = 0; k < 4; k++)
+    {
+      unsigned int rank = ceil(percentiles[k]/100.0*values.size());
+      out << "\"p" << percentiles[k] << "\": " << values[rank > 0 ? rank - 1 : 0] << ", ";
+    }
+    out << "\"min\": " << values.front() << ", \"max\": " << values.back();
+  }
+  out << "}" << (last ? "\n" : ",\n");
+}
+bool PlannerBenchmark::write(std::string file)
+{
+  std::ofstream out(file.c_str());
+  if (!out.is_open())
+    return false;
+  // The percentiles are over the solved maps only, a failed solve stops early and would make the planner look fast.
+  std::vector<double> first_leg, total, nodes, checks, length;
+  unsigned int solved = 0;
+  for (unsigned int m = 0; m < runs_.size(); m++)
+  {
+    if (runs_[m].solved == false)
+      continue;
+    solved++;
+    first_leg.push_back(runs_[m].first_leg_time);
+    total.push_back(runs_[m].total_time);
+    nodes.push_back(runs_[m].nodes);
+    checks.push_back(runs_[m].checks);
+    length.push_back(runs_[m].path_length);
+  }
+
+  out << "{\n  \"benchmark\": \"theseus_planner\",\n";
+  out << "  \"mode\": {\"direct_hit\": " << (direct_hit_ ? "true" : "false") << ", \"visibility_graph\": "
+      << (config_.visibility_graph ? "true" : "false") << ", \"reuse_trees\": " << (config_.reuse_trees ? "true" : "false")
+      << ", \"pipeline_smoothing\": " << (config_.pipeline_smoothing ? "true" : "false") << ", \"speculative_legs\": "
+      << config_.speculative_legs << ", \"segment_length\": " << config_.segment_length << "},\n";
+  out << "  \"maps\": " << runs_.size() << ",\n  \"first_seed\": " << first_seed_ << ",\n";
+  out << "  \"threads\": " << threads_ << ",\n  \"wall_time\": " << wall_time_ << ",\n";
+  out << "  \"success_rate\": " << (runs_.size() > 0 ? solved/((double) runs_.size()) : 0.0) << ",\n";
+  out << "  \"solved\": {\n";
+  writeStat(out, "first_leg_time", first_leg, false);
+  writeStat(out, "total_time", total, false);
+  writeStat(out, "nodes", nodes, false);
+  writeStat(out, "checks", checks, false);
+  writeStat(out, "path_length", length, true);
+  out << "  },\n  \"runs\": [\n";
+  for (unsigned int m = 0; m < runs_.size(); m++)
+  {
+    out << "    {\"seed\": " << runs_[m].seed << ", \"solved\": " << (runs_[m].solved ? "true" : "false")
+        << ", \"first_leg_time\": " << runs_[m].first_leg_time << ", \"total_time\": " << runs_[m].total_time
+        << ", \"nodes\": " << runs_[m].nodes << ", \"checks\": " << runs_[m].checks
+        << ", \"path_length\": " << runs_[m].path_length << ", \"num_wps\": " << runs_[m].num_wps << "}"
+        << (m + 1 < runs_.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return true;
+}
+} // end namespace theseus
+
+//********************************************************//
+//************************ MAIN **************************//
+//********************************************************//
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "theseus_planner_benchmark");
+  ros::NodeHandle nh("~");
+  int maps, first_seed, threads;
+  bool direct_hit;
+  float N, E, D, chi0;
+  std::string output;
+  nh.param<int>("maps", maps, 100);
+  nh.param<int>("first_seed", first_seed, 1);
+  nh.param<int>("threads", threads, std::thread::hardware_concurrency());
+  nh.param<bool>("direct_hit", direct_hit, true);
+  nh.param<float>("N", N, 0.0);
+  nh.param<float>("E", E, 0.0);
+  nh.param<float>("D", D, -50.0);
+  nh.param<float>("chi0", chi0, 0.0);
+  nh.param<std::string>("output", output, "theseus_planner_benchmark.json");
+
+  theseus::NED_s start(N, E, D);
+  theseus::PlannerBenchmark bench(first_seed, maps > 0 ? maps : 1, start, chi0*M_PI/180.0f, direct_hit);
+  bench.run(threads > 0 ? threads : 1);
+  if (bench.write(output) == false)
+  {
+    ROS_ERROR("couldn't write %s", output.c_str());
+    return 1;
+  }
+  ROS_INFO("results written to %s", output.c_str());
+  return 0;
+} // end main
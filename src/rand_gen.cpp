@@ -11,16 +11,32 @@ RandGen::RandGen(int seed_in)	// Seed the Random Generator for reproducibility
 {
 	seed = seed_in;
   srand(seed_in);
+  own_stream_ = false;
+  state_      = seed_in;
+  draws_      = 0;
+}
+RandGen::RandGen(int seed_in, bool own_stream)
+{
+	seed        = seed_in;
+  own_stream_ = own_stream;
+  state_      = seed_in;
+  draws_      = 0;
+  if (own_stream_ == false)
+    srand(seed_in);
 }
 RandGen::RandGen()            // This empty function is needed so that RandGen can be a member of a class.
 {
+  seed        = 0;
+  own_stream_ = false;
+  state_      = 0;
+  draws_      = 0;
 }
 RandGen::~RandGen()           // Deconstructor
 {
 }
 double RandGen::randLin()     // This public function returns a random number from 0 to 1, uniform distribution
 {
-	return ((double) rand()/(RAND_MAX));
+	return ((double) next()/(RAND_MAX));
 }
 double RandGen::norm_rnd(double mu, double sigma)
 {
@@ -33,14 +49,41 @@ std::vector<unsigned int> RandGen::UINTv(unsigned int len)
 	std::vector<unsigned int> uints;			// This function returns a vector of unsigned ints
 	for (unsigned int i = 0; i < len; i++)
 	{
-    double num = ((double) rand()/(RAND_MAX));
+    double num = ((double) next()/(RAND_MAX));
 		uints.push_back(num);
 	}
 	return uints;
 }
 unsigned int RandGen::UINT()
 {
-	double uints = rand();
+	double uints = next();
 	return uints;
 }
+bool RandGen::ownStream()
+{
+  return own_stream_;
+}
+rand_mark_s RandGen::mark()
+{
+  rand_mark_s m;
+  m.state = state_;
+  m.draws = draws_;
+  return m;
+}
+bool RandGen::rewind(rand_mark_s m)
+{
+  // The shared sequence can't be put back, other threads draw from it too.
+  if (own_stream_ == false)
+    return false;
+  state_ = m.state;
+  draws_ = m.draws;
+  return true;
+}
+int RandGen::next()
+{
+  draws_++;
+  if (own_stream_)
+    return rand_r(&state_);
+  return rand();
+}
 }
@@ -0,0 +1,349 @@
+#include <theseus/roadmap.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace theseus
+{
+Roadmap::Roadmap()
+{
+  cancel_    = false;
+  ready_     = false;
+  map_hash_  = 0;
+  D_         = 0.0f;
+  num_nodes_ = 0;
+  radius_    = 400.0f;
+}
+Roadmap::~Roadmap()
+{
+  stop();
+}
+void Roadmap::setNumNodes(unsigned int num_nodes)
+{
+  num_nodes_ = num_nodes;
+}
+void Roadmap::setConnectionRadius(float radius)
+{
+  radius_ = radius;
+}
+void Roadmap::setConfig(planner_config_s config)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  config_ = config;
+}
+void Roadmap::build(map_s map, unsigned long map_hash, float clearance)
+{
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ready_ && map_hash_ == map_hash)
+      return;                                     // already have this one
+    ready_ = false;
+  }
+  if (num_nodes_ == 0 || map.boundary_pts.size() < 3)
+    return;
+  cancel_       = false;
+  build_thread_ = std::thread(&Roadmap::buildThread, this, map, map_hash, clearance);
+}
+unsigned int Roadmap::numNodes()
+{
+  return num_nodes_;
+}
+bool Roadmap::pack(std::vector<char>* blob)
+{
+  // num_nodes_, radius_, D_, number of nodes, N[], E[], edge offsets[], edge to[], edge length[]
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ready_ == false)
+    return false;
+  uint32_t n = nodes_.size();
+  std::vector<double> N(n), E(n);
+  std::vector<uint32_t> offsets(n + 1, 0);
+  std::vector<uint32_t> to;
+  std::vector<float> length;
+  for (uint32_t j = 0; j < n; j++)
+  {
+    N[j] = nodes_[j].N;
+    E[j] = nodes_[j].E;
+    for (unsigned int k = 0; k < edges_[j].size(); k++)
+    {
+      to.push_back(edges_[j][k].to);
+      length.push_back(edges_[j][k].length);
+    }
+    offsets[j + 1] = to.size();
+  }
+  uint32_t num_nodes = num_nodes_;
+  appendBlob(blob, &num_nodes, 1);
+  appendBlob(blob, &radius_, 1);
+  appendBlob(blob, &D_, 1);
+  appendBlob(blob, &n, 1);
+  appendBlob(blob, N.empty() ? NULL : &N[0], n);
+  appendBlob(blob, E.empty() ? NULL : &E[0], n);
+  appendBlob(blob, &offsets[0], n + 1);
+  appendBlob(blob, to.empty() ? NULL : &to[0], to.size());
+  appendBlob(blob, length.empty() ? NULL : &length[0], length.size());
+  return true;
+}
+bool Roadmap::load(const char* data, size_t size, map_s map, unsigned long map_hash, float clearance)
+{
+  blob_reader_s reader(data, size);
+  uint32_t num_nodes, n;
+  float radius, D;
+  if (reader.read(&num_nodes, 1) == false || reader.read(&radius, 1) == false || reader.read(&D, 1) == false || reader.read(&n, 1) == false)
+    return false;
+  if (num_nodes != num_nodes_ || radius != radius_ || num_nodes_ == 0)
+    return false;
+  std::vector<double> N(n), E(n);
+  std::vector<uint32_t> offsets(n + 1);
+  if (reader.read(N.empty() ? NULL : &N[0], n) == false || reader.read(E.empty() ? NULL : &E[0], n) == false || reader.read(&offsets[0], n + 1) == false)
+    return false;
+  std::vector<uint32_t> to(offsets[n]);
+  std::vector<float> length(offsets[n]);
+  if (reader.read(to.empty() ? NULL : &to[0], to.size()) == false || reader.read(length.empty() ? NULL : &length[0], length.size()) == false)
+    return false;
+  std::vector<NED_s> nodes;
+  std::vector<std::vector<roadmap_edge_s> > edges(n);
+  for (uint32_t j = 0; j < n; j++)
+  {
+    NED_s node;                                 // set one by one, the float constructor would round N and E
+    node.N = N[j];
+    node.E = E[j];
+    node.D = D;
+    nodes.push_back(node);
+    if (offsets[j] > offsets[j + 1] || offsets[j + 1] > to.size())
+      return false;
+    for (uint32_t k = offsets[j]; k < offsets[j + 1]; k++)
+    {
+      if (to[k] >= n)
+        return false;
+      roadmap_edge_s edge;
+      edge.to     = to[k];
+      edge.length = length[k];
+      edges[j].push_back(edge);
+    }
+  }
+  stop();
+  CollisionDetection col_det(config_);
+  col_det.newMap(map);
+  col_det.taking_off_  = false;
+  col_det.landing_now_ = false;
+  if (D != -(col_det.minFlyHeight_ + clearance + 1.0f))
+    return false;                                 // it was checked with another clearance, buildThread puts it in D
+  std::lock_guard<std::mutex> lock(mutex_);
+  col_det_  = col_det;
+  D_        = D;
+  nodes_.swap(nodes);
+  edges_.swap(edges);
+  map_hash_ = map_hash;
+  ready_    = true;
+  return true;
+}
+bool Roadmap::ready(unsigned long map_hash)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ready_ && map_hash_ == map_hash;
+}
+void Roadmap::stop()
+{
+  cancel_ = true;
+  if (build_thread_.joinable())
+    build_thread_.join();
+}
+void Roadmap::buildThread(map_s map, unsigned long map_hash, float clearance)
+{
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  CollisionDetection col_det(config_);
+  col_det.newMap(map);
+  col_det.taking_off_  = false;
+  col_det.landing_now_ = false;
+  // Cylinders are infinitely tall to the roadmap, so check everything at the lowest altitude that is allowed.
+  float D = -(col_det.minFlyHeight_ + clearance + 1.0f);
+
+  std::vector<NED_s> nodes;
+  unsigned int k = 0;
+  unsigned int max_samples = 20*num_nodes_;
+  while (nodes.size() < num_nodes_ && k < max_samples)
+  {
+    if (cancel_)
+      return;
+    NED_s p = halton(++k);
+    p.N = p.N*(col_det.maxNorth_ - col_det.minNorth_) + col_det.minNorth_;
+    p.E = p.E*(col_det.maxEast_  - col_det.minEast_)  + col_det.minEast_;
+    p.D = D;
+    if (col_det.checkPoint(p, clearance))
+      nodes.push_back(p);
+  }
+  std::vector<std::vector<roadmap_edge_s> > edges(nodes.size());
+  unsigned long num_edges = 0;
+  for (unsigned int i = 0; i < nodes.size(); i++)
+  {
+    if (cancel_)
+      return;
+    for (unsigned int j = i + 1; j < nodes.size(); j++)
+    {
+      float length = (nodes[j] - nodes[i]).norm();
+      if (length > radius_ || col_det.checkLine(nodes[i], nodes[j], clearance) == false)
+        continue;
+      roadmap_edge_s edge;
+      edge.length = length;
+      edge.to     = j;
+      edges[i].push_back(edge);
+      edge.to     = i;
+      edges[j].push_back(edge);
+      num_edges++;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  col_det_  = col_det;
+  D_        = D;
+  nodes_.swap(nodes);
+  edges_.swap(edges);
+  map_hash_ = map_hash;
+  ready_    = true;
+  THESEUS_INFO("built the roadmap, %lu nodes, %lu edges, %f seconds", nodes_.size(), num_edges,
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+}
+bool Roadmap::query(NED_s ps, NED_s pe, float clearance, unsigned long map_hash, std::vector<NED_s>* path)
+{
+  // Returns the points between ps and pe (neither one is included).
+  // The lock is waited for, a query that gave up while another planner held it couldn't be replayed.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ready_ == false || map_hash_ != map_hash)
+    return false;
+  NED_s ps2(ps.N, ps.E, D_);
+  NED_s pe2(pe.N, pe.E, D_);
+  std::vector<unsigned int> start_connections = connect(ps2, clearance, 10);
+  std::vector<unsigned int> end_connections   = connect(pe2, clearance, 10);
+  if (start_connections.empty() || end_connections.empty())
+    return false;
+
+  // The start and goal are added as two temporary nodes at the end of the graph.
+  unsigned int start = nodes_.size();
+  unsigned int goal  = nodes_.size() + 1;
+  nodes_.push_back(ps2);
+  nodes_.push_back(pe2);
+  edges_.push_back(std::vector<roadmap_edge_s>());
+  edges_.push_back(std::vector<roadmap_edge_s>());
+  roadmap_edge_s edge;
+  for (unsigned int j = 0; j < start_connections.size(); j++)
+  {
+    edge.to     = start_connections[j];
+    edge.length = (nodes_[edge.to] - ps2).norm();
+    edges_[start].push_back(edge);
+  }
+  for (unsigned int j = 0; j < end_connections.size(); j++)
+  {
+    edge.to     = goal;
+    edge.length = (nodes_[end_connections[j]] - pe2).norm();
+    edges_[end_connections[j]].push_back(edge);
+  }
+  std::vector<unsigned int> node_path;
+  bool found = search(start, goal, &node_path);
+  for (unsigned int j = 0; j < end_connections.size(); j++)
+    edges_[end_connections[j]].pop_back();
+  nodes_.resize(start);
+  edges_.resize(start);
+  if (found == false)
+    return false;
+
+  // Give the path altitudes that change linearly from ps to pe, then pull out any points that can be skipped.
+  std::vector<NED_s> points;
+  points.push_back(ps2);
+  for (unsigned int j = 0; j < node_path.size(); j++)
+    points.push_back(nodes_[node_path[j]]);
+  points.push_back(pe2);
+  float total_length = 0.0f;
+  for (unsigned int j = 1; j < points.size(); j++)
+    total_length += (points[j] - points[j - 1]).norm();
+  float length = 0.0f;
+  points[0].D = ps.D;
+  for (unsigned int j = 1; j < points.size(); j++)
+  {
+    NED_s last(points[j - 1].N, points[j - 1].E, D_);
+    length += (points[j] - last).norm();
+    points[j].D = ps.D + (pe.D - ps.D)*length/total_length;
+  }
+  path->clear();
+  unsigned int from = 0;
+  while (from < points.size() - 1)
+  {
+    unsigned int to = points.size() - 1;
+    while (to > from + 1 && col_det_.checkLine(points[from], points[to], clearance) == false)
+      to--;
+    if (to != points.size() - 1)
+      path->push_back(points[to]);
+    from = to;
+  }
+  return true;
+}
+std::vector<unsigned int> Roadmap::connect(NED_s p, float clearance, unsigned int max_connections)
+{
+  // Connects p to the closest roadmap nodes that it can see.
+  std::vector<std::pair<float, unsigned int> > by_distance;
+  for (unsigned int j = 0; j < nodes_.size(); j++)
+  {
+    float d = (nodes_[j] - p).norm();
+    if (d < radius_)
+      by_distance.push_back(std::make_pair(d, j));
+  }
+  std::sort(by_distance.begin(), by_distance.end());
+  std::vector<unsigned int> connections;
+  for (unsigned int j = 0; j < by_distance.size() && connections.size() < max_connections; j++)
+    if (col_det_.checkLine(p, nodes_[by_distance[j].second], clearance))
+      connections.push_back(by_distance[j].second);
+  return connections;
+}
+bool Roadmap::search(unsigned int start, unsigned int goal, std::vector<unsigned int>* node_path)
+{
+  // A* with the straight line distance to the goal as the heuristic. node_path is filled without start and goal.
+  std::vector<float> cost(nodes_.size(), INFINITY);
+  std::vector<int> parent(nodes_.size(), -1);
+  std::vector<bool> closed(nodes_.size(), false);
+  std::priority_queue<std::pair<float, unsigned int>, std::vector<std::pair<float, unsigned int> >, std::greater<std::pair<float, unsigned int> > > open;
+  cost[start] = 0.0f;
+  open.push(std::make_pair((nodes_[goal] - nodes_[start]).norm(), start));
+  while (open.empty() == false)
+  {
+    unsigned int current = open.top().second;
+    open.pop();
+    if (closed[current])
+      continue;
+    closed[current] = true;
+    if (current == goal)
+    {
+      node_path->clear();
+      for (int j = parent[goal]; j >= 0 && (unsigned int) j != start; j = parent[j])
+        node_path->insert(node_path->begin(), j);
+      return true;
+    }
+    for (unsigned int j = 0; j < edges_[current].size(); j++)
+    {
+      unsigned int next = edges_[current][j].to;
+      float new_cost    = cost[current] + edges_[current][j].length;
+      if (closed[next] || new_cost >= cost[next])
+        continue;
+      cost[next]   = new_cost;
+      parent[next] = current;
+      open.push(std::make_pair(new_cost + (nodes_[goal] - nodes_[next]).norm(), next));
+    }
+  }
+  return false;
+}
+NED_s Roadmap::halton(unsigned int k)
+{
+  // Bases 2 and 3, spreads the nodes more evenly than rand() and doesn't touch its state.
+  NED_s p;
+  float f = 1.0f;
+  for (unsigned int i = k; i > 0; i /= 2)
+  {
+    f   = f/2.0f;
+    p.N = p.N + f*(i % 2);
+  }
+  f = 1.0f;
+  for (unsigned int i = k; i > 0; i /= 3)
+  {
+    f   = f/3.0f;
+    p.E = p.E + f*(i % 3);
+  }
+  return p;
+}
+} // end namespace theseus
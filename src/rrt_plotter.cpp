@@ -7,6 +7,12 @@ rrtPlotter::rrtPlotter() :
 {
   marker_pub_                  = nh_.advertise<visualization_msgs::Marker>("visualization_marker", 10);
   ground_pub_                  = nh_.advertise<visualization_msgs::Marker>("groundstation/visualization_marker", 10);
+  scene_pub_                   = nh_.advertise<visualization_msgs::MarkerArray>("visualization_marker_scene", 1, true);
+  ground_scene_pub_            = nh_.advertise<visualization_msgs::MarkerArray>("groundstation/visualization_marker_scene", 1, true);
+  trail_pub_                   = nh_.advertise<visualization_msgs::Marker>("visualization_marker_trail", 1, true);
+  array_pub_                   = nh_.advertise<visualization_msgs::MarkerArray>("visualization_marker_array", 10);
+  ground_array_pub_            = nh_.advertise<visualization_msgs::MarkerArray>("groundstation/visualization_marker_array", 10);
+  num_mobs_                    = 0;
   path_id_                     = 0;
   pWPS_id_                     = 0;
   odom_mkr_.header.frame_id    = "/local_ENU";
@@ -24,6 +30,13 @@ rrtPlotter::rrtPlotter() :
   odom_mkr_.lifetime           = ros::Duration();
   odom_mkr_.scale.x            = 5.0; // point width
   odom_mkr_.scale.y            = 5.0; // point width
+  int trail_capacity, trail_tail;
+  float trail_distance, trail_period;
+  nh_.param<int>("pp/trail_capacity", trail_capacity, 5000);
+  nh_.param<float>("pp/trail_distance", trail_distance, 5.0);
+  nh_.param<float>("pp/trail_period", trail_period, 2.0);
+  nh_.param<int>("pp/trail_tail", trail_tail, 100);
+  odom_trail_.setup(odom_mkr_, trail_capacity, trail_distance, trail_period, trail_tail);
   increase_path_id_            = true;
 
   planned_path_mkr_.header.frame_id = "/local_ENU";
@@ -58,6 +71,26 @@ rrtPlotter::rrtPlotter() :
   mobs_mkr_.lifetime           = ros::Duration();
   mobs_mkr_.id                 = 0;
 
+  tree_mkr_.header.frame_id    = "/local_ENU";
+  tree_mkr_.ns                 = "tree";
+  tree_mkr_.type               = visualization_msgs::Marker::LINE_LIST;
+  tree_mkr_.action             = visualization_msgs::Marker::ADD;
+  tree_mkr_.pose.orientation.w = 1.0;
+  tree_mkr_.color.r            = clr.gray.N;
+  tree_mkr_.color.g            = clr.gray.E;
+  tree_mkr_.color.b            = clr.gray.D;
+  tree_mkr_.color.a            = 1.0;
+  tree_mkr_.scale.x            = 2.9; // line width
+  tree_mkr_.lifetime           = ros::Duration();
+  tree_chunk_                  = 0;
+  float tree_frame_rate;
+  nh_.param<float>("pp/tree_frame_rate", tree_frame_rate, 10.0);
+  tree_period_                 = tree_frame_rate > 0.0f ? 1.0/tree_frame_rate : 0.0;
+  last_tree_chunk_             = ros::WallTime::now();
+  nh_.param<float>("pp/arc_tolerance", arc_tolerance_, 0.25);
+  nh_.param<float>("pp/view_scale", view_scale_, 1.0);
+  path_version_                = 0;
+
   display_on_judges_map_ = false;
 }
 rrtPlotter::~rrtPlotter()
@@ -66,6 +99,7 @@ rrtPlotter::~rrtPlotter()
 }
 void rrtPlotter::displayMap(map_s map)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   ROS_INFO("Displaying Map");
   visualization_msgs::Marker obs_mkr, bds_mkr, run_mkr, run_mkr2;
 
@@ -108,6 +142,7 @@ void rrtPlotter::displayMap(map_s map)
   run_mkr2.color.a            = 1.0;
   obs_mkr.lifetime = bds_mkr.lifetime  = run_mkr.lifetime = run_mkr2.lifetime = ros::Duration();
 
+  std::vector<visualization_msgs::Marker> layer, ground_layer;
   int id = 0;
   obs_mkr.header.stamp = ros::Time::now();
   ROS_INFO("Number of Cylinders: %lu", map.cylinders.size());
@@ -121,23 +156,10 @@ void rrtPlotter::displayMap(map_s map)
     obs_mkr.scale.x = map.cylinders[i].R*2.0; // Diameter in x direction
     obs_mkr.scale.y = map.cylinders[i].R*2.0; // Diameter in y direction
     obs_mkr.scale.z = map.cylinders[i].H;     // Height
-    // Publish the obs_mkr
-    while (marker_pub_.getNumSubscribers() < 1)
-    {
-      if (!ros::ok())
-        return;
-      ROS_WARN_ONCE("Please create a subscriber to the marker");
-      sleep(1);
-    }
-    marker_pub_.publish(obs_mkr);
-    sleep(0.05); // apparently needs a small delay otherwise rviz can't keep up?
-    ground_pub_.publish(obs_mkr);
-    sleep(0.05); // apparently needs a small delay otherwise rviz can't keep up?
+    layer.push_back(obs_mkr);
+    ground_layer.push_back(obs_mkr);
   }
 
-  // primary waypoints
-  displayPrimaryWaypoints(map.wps);
-
   // Boundaries
   bds_mkr.header.stamp = ros::Time::now();
   bds_mkr.id           =  0;
@@ -160,9 +182,8 @@ void rrtPlotter::displayMap(map_s map)
   p0.x = map.boundary_pts[1].E;
   p0.z = 0.0;
   bds_mkr.points.push_back(p0);
-  marker_pub_.publish(bds_mkr);
-  sleep(0.05);
-  ground_pub_.publish(bds_mkr);
+  layer.push_back(bds_mkr);
+  ground_layer.push_back(bds_mkr);
 
   // Runway
   run_mkr.header.stamp = run_mkr2.header.stamp = ros::Time::now();
@@ -181,10 +202,8 @@ void rrtPlotter::displayMap(map_s map)
   p.z = 5.986742;
   NED_s r2(p.y, p.x, -p.z);
   run_mkr.points.push_back(p);
-  marker_pub_.publish(run_mkr);
-  // ground_pub_.publish(run_mkr);
+  layer.push_back(run_mkr);
   run_mkr.id++;
-  sleep(0.05);
   // run_mkr.points.clear(); // this is bad. don't clear this
   p.y = -246.621673;
   p.x = -552.535779;
@@ -196,10 +215,8 @@ void rrtPlotter::displayMap(map_s map)
   p.z = 5.938186;
   NED_s r4(p.y, p.x, -p.z);
   run_mkr2.points.push_back(p);
-  marker_pub_.publish(run_mkr2);
-  // ground_pub_.publish(run_mkr2);
+  layer.push_back(run_mkr2);
   run_mkr2.id++;
-  sleep(0.05);
   // run_mkr.points.clear();
 
   // elberta
@@ -218,6 +235,11 @@ void rrtPlotter::displayMap(map_s map)
   // run_mkr.id++;
   // sleep(0.05);
   // run_mkr.points.clear();
+  putInScene(&scene_, layer);
+  putInScene(&ground_scene_, ground_layer);
+
+  // primary waypoints, the scene is published with them
+  displayPrimaryWaypoints(map.wps);
   ROS_DEBUG("finished displayMap");
 
 
@@ -227,6 +249,7 @@ void rrtPlotter::displayMap(map_s map)
 }
 void rrtPlotter::displayPrimaryWaypoints(std::vector<NED_s> wps)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   ROS_INFO("Displaying Waypoints");
   visualization_msgs::Marker pWPS_mkr;
 
@@ -264,22 +287,36 @@ void rrtPlotter::displayPrimaryWaypoints(std::vector<NED_s> wps)
     p.z = -wps[i].D;
     pWPS_mkr.points.push_back(p);
   }
-  marker_pub_.publish(pWPS_mkr);
-  ground_pub_.publish(pWPS_mkr);
-  sleep(0.05);
+  std::vector<visualization_msgs::Marker> layer(1, pWPS_mkr);
+  putInScene(&scene_, layer);
+  putInScene(&ground_scene_, layer);
+  publishScene();
   ROS_DEBUG("finished displaying waypoints");
 }
 void rrtPlotter::odomCallback(geometry_msgs::Point p)
 {
-  odom_mkr_.header.stamp = ros::Time::now();
-  odom_mkr_.points.push_back(p);
-  marker_pub_.publish(odom_mkr_);
-  // ground_pub_.publish(odom_mkr_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  ros::Time now = ros::Time::now();
+  trail_update_e update = odom_trail_.add(p, now.toSec());
+  if (update == TRAIL_HISTORY)
+  {
+    visualization_msgs::Marker history = odom_trail_.history();
+    history.header.stamp = now;
+    trail_pub_.publish(history);
+  }
+  if (update != TRAIL_NONE)
+  {
+    visualization_msgs::Marker tail = odom_trail_.tail();
+    tail.header.stamp = now;
+    marker_pub_.publish(tail);
+  }
 }
 void rrtPlotter::mobsCallback(std::vector<NED_s> mobs_in, std::vector<float> radius)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  visualization_msgs::MarkerArray mobs_array;
   mobs_mkr_.header.stamp = ros::Time::now();
-
+  mobs_mkr_.action       = visualization_msgs::Marker::ADD;
   for (int i = 0; i < mobs_in.size(); i++)
   {
     mobs_mkr_.scale.x         = radius[i]*2.0f;
@@ -289,20 +326,48 @@ void rrtPlotter::mobsCallback(std::vector<NED_s> mobs_in, std::vector<float> rad
     mobs_mkr_.pose.position.y = mobs_in[i].N;
     mobs_mkr_.pose.position.z = -mobs_in[i].D;
     mobs_mkr_.id = i;
-    marker_pub_.publish(mobs_mkr_);
-    // ground_pub_.publish(mobs_mkr_);
-
-    ros::Duration(0.01).sleep();
+    mobs_array.markers.push_back(mobs_mkr_);
+  }
+  mobs_mkr_.action = visualization_msgs::Marker::DELETE;
+  for (int i = mobs_in.size(); i < num_mobs_; i++)
+  {
+    mobs_mkr_.id = i;
+    mobs_array.markers.push_back(mobs_mkr_);
   }
+  num_mobs_ = mobs_in.size();
+  array_pub_.publish(mobs_array);
 }
 void rrtPlotter::pingBoundaries()
 {
-  marker_pub_.publish(bds_mkr_);
-  ground_pub_.publish(bds_mkr_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  publishScene();
+}
+void rrtPlotter::publishScene()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  // Clearing first takes anything that is no longer in the scene off the display.
+  visualization_msgs::MarkerArray msg, ground_msg;
+  visualization_msgs::Marker clear_mkr;
+  clear_mkr.action = visualization_msgs::Marker::DELETEALL;
+  msg.markers.push_back(clear_mkr);
+  msg.markers.insert(msg.markers.end(), scene_.markers.begin(), scene_.markers.end());
+  ground_msg.markers.push_back(clear_mkr);
+  ground_msg.markers.insert(ground_msg.markers.end(), ground_scene_.markers.begin(), ground_scene_.markers.end());
+  scene_pub_.publish(msg);
+  ground_scene_pub_.publish(ground_msg);
+}
+void rrtPlotter::putInScene(visualization_msgs::MarkerArray* scene, std::vector<visualization_msgs::Marker> layer)
+{
+  // Every marker in a namespace of the layer is replaced by the layer.
+  for (unsigned int i = 0; i < layer.size(); i++)
+    for (unsigned int j = scene->markers.size(); j > 0; j--)
+      if (scene->markers[j - 1].ns == layer[i].ns)
+        scene->markers.erase(scene->markers.begin() + j - 1);
+  scene->markers.insert(scene->markers.end(), layer.begin(), layer.end());
 }
 void rrtPlotter::addFinalPath(NED_s ps, std::vector<NED_s> stuff_in)
 {
-  planned_path_mkr_.points.clear();
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<NED_s> path;
   path.push_back(ps);
   ROS_DEBUG("PATH N: %f E: %f D: %f", ps.N, ps.E, ps.D);
@@ -311,57 +376,35 @@ void rrtPlotter::addFinalPath(NED_s ps, std::vector<NED_s> stuff_in)
     path.push_back(stuff_in[it]);
     ROS_DEBUG("PATH N: %f E: %f D: %f", stuff_in[it].N, stuff_in[it].E, stuff_in[it].D);
   }
-  std::vector<NED_s> vis_path;
-  vis_path.push_back(path[0]);
-  for (int i = 1; i < path.size() - 1; i++)
-  {
-    fillet_s fil;
-    fil.calculate(path[i - 1], path[i], path[i + 1], input_file_.turn_radius);
-    vis_path.push_back(fil.z1);
-
-    std::vector<std::vector<float> > NcEc;
-    if (fil.lambda == -1)
-    {
-      NcEc = arc(fil.c.N, fil.c.E, input_file_.turn_radius, (fil.z2 - fil.c).getChi(), (fil.z1 - fil.c).getChi());
-      // need to flip the vectors
-      std::reverse(NcEc[0].begin(),NcEc[0].end());
-      std::reverse(NcEc[1].begin(),NcEc[1].end());
-    }
-    if (fil.lambda ==  1)
-    {
-      NcEc = arc(fil.c.N, fil.c.E, input_file_.turn_radius, (fil.z1 - fil.c).getChi(), (fil.z2 - fil.c).getChi());
-    }
-    std::vector<float> Nc = NcEc[0];
-    std::vector<float> Ec = NcEc[1];
-    NED_s pos;
-    for (int j = 0; j < Nc.size(); j++)
-    {
-      pos.N = Nc[j];
-      pos.E = Ec[j];
-      pos.D = fil.c.D;
-      vis_path.push_back(pos);
-    }
-    vis_path.push_back(fil.z2);
-  }
-  vis_path.push_back(path[path.size() - 1]);
-
-  for (int i = 0; i < vis_path.size(); i++)
-  {
-    geometry_msgs::Point p;
-    p.x =  vis_path[i].E;
-    p.y =  vis_path[i].N;
-    p.z = -vis_path[i].D;
-    planned_path_mkr_.points.push_back(p);
-  }
+  tessellate(++path_version_, path, &planned_path_mkr_.points);
+  tessellations_.front().id = planned_path_mkr_.id;
   marker_pub_.publish(planned_path_mkr_);
   ground_pub_.publish(planned_path_mkr_);
 }
+unsigned int rrtPlotter::pathVersion()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return path_version_;
+}
+bool rrtPlotter::redrawPath(unsigned int version, NED_s color, float width)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  for (unsigned int k = 0; k < tessellations_.size(); k++)
+    if (tessellations_[k].version == version)
+    {
+      publishPath(version, std::vector<NED_s>(), color, width);
+      return true;
+    }
+  return false;
+}
 void rrtPlotter::pingPath()
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   marker_pub_.publish(planned_path_mkr_);
 }
 void rrtPlotter::displayPath(NED_s ps, std::vector<NED_s> path, NED_s color, float width)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<NED_s> temp_neds;
   temp_neds.push_back(ps);
   ROS_DEBUG("PATH N: %f E: %f D: %f", ps.N, ps.E, ps.D);
@@ -374,6 +417,7 @@ void rrtPlotter::displayPath(NED_s ps, std::vector<NED_s> path, NED_s color, flo
 }
 void rrtPlotter::displayPath(NED_s ps, std::vector<node*> path, NED_s color, float width)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<NED_s> temp_neds;
   temp_neds.push_back(ps);
   ROS_DEBUG("PATH N: %f E: %f D: %f", ps.N, ps.E, ps.D);
@@ -386,6 +430,7 @@ void rrtPlotter::displayPath(NED_s ps, std::vector<node*> path, NED_s color, flo
 }
 void rrtPlotter::displayPath(std::vector<node*> path, NED_s color, float width)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<NED_s> temp_neds;
   for (int it = 0; it < path.size(); it++)
   {
@@ -396,6 +441,7 @@ void rrtPlotter::displayPath(std::vector<node*> path, NED_s color, float width)
 }
 void rrtPlotter::displayBoundaries(map_s map)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   bds_mkr_.header.frame_id = "/local_ENU";
   bds_mkr_.ns           = "boundaries";
   uint32_t lis          = visualization_msgs::Marker::LINE_STRIP;
@@ -416,6 +462,7 @@ void rrtPlotter::displayBoundaries(map_s map)
   bds_mkr_.header.stamp = ros::Time::now();
   bds_mkr_.id           =  0;
   bds_mkr_.scale.x      =  15.0; // line width
+  bds_mkr_.points.clear();
   for (long unsigned int i = 0; i < map.boundary_pts.size(); i++)
   {
     geometry_msgs::Point p;
@@ -433,11 +480,17 @@ void rrtPlotter::displayBoundaries(map_s map)
   p0.x = map.boundary_pts[1].E;
   p0.z = 0.0;
   bds_mkr_.points.push_back(p0);
-  marker_pub_.publish(bds_mkr_);
-  ground_pub_.publish(bds_mkr_);
-  sleep(0.05);
+  std::vector<visualization_msgs::Marker> layer(1, bds_mkr_);
+  putInScene(&scene_, layer);
+  putInScene(&ground_scene_, layer);
+  publishScene();
 }
 void rrtPlotter::displayPath(std::vector<NED_s> path, NED_s color, float width)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  publishPath(++path_version_, path, color, width);
+}
+void rrtPlotter::publishPath(unsigned int version, const std::vector<NED_s>& path, NED_s color, float width)
 {
   visualization_msgs::Marker aWPS_mkr, planned_path_mkr;
   // if (path_id_ == 1)
@@ -474,13 +527,6 @@ void rrtPlotter::displayPath(std::vector<NED_s> path, NED_s color, float width)
   aWPS_mkr.color.a             = 1.0;
   planned_path_mkr.lifetime = aWPS_mkr.lifetime = ros::Duration();
 
-  while (marker_pub_.getNumSubscribers() < 1)
-  {
-    if (!ros::ok())
-      return;
-    ROS_WARN_ONCE("Please create a subscriber to the marker");
-    sleep(1);
-  }
   // all waypoints
   if (false)
   {
@@ -497,58 +543,19 @@ void rrtPlotter::displayPath(std::vector<NED_s> path, NED_s color, float width)
       aWPS_mkr.points.push_back(p);
     }
     marker_pub_.publish(aWPS_mkr);
-    sleep(1.0);
   }
 
   // Plot desired path
   planned_path_mkr.header.stamp = ros::Time::now();
   // ROS_DEBUG("path_id_ %i", path_id_);
-  if (increase_path_id_)
+  tessellate(version, path, &planned_path_mkr.points);
+  if (tessellations_.front().id >= 0)   // a redraw replaces the marker it was drawn on
+    planned_path_mkr.id         = tessellations_.front().id;
+  else if (increase_path_id_)
     planned_path_mkr.id         = path_id_++;
   else
     planned_path_mkr.id         = path_id_;
-  std::vector<NED_s> vis_path;
-  vis_path.push_back(path[0]);
-  for (int i = 1; i < path.size() - 1; i++)
-  {
-    fillet_s fil;
-    fil.calculate(path[i - 1], path[i], path[i + 1], input_file_.turn_radius);
-    vis_path.push_back(fil.z1);
-
-    std::vector<std::vector<float> > NcEc;
-    if (fil.lambda == -1)
-    {
-      NcEc = arc(fil.c.N, fil.c.E, input_file_.turn_radius, (fil.z2 - fil.c).getChi(), (fil.z1 - fil.c).getChi());
-      // need to flip the vectors
-      std::reverse(NcEc[0].begin(),NcEc[0].end());
-      std::reverse(NcEc[1].begin(),NcEc[1].end());
-    }
-    if (fil.lambda ==  1)
-    {
-      NcEc = arc(fil.c.N, fil.c.E, input_file_.turn_radius, (fil.z1 - fil.c).getChi(), (fil.z2 - fil.c).getChi());
-    }
-    std::vector<float> Nc = NcEc[0];
-    std::vector<float> Ec = NcEc[1];
-    NED_s pos;
-    for (int j = 0; j < Nc.size(); j++)
-    {
-      pos.N = Nc[j];
-      pos.E = Ec[j];
-      pos.D = fil.c.D;
-      vis_path.push_back(pos);
-    }
-    vis_path.push_back(fil.z2);
-  }
-  vis_path.push_back(path[path.size() - 1]);
-
-  for (int i = 0; i < vis_path.size(); i++)
-  {
-    geometry_msgs::Point p;
-    p.x =  vis_path[i].E;
-    p.y =  vis_path[i].N;
-    p.z = -vis_path[i].D;
-    planned_path_mkr.points.push_back(p);
-  }
+  tessellations_.front().id     = planned_path_mkr.id;
   marker_pub_.publish(planned_path_mkr);
 
   if (display_on_judges_map_)
@@ -556,11 +563,10 @@ void rrtPlotter::displayPath(std::vector<NED_s> path, NED_s color, float width)
     ground_pub_.publish(planned_path_mkr);
     display_on_judges_map_ = false;
   }
-  sleep(0.05);
 }
 void rrtPlotter::drawCircle(NED_s cp, float r)
 {
-  std::vector<std::vector<float> > points = arc(cp.N, cp.E, r, 0.0f, 2.0f*M_PI + 0.1f);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   ROS_INFO("Displaying Circle");
   visualization_msgs::Marker pWPS_mkr, cir_mkr;
 
@@ -591,16 +597,6 @@ void rrtPlotter::drawCircle(NED_s cp, float r)
   cir_mkr.color.a             = 1.0;
   pWPS_mkr.lifetime = cir_mkr.lifetime  = ros::Duration();
 
-  ROS_INFO("checking for subscribers");
-  int id = 0;
-  while (marker_pub_.getNumSubscribers() < 1)
-  {
-    if (!ros::ok())
-      return;
-    ROS_WARN_ONCE("Please create a subscriber to the marker");
-    sleep(1);
-  }
-  ROS_INFO("found subscribers");
   // primary waypoints
   pWPS_mkr.header.stamp = ros::Time::now();
   pWPS_mkr.id           =  0;
@@ -611,60 +607,124 @@ void rrtPlotter::drawCircle(NED_s cp, float r)
   p.x =  cp.E;
   p.z = -cp.D;
   pWPS_mkr.points.push_back(p);
-  marker_pub_.publish(pWPS_mkr);
-  sleep(0.05);
 
   // Circle
   cir_mkr.header.stamp = ros::Time::now();
   cir_mkr.id           =  0;
   cir_mkr.scale.x      =  10.0; // line width
-  std::vector<float> Nc = points[0];
-  std::vector<float> Ec = points[1];
-  NED_s pos;
-  for (int j = 0; j < Nc.size(); j++)
-  {
-    geometry_msgs::Point p;
-    p.y = Nc[j];
-    p.x = Ec[j];
-    p.z = -cp.D;
-    cir_mkr.points.push_back(p);
-  }
-  marker_pub_.publish(cir_mkr);
-  ground_pub_.publish(cir_mkr);
-  sleep(0.05);
+  appendArc(&cir_mkr.points, cp, r, 0.0f, 2.0f*M_PI);
+  visualization_msgs::MarkerArray circle, ground_circle;
+  circle.markers.push_back(pWPS_mkr);
+  circle.markers.push_back(cir_mkr);
+  ground_circle.markers.push_back(cir_mkr);
+  array_pub_.publish(circle);
+  ground_array_pub_.publish(ground_circle);
   ROS_INFO("End of drawCircle");
 }
-std::vector<std::vector<float > > rrtPlotter::arc(float N, float E, float r, float aS, float aE)
+void rrtPlotter::tessellate(unsigned int version, const std::vector<NED_s>& path, std::vector<geometry_msgs::Point>* points)
 {
-  std::vector<float> Nc, Ec;
-  while (aE < aS)
-    aE += 2.0f*M_PI;
-  if (aE - aS == 0.0)
+  // A version is drawn once, redrawing it (redrawPath) is a copy of the points from then.
+  // The entry for it is the first one when this returns.
+  for (unsigned int k = 0; k < tessellations_.size(); k++)
+    if (tessellations_[k].version == version)
+    {
+      *points = tessellations_[k].points;
+      if (k > 0)
+      {
+        tessellations_.push_front(tessellations_[k]);
+        tessellations_.erase(tessellations_.begin() + k + 1);
+      }
+      return;
+    }
+  tessellation_s tessellation;
+  tessellation.version = version;
+  tessellation.id      = -1;
+  points->clear();
+  if (path.size() == 0)
   {
-    Ec.push_back(r*sin(aS)+ E);
-    Nc.push_back(r*cos(aS)+ N);
+    tessellations_.push_front(tessellation);
+    if (tessellations_.size() > 8)
+      tessellations_.pop_back();
+    return;
   }
-  for (float th = aS; th <= aE; th += M_PI/35.0)
+  geometry_msgs::Point p;
+  p.x =  path[0].E;
+  p.y =  path[0].N;
+  p.z = -path[0].D;
+  points->push_back(p);
+  for (unsigned int i = 1; i + 1 < path.size(); i++)
   {
-    Ec.push_back(r*sin(th)+ E);
-    Nc.push_back(r*cos(th)+ N);
+    fillet_s fil;
+    if (fil.calculate(path[i - 1], path[i], path[i + 1], input_file_.turn_radius) == false)
+    {
+      // No fillet fits this corner (legs too short or doubling back), draw the corner itself.
+      p.x =  path[i].E;
+      p.y =  path[i].N;
+      p.z = -path[i].D;
+      points->push_back(p);
+      continue;
+    }
+    float a_start = (fil.z1 - fil.c).getChi();
+    float sweep   = (fil.z2 - fil.c).getChi() - a_start;
+    if (fil.lambda == 1)
+      while (sweep < 0.0f)
+        sweep += 2.0f*M_PI;
+    else
+      while (sweep > 0.0f)
+        sweep -= 2.0f*M_PI;
+    appendArc(points, fil.c, input_file_.turn_radius, a_start, sweep);
+  }
+  p.x =  path.back().E;
+  p.y =  path.back().N;
+  p.z = -path.back().D;
+  points->push_back(p);
+
+  tessellation.points = *points;
+  tessellations_.push_front(tessellation);
+  if (tessellations_.size() > 8)
+    tessellations_.pop_back();
+}
+void rrtPlotter::appendArc(std::vector<geometry_msgs::Point>* points, NED_s c, float r, float a_start, float sweep)
+{
+  // As few segments as keep every chord within the tolerance of the arc, fewer for tight turns. A gap
+  // under half a pixel of the view doesn't show, so a view from far away takes fewer segments too.
+  float tolerance = arc_tolerance_ > 0.5f*view_scale_ ? arc_tolerance_ : 0.5f*view_scale_;
+  float step = r > tolerance ? 2.0f*acosf(1.0f - tolerance/r) : M_PI/2.0f;
+  int segments = ceilf(fabs(sweep)/step);
+  segments = segments < 1 ? 1 : segments;
+  points->reserve(points->size() + segments + 1);
+  geometry_msgs::Point p;
+  p.z = -c.D;
+  for (int k = 0; k <= segments; k++)
+  {
+    float th = a_start + sweep*k/segments;
+    p.x = c.E + r*sinf(th);
+    p.y = c.N + r*cosf(th);
+    points->push_back(p);
   }
-  std::vector<std::vector<float> > NcEc;
-  NcEc.push_back(Nc);
-  NcEc.push_back(Ec);
-  return NcEc;
 }
 void rrtPlotter::clearRViz(map_s map)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   visualization_msgs::Marker clear_mkr;
   clear_mkr.action = visualization_msgs::Marker::DELETEALL;
   marker_pub_.publish(clear_mkr);
   ground_pub_.publish(clear_mkr);
+  visualization_msgs::MarkerArray clear_array;
+  clear_array.markers.push_back(clear_mkr);
+  array_pub_.publish(clear_array);
+  ground_array_pub_.publish(clear_array);
+  num_mobs_ = 0;
+  tree_mkr_.points.clear();
+  tree_chunk_ = 0;
+  scene_.markers.clear();
+  ground_scene_.markers.clear();
   displayMap(map);
   path_id_ = 0;
 }
 void rrtPlotter::clearRViz(map_s map, std::vector<NED_s> path, NED_s color, float width)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   clearRViz(map);
   path_id_ = 1;
   if (path.size() > 0)
@@ -673,35 +733,44 @@ void rrtPlotter::clearRViz(map_s map, std::vector<NED_s> path, NED_s color, floa
 }
 void rrtPlotter::displayTree(node* root)
 {
-  fringe_.clear();
-  addFringe(root);
-  for (int j = 0; j < fringe_.size(); j++)
-  {
-    tree_path_.clear();
-    addTreePath(root, fringe_[j]);
-    tree_path_.push_back(root->p);
-    std::reverse(tree_path_.begin(), tree_path_.end());
-    displayPath(tree_path_, clr.gray, 2.5f);
-    sleep(0.005);
-  }
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  addTreeEdges(root);
+  publishTree(true);
 }
-void rrtPlotter::addFringe(node* nin)
+void rrtPlotter::addTreeEdges(node* nin)
 {
-  if (nin->children.size() == 0)
-    fringe_.push_back(nin);
-  else
+  for (unsigned int i = 0; i < nin->children.size(); i++)
   {
-    tree_path_.clear();
-    for (unsigned int i = 0; i < nin->children.size(); i++)
-      addFringe(nin->children[i]);
+    addTreeEdge(nin->p, nin->children[i]->p);
+    addTreeEdges(nin->children[i]);
   }
 }
-void rrtPlotter::addTreePath(node* root, node* nin)
+void rrtPlotter::addTreeEdge(NED_s from, NED_s to)
 {
-  if (nin->p != root->p)
-  {
-    tree_path_.push_back(nin->p);
-    addTreePath(root, nin->parent);
-  }
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  geometry_msgs::Point p;
+  p.x =  from.E;
+  p.y =  from.N;
+  p.z = -from.D;
+  tree_mkr_.points.push_back(p);
+  p.x =  to.E;
+  p.y =  to.N;
+  p.z = -to.D;
+  tree_mkr_.points.push_back(p);
+}
+void rrtPlotter::publishTree(bool now)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  // Only the edges since the last chunk are sent, so a frame costs the same however big the tree is.
+  if (tree_mkr_.points.size() == 0)
+    return;
+  ros::WallTime wall_now = ros::WallTime::now();
+  if (now == false && (wall_now - last_tree_chunk_).toSec() < tree_period_)
+    return;
+  tree_mkr_.header.stamp = ros::Time::now();
+  tree_mkr_.id           = tree_chunk_++;
+  marker_pub_.publish(tree_mkr_);
+  tree_mkr_.points.clear();
+  last_tree_chunk_       = wall_now;
 }
 } // end namespace theseus
@@ -0,0 +1,328 @@
+#include <theseus/visibility_graph.h>
+
+#include <queue>
+#include <algorithm>
+#include <functional>
+
+namespace theseus
+{
+VisibilityGraph::VisibilityGraph()
+{
+  clearance_ = 0.0f;
+  num_sides_ = 16;
+  built_     = false;
+}
+VisibilityGraph::~VisibilityGraph()
+{
+}
+void VisibilityGraph::setNumSides(unsigned int num_sides)
+{
+  num_sides_ = num_sides < 6 ? 6 : num_sides;
+}
+void VisibilityGraph::setMap(map_s map, float clearance)
+{
+  built_     = false;
+  clearance_ = clearance;
+  boundary_  = map.boundary_pts;
+  centers_.clear();
+  radii_.clear();
+  vertices_.clear();
+  vertex_cyl_.clear();
+  visible_.clear();
+  float margin = 1.0f;                          // keeps the tangent edges just outside of the clearance
+  for (unsigned int k = 0; k < map.cylinders.size(); k++)
+  {
+    centers_.push_back(NED_s(map.cylinders[k].N, map.cylinders[k].E, 0.0f));
+    radii_.push_back(map.cylinders[k].R + clearance_ + margin);
+  }
+}
+void VisibilityGraph::build(map_s map, float clearance)
+{
+  setMap(map, clearance);
+  if (boundary_.size() < 3)
+    return;
+  float margin = 1.0f;
+  // Circumscribed polygon around each inflated cylinder
+  for (unsigned int k = 0; k < centers_.size(); k++)
+  {
+    float rc = radii_[k]/cosf(M_PI/num_sides_);
+    for (unsigned int s = 0; s < num_sides_; s++)
+    {
+      float angle = 2.0f*M_PI*s/num_sides_;
+      NED_s v(centers_[k].N + rc*cosf(angle), centers_[k].E + rc*sinf(angle), 0.0f);
+      if (pointClear(v))
+      {
+        vertices_.push_back(v);
+        vertex_cyl_.push_back(k);
+      }
+    }
+  }
+  // Concave corners of the boundary, pushed inside far enough to clear both edges
+  float area = 0.0f;
+  unsigned int nb = boundary_.size();
+  for (unsigned int i = 0; i < nb; i++)
+    area += boundary_[i].N*boundary_[(i + 1) % nb].E - boundary_[(i + 1) % nb].N*boundary_[i].E;
+  for (unsigned int i = 0; i < nb; i++)
+  {
+    NED_s a = boundary_[(i + nb - 1) % nb];
+    NED_s v = boundary_[i];
+    NED_s b = boundary_[(i + 1) % nb];
+    float cross = (v.N - a.N)*(b.E - v.E) - (v.E - a.E)*(b.N - v.N);
+    if (cross*area >= 0.0f)
+      continue;                                 // convex, the shortest path never bends here
+    NED_s u1 = NED_s(a.N - v.N, a.E - v.E, 0.0f).normalize();
+    NED_s u2 = NED_s(b.N - v.N, b.E - v.E, 0.0f).normalize();
+    NED_s bisector = (u1 + u2).normalize();
+    float half_angle = acosf(std::max(-1.0f, std::min(1.0f, u1.dot(u2))))/2.0f;
+    half_angle = std::max(half_angle, (float) (5.0*M_PI/180.0));
+    NED_s p = v - bisector*((clearance_ + margin)/sinf(half_angle));
+    if (pointClear(p))
+    {
+      vertices_.push_back(p);
+      vertex_cyl_.push_back(-1);
+    }
+  }
+  visible_.resize(vertices_.size());
+  for (unsigned int i = 0; i < vertices_.size(); i++)
+    for (unsigned int j = i + 1; j < vertices_.size(); j++)
+      if (segmentClear(vertices_[i], vertices_[j]))
+      {
+        visible_[i].push_back(j);
+        visible_[j].push_back(i);
+      }
+  built_ = true;
+}
+bool VisibilityGraph::pack(std::vector<char>* blob)
+{
+  // num_sides, clearance, number of vertices, N[], E[], cylinder[], visible offsets[], visible[]
+  if (built_ == false)
+    return false;
+  uint32_t nv = vertices_.size();
+  std::vector<double> N(nv), E(nv);
+  std::vector<int32_t> cyl(nv);
+  std::vector<uint32_t> offsets(nv + 1, 0);
+  std::vector<uint32_t> visible;
+  for (uint32_t j = 0; j < nv; j++)
+  {
+    N[j]   = vertices_[j].N;
+    E[j]   = vertices_[j].E;
+    cyl[j] = vertex_cyl_[j];
+    visible.insert(visible.end(), visible_[j].begin(), visible_[j].end());
+    offsets[j + 1] = visible.size();
+  }
+  uint32_t num_sides = num_sides_;
+  appendBlob(blob, &num_sides, 1);
+  appendBlob(blob, &clearance_, 1);
+  appendBlob(blob, &nv, 1);
+  appendBlob(blob, N.empty() ? NULL : &N[0], nv);
+  appendBlob(blob, E.empty() ? NULL : &E[0], nv);
+  appendBlob(blob, cyl.empty() ? NULL : &cyl[0], nv);
+  appendBlob(blob, &offsets[0], nv + 1);
+  appendBlob(blob, visible.empty() ? NULL : &visible[0], visible.size());
+  return true;
+}
+bool VisibilityGraph::load(const char* data, size_t size, map_s map, float clearance)
+{
+  blob_reader_s reader(data, size);
+  uint32_t num_sides, nv;
+  float blob_clearance;
+  if (reader.read(&num_sides, 1) == false || reader.read(&blob_clearance, 1) == false || reader.read(&nv, 1) == false)
+    return false;
+  if (num_sides != num_sides_ || blob_clearance != clearance)
+    return false;
+  std::vector<double> N(nv), E(nv);
+  std::vector<int32_t> cyl(nv);
+  std::vector<uint32_t> offsets(nv + 1);
+  if (reader.read(N.empty() ? NULL : &N[0], nv) == false || reader.read(E.empty() ? NULL : &E[0], nv) == false ||
+      reader.read(cyl.empty() ? NULL : &cyl[0], nv) == false || reader.read(&offsets[0], nv + 1) == false)
+    return false;
+  std::vector<uint32_t> visible(offsets[nv]);
+  if (reader.read(visible.empty() ? NULL : &visible[0], visible.size()) == false)
+    return false;
+  setMap(map, clearance);
+  for (uint32_t j = 0; j < nv; j++)
+  {
+    if (cyl[j] >= (int32_t) centers_.size() || offsets[j] > offsets[j + 1] || offsets[j + 1] > visible.size())
+      return false;
+    vertices_.push_back(NED_s(N[j], E[j], 0.0f));
+    vertex_cyl_.push_back(cyl[j]);
+    visible_.push_back(std::vector<unsigned int>(visible.begin() + offsets[j], visible.begin() + offsets[j + 1]));
+  }
+  built_ = boundary_.size() >= 3;
+  return built_;
+}
+bool VisibilityGraph::query(NED_s ps, NED_s pe, std::vector<NED_s>* path)
+{
+  if (built_ == false)
+    return false;
+  NED_s ps2(ps.N, ps.E, 0.0f);
+  NED_s pe2(pe.N, pe.E, 0.0f);
+  if (segmentClear(ps2, pe2))
+    return false;                               // nothing to go around, the problem is in 3D
+  unsigned int nv    = vertices_.size();
+  unsigned int start = nv;
+  unsigned int goal  = nv + 1;
+  std::vector<unsigned int> from_start;
+  std::vector<bool> sees_goal(nv, false);
+  for (unsigned int j = 0; j < nv; j++)
+  {
+    if (segmentClear(ps2, vertices_[j]))
+      from_start.push_back(j);
+    sees_goal[j] = segmentClear(vertices_[j], pe2);
+  }
+
+  // A* with the straight line distance to the goal as the heuristic
+  std::vector<float> cost(nv + 2, INFINITY);
+  std::vector<int> parent(nv + 2, -1);
+  std::vector<bool> closed(nv + 2, false);
+  std::priority_queue<std::pair<float, unsigned int>, std::vector<std::pair<float, unsigned int> >, std::greater<std::pair<float, unsigned int> > > open;
+  cost[start] = 0.0f;
+  open.push(std::make_pair((pe2 - ps2).norm(), start));
+  while (open.empty() == false && closed[goal] == false)
+  {
+    unsigned int current = open.top().second;
+    open.pop();
+    if (closed[current])
+      continue;
+    closed[current] = true;
+    if (current == goal)
+      break;
+    NED_s pc = current == start ? ps2 : vertices_[current];
+    std::vector<unsigned int> next_nodes = current == start ? from_start : visible_[current];
+    if (current != start && sees_goal[current])
+      next_nodes.push_back(goal);
+    for (unsigned int j = 0; j < next_nodes.size(); j++)
+    {
+      unsigned int next = next_nodes[j];
+      NED_s pn = next == goal ? pe2 : vertices_[next];
+      float new_cost = cost[current] + (pn - pc).norm();
+      if (closed[next] || new_cost >= cost[next])
+        continue;
+      cost[next]   = new_cost;
+      parent[next] = current;
+      open.push(std::make_pair(new_cost + (pe2 - pn).norm(), next));
+    }
+  }
+  if (closed[goal] == false)
+    return false;
+  std::vector<unsigned int> node_path;
+  for (int j = parent[goal]; j >= 0 && (unsigned int) j != start; j = parent[j])
+    node_path.insert(node_path.begin(), j);
+
+  std::vector<NED_s> points;
+  mergeCorners(ps2, pe2, &node_path, &points);
+
+  // Constant slope from ps to pe
+  float total_length = 0.0f;
+  NED_s last = ps2;
+  for (unsigned int j = 0; j < points.size(); j++)
+  {
+    total_length += (points[j] - last).norm();
+    last = points[j];
+  }
+  total_length += (pe2 - last).norm();
+  float length = 0.0f;
+  last = ps2;
+  path->clear();
+  for (unsigned int j = 0; j < points.size(); j++)
+  {
+    length += (points[j] - last).norm();
+    last = points[j];
+    path->push_back(NED_s(points[j].N, points[j].E, ps.D + (pe.D - ps.D)*length/total_length));
+  }
+  return true;
+}
+void VisibilityGraph::mergeCorners(NED_s ps, NED_s pe, std::vector<unsigned int>* node_path, std::vector<NED_s>* points)
+{
+  // Going around a cylinder visits several polygon vertices that are too close together for a fillet.
+  // Where it is clear, the run is replaced by the one corner where the lines coming in and going out meet.
+  std::vector<unsigned int>& np = *node_path;
+  unsigned int j = 0;
+  while (j < np.size())
+  {
+    unsigned int k = j;
+    while (k + 1 < np.size() && vertex_cyl_[np[k + 1]] == vertex_cyl_[np[j]] && vertex_cyl_[np[j]] >= 0)
+      k++;
+    bool merged = false;
+    if (k > j)
+    {
+      NED_s prev = points->empty() ? ps : points->back();
+      NED_s next = k + 1 < np.size() ? vertices_[np[k + 1]] : pe;
+      NED_s r = vertices_[np[j]] - prev;
+      NED_s s = next - vertices_[np[k]];
+      float rxs = r.N*s.E - r.E*s.N;
+      if (fabs(rxs) > 1.0e-6f)
+      {
+        NED_s qp = vertices_[np[k]] - prev;
+        float t  = (qp.N*s.E - qp.E*s.N)/rxs;
+        NED_s corner = prev + r*t;
+        int cyl = vertex_cyl_[np[j]];
+        if (t > 1.0f && (corner - centers_[cyl]).norm() < 3.0f*radii_[cyl] && segmentClear(prev, corner) && segmentClear(corner, next))
+        {
+          points->push_back(corner);
+          merged = true;
+        }
+      }
+    }
+    if (merged == false)
+      for (unsigned int m = j; m <= k; m++)
+        points->push_back(vertices_[np[m]]);
+    j = k + 1;
+  }
+}
+bool VisibilityGraph::pointClear(NED_s p)
+{
+  unsigned int nb = boundary_.size();
+  int crossed_lines = 0;
+  for (unsigned int i = 0; i < nb; i++)
+  {
+    NED_s a = boundary_[i];
+    NED_s b = boundary_[(i + 1) % nb];
+    if ((a.E <= p.E) != (b.E <= p.E) && p.N > a.N + (p.E - a.E)*(b.N - a.N)/(b.E - a.E))
+      crossed_lines++;
+    if (pointToSegment(p, a, b) < clearance_)
+      return false;
+  }
+  if (crossed_lines % 2 == 0)
+    return false;
+  for (unsigned int k = 0; k < centers_.size(); k++)
+    if ((p - centers_[k]).norm() < radii_[k] - 0.01f)
+      return false;
+  return true;
+}
+bool VisibilityGraph::segmentClear(NED_s a, NED_s b)
+{
+  for (unsigned int k = 0; k < centers_.size(); k++)
+    if (pointToSegment(centers_[k], a, b) < radii_[k] - 0.01f)
+      return false;
+  unsigned int nb = boundary_.size();
+  for (unsigned int i = 0; i < nb; i++)
+  {
+    NED_s c = boundary_[i];
+    NED_s d = boundary_[(i + 1) % nb];
+    // If they don't cross, the closest two points include an end point of one of them.
+    if (segmentsCross(a, b, c, d) || pointToSegment(c, a, b) < clearance_ || pointToSegment(a, c, d) < clearance_ || pointToSegment(b, c, d) < clearance_)
+      return false;
+  }
+  return true;
+}
+float VisibilityGraph::pointToSegment(NED_s p, NED_s a, NED_s b)
+{
+  float dN = b.N - a.N;
+  float dE = b.E - a.E;
+  float l2 = dN*dN + dE*dE;
+  float t  = l2 > 0.0f ? ((p.N - a.N)*dN + (p.E - a.E)*dE)/l2 : 0.0f;
+  t = std::max(0.0f, std::min(1.0f, t));
+  float N = a.N + t*dN - p.N;
+  float E = a.E + t*dE - p.E;
+  return sqrtf(N*N + E*E);
+}
+bool VisibilityGraph::segmentsCross(NED_s a, NED_s b, NED_s c, NED_s d)
+{
+  float d1 = (d.N - c.N)*(a.E - c.E) - (d.E - c.E)*(a.N - c.N);
+  float d2 = (d.N - c.N)*(b.E - c.E) - (d.E - c.E)*(b.N - c.N);
+  float d3 = (b.N - a.N)*(c.E - a.E) - (b.E - a.E)*(c.N - a.N);
+  float d4 = (b.N - a.N)*(d.E - a.E) - (b.E - a.E)*(d.N - a.N);
+  return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+}
+} // end namespace theseus
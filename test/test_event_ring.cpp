@@ -0,0 +1,56 @@
+/*	DESCRIPTION:
+ *	Tests of the EventRing: the capacity is rounded up to a power of 2, the
+ *	newest events write over the oldest, and they are formatted with the
+ *	text of their event.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <theseus/event_ring.h>
+
+using namespace theseus;
+
+TEST(EventRing, KeepsTheNewest)
+{
+  EventRing ring(5);                          // 8 slots
+  for (int j = 0; j < 10; j++)
+    ring.record(EV_NODES, j, 100.0f*j, 5000.0f);
+  EXPECT_EQ(10u, ring.recorded());
+  std::vector<event_record_s> events = ring.last(20);
+  ASSERT_EQ(8u, events.size());
+  for (unsigned int j = 0; j < events.size(); j++)
+  {
+    EXPECT_EQ((uint32_t) EV_NODES, events[j].id);
+    EXPECT_FLOAT_EQ(j + 2.0f, events[j].args[0]);
+  }
+  events = ring.last(3);
+  ASSERT_EQ(3u, events.size());
+  EXPECT_FLOAT_EQ(7.0f, events[0].args[0]);
+  EXPECT_FLOAT_EQ(9.0f, events[2].args[0]);
+  EXPECT_LE(events[0].stamp_ns, events[2].stamp_ns);
+}
+TEST(EventRing, Formats)
+{
+  EventRing ring(16);
+  EXPECT_EQ(0u, ring.last(4).size());
+  ring.record(EV_SOLVE_DONE, 12);
+  std::string text = ring.format(1);
+  EXPECT_NE(std::string::npos, text.find("solved, 12 waypoints"));
+}
+TEST(EventRing, RecordsFromSeveralThreads)
+{
+  EventRing ring(1024);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.push_back(std::thread([&ring, t]()
+    {
+      for (int j = 0; j < 200; j++)
+        ring.record(EV_SMOOTH_STEP, t, j);
+    }));
+  for (unsigned int t = 0; t < threads.size(); t++)
+    threads[t].join();
+  EXPECT_EQ(800u, ring.recorded());
+  EXPECT_EQ(800u, ring.last(1024).size());
+}
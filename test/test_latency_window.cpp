@@ -0,0 +1,40 @@
+/*	DESCRIPTION:
+ *	Tests of the latency histograms and the LatencyWindow: the percentiles
+ *	are within a bucket of the truth, and a slice is dropped once the
+ *	window has moved past it.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <theseus/latency_window.h>
+
+using namespace theseus;
+
+TEST(LatencyHistogram, PercentilesWithinABucket)
+{
+  latency_histogram_s histogram;
+  for (int j = 1; j <= 100; j++)
+    histogram.add(j*1.0e-3, j > 95);
+  EXPECT_EQ(100u, histogram.count);
+  EXPECT_EQ(5u, histogram.failed);
+  EXPECT_DOUBLE_EQ(0.1, histogram.max);
+  EXPECT_NEAR(0.050, histogram.percentile(50.0), 0.050*0.125);
+  EXPECT_NEAR(0.090, histogram.percentile(90.0), 0.090*0.125);
+  EXPECT_DOUBLE_EQ(0.1, histogram.percentile(100.0));
+  EXPECT_DOUBLE_EQ(0.0, latency_histogram_s().percentile(50.0));
+}
+TEST(LatencyWindow, SlicesExpire)
+{
+  LatencyWindow window(10.0, 10);             // slices of 1 s
+  EXPECT_DOUBLE_EQ(10.0, window.length());
+  window.add(0.5, 1.0, false);
+  window.add(5.5, 2.0, true);
+  EXPECT_EQ(2u, window.window(9.9).count);
+  latency_histogram_s last = window.window(10.5); // the slice of 0.5 s is reused for 10.5 s
+  EXPECT_EQ(1u, last.count);
+  EXPECT_EQ(1u, last.failed);
+  EXPECT_DOUBLE_EQ(2.0, last.max);
+  EXPECT_EQ(0u, window.window(15.5).count);
+  window.add(100.0, 3.0, false);              // skips over many windows at once
+  EXPECT_EQ(1u, window.window(100.0).count);
+}
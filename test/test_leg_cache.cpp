@@ -0,0 +1,82 @@
+/*	DESCRIPTION:
+ *	Tests of the LegCache: a leg is found again only with the same key, the
+ *	least recently used one is dropped first and size 0 turns it off.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <theseus/leg_cache.h>
+
+using namespace theseus;
+
+static leg_s makeLeg(float goal_N)
+{
+  leg_s leg;
+  leg.key.start     = NED_s(0.0f, 0.0f, -50.0f);
+  leg.key.chi       = 0.5f;
+  leg.key.goal      = NED_s(goal_N, 100.0f, -50.0f);
+  leg.key.clearance = 30.0f;
+  leg.key.flags     = LEG_DIRECT_HIT;
+  leg.key.map_hash  = 1234;
+  leg.path.push_back(NED_s(goal_N/2.0f, 50.0f, -50.0f));
+  return leg;
+}
+
+TEST(LegCache, FindsTheSameKeyOnly)
+{
+  LegCache cache;
+  cache.setSize(4);
+  cache.add(makeLeg(100.0f));
+  leg_s found;
+  ASSERT_TRUE(cache.find(makeLeg(100.0f).key, &found));
+  ASSERT_EQ(1u, found.path.size());
+  EXPECT_FLOAT_EQ(50.0f, found.path[0].N);
+
+  leg_key_s key = makeLeg(100.0f).key;
+  key.map_hash++;
+  EXPECT_FALSE(cache.find(key, &found));
+  key = makeLeg(100.0f).key;
+  key.chi += 0.1f;
+  EXPECT_FALSE(cache.find(key, &found));
+  key = makeLeg(100.0f).key;
+  key.tuning.segment_length += 10.0f;
+  EXPECT_FALSE(cache.find(key, &found));
+  key = makeLeg(100.0f).key;
+  key.chi += 2.0f*M_PI;                       // the same heading
+  EXPECT_TRUE(cache.find(key, &found));
+}
+TEST(LegCache, DropsTheLeastRecentlyUsed)
+{
+  LegCache cache;
+  cache.setSize(2);
+  leg_s found;
+  cache.add(makeLeg(100.0f));
+  cache.add(makeLeg(200.0f));
+  EXPECT_TRUE(cache.find(makeLeg(100.0f).key, &found)); // 100 is the most recently used now
+  cache.add(makeLeg(300.0f));
+  EXPECT_TRUE(cache.find(makeLeg(100.0f).key, &found));
+  EXPECT_FALSE(cache.find(makeLeg(200.0f).key, &found));
+  EXPECT_TRUE(cache.find(makeLeg(300.0f).key, &found));
+}
+TEST(LegCache, SizeZeroIsOff)
+{
+  LegCache cache;
+  cache.setSize(0);
+  cache.add(makeLeg(100.0f));
+  leg_s found;
+  EXPECT_FALSE(cache.find(makeLeg(100.0f).key, &found));
+}
+TEST(LegCache, HashDependsOnTheObstaclesOnly)
+{
+  map_s map;
+  map.boundary_pts.push_back(NED_s(0.0f, 0.0f, 0.0f));
+  map.boundary_pts.push_back(NED_s(1000.0f, 0.0f, 0.0f));
+  map.boundary_pts.push_back(NED_s(1000.0f, 1000.0f, 0.0f));
+  cyl_s cyl = {500.0, 500.0, 50.0, 100.0};
+  map.cylinders.push_back(cyl);
+  unsigned long hash = LegCache::hashMap(map);
+  map.wps.push_back(NED_s(100.0f, 100.0f, -50.0f));
+  EXPECT_EQ(hash, LegCache::hashMap(map));
+  map.cylinders[0].R += 1.0;
+  EXPECT_NE(hash, LegCache::hashMap(map));
+}
@@ -0,0 +1,133 @@
+/*	DESCRIPTION:
+ *	Tests of the compiled maps: a MapArtifact gives back the sections it was
+ *	written with and is turned down for another map or clearance, and
+ *	Roadmap::load only takes a roadmap that was built the same way.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <theseus/map_artifact.h>
+#include <theseus/leg_cache.h>
+#include <theseus/roadmap.h>
+
+using namespace theseus;
+
+static map_s makeMap()
+{
+  map_s map;
+  map.boundary_pts.push_back(NED_s(0.0f, 0.0f, 0.0f));
+  map.boundary_pts.push_back(NED_s(1000.0f, 0.0f, 0.0f));
+  map.boundary_pts.push_back(NED_s(1000.0f, 1000.0f, 0.0f));
+  map.boundary_pts.push_back(NED_s(0.0f, 1000.0f, 0.0f));
+  cyl_s cyl1 = {300.0, 300.0, 80.0, 150.0};
+  cyl_s cyl2 = {700.0, 600.0, 60.0, 100.0};
+  map.cylinders.push_back(cyl1);
+  map.cylinders.push_back(cyl2);
+  return map;
+}
+static std::string directory()
+{
+  char name[64];
+  snprintf(name, sizeof(name), "/tmp/theseus_test_%d", (int) getpid());
+  mkdir(name, 0755);
+  return name;
+}
+
+TEST(MapArtifact, RoundTrip)
+{
+  map_s map = makeMap();
+  std::string file_name = MapArtifact::fileName(directory(), map, 30.0f);
+  std::vector<std::pair<uint32_t, std::vector<char> > > sections;
+  std::vector<char> tuning;
+  const char text[] = "tuning";
+  appendBlob(&tuning, text, sizeof(text));
+  sections.push_back(std::make_pair((uint32_t) MAP_SECTION_TUNING, tuning));
+  ASSERT_TRUE(MapArtifact::write(file_name, map, 30.0f, sections));
+
+  MapArtifact artifact;
+  ASSERT_TRUE(artifact.open(file_name, map, 30.0f));
+  EXPECT_TRUE(artifact.isOpen());
+  size_t size = 0;
+  const char* data = artifact.section(MAP_SECTION_TUNING, &size);
+  ASSERT_TRUE(data != NULL);
+  ASSERT_EQ(sizeof(text), size);
+  EXPECT_STREQ(text, data);
+  EXPECT_TRUE(artifact.section(MAP_SECTION_BOUNDARY, &size) != NULL);
+  EXPECT_EQ(4*3*sizeof(double), size);
+  EXPECT_TRUE(artifact.section(MAP_SECTION_ROADMAP, &size) == NULL);
+  artifact.close();
+  EXPECT_FALSE(artifact.isOpen());
+  remove(file_name.c_str());
+}
+TEST(MapArtifact, RejectsAnotherMapOrClearance)
+{
+  map_s map = makeMap();
+  std::string file_name = MapArtifact::fileName(directory(), map, 30.0f);
+  ASSERT_TRUE(MapArtifact::write(file_name, map, 30.0f, std::vector<std::pair<uint32_t, std::vector<char> > >()));
+  MapArtifact artifact;
+  EXPECT_FALSE(artifact.open(file_name, map, 25.0f));
+  map_s other = makeMap();
+  other.cylinders[1].R += 5.0;
+  EXPECT_FALSE(artifact.open(file_name, other, 30.0f));
+  EXPECT_FALSE(artifact.isOpen());
+  EXPECT_NE(file_name, MapArtifact::fileName(directory(), other, 30.0f));
+  EXPECT_NE(file_name, MapArtifact::fileName(directory(), map, 25.0f));
+  EXPECT_TRUE(artifact.open(file_name, map, 30.0f));
+  artifact.close();
+  remove(file_name.c_str());
+  EXPECT_FALSE(artifact.open(file_name, map, 30.0f));
+}
+
+class RoadmapLoad : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    map_      = makeMap();
+    map_hash_ = LegCache::hashMap(map_);
+    built_.setNumNodes(50);
+    built_.setConfig(planner_config_s());
+    built_.build(map_, map_hash_, 30.0f);
+    for (int j = 0; j < 1000 && built_.ready(map_hash_) == false; j++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(built_.ready(map_hash_));
+    ASSERT_TRUE(built_.pack(&blob_));
+  }
+  map_s map_;
+  unsigned long map_hash_;
+  Roadmap built_;
+  std::vector<char> blob_;
+};
+TEST_F(RoadmapLoad, TakesTheSameRoadmap)
+{
+  Roadmap loaded;
+  loaded.setNumNodes(50);
+  loaded.setConfig(planner_config_s());
+  EXPECT_FALSE(loaded.ready(map_hash_));
+  ASSERT_TRUE(loaded.load(&blob_[0], blob_.size(), map_, map_hash_, 30.0f));
+  EXPECT_TRUE(loaded.ready(map_hash_));
+  std::vector<char> again;
+  ASSERT_TRUE(loaded.pack(&again));
+  EXPECT_EQ(blob_, again);
+}
+TEST_F(RoadmapLoad, RejectsAnotherBuild)
+{
+  Roadmap loaded;
+  loaded.setConfig(planner_config_s());
+  loaded.setNumNodes(50);
+  EXPECT_FALSE(loaded.load(&blob_[0], blob_.size(), map_, map_hash_, 25.0f));
+  EXPECT_FALSE(loaded.load(&blob_[0], blob_.size()/2, map_, map_hash_, 30.0f));
+  EXPECT_FALSE(loaded.ready(map_hash_));
+  loaded.setNumNodes(60);
+  EXPECT_FALSE(loaded.load(&blob_[0], blob_.size(), map_, map_hash_, 30.0f));
+  loaded.setConnectionRadius(300.0f);
+  loaded.setNumNodes(50);
+  EXPECT_FALSE(loaded.load(&blob_[0], blob_.size(), map_, map_hash_, 30.0f));
+  EXPECT_FALSE(loaded.ready(map_hash_));
+}
@@ -0,0 +1,57 @@
+/*	DESCRIPTION:
+ *	Tests of the OdomTrail: points that are too close are dropped, and once
+ *	the history ring has wrapped around it still comes out oldest first
+ *	and joins up with the tail.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <theseus/odom_trail.h>
+
+using namespace theseus;
+
+static geometry_msgs::Point point(double x)
+{
+  geometry_msgs::Point p;
+  p.x = x;
+  p.y = 0.0;
+  p.z = 0.0;
+  return p;
+}
+
+TEST(OdomTrail, DropsPointsThatAreTooClose)
+{
+  OdomTrail trail;
+  trail.setup(visualization_msgs::Marker(), 10, 5.0f, 2.0f, 4);
+  EXPECT_EQ(TRAIL_TAIL, trail.add(point(0.0), 0.0));
+  EXPECT_EQ(TRAIL_NONE, trail.add(point(1.0), 1.0));  // too close and too soon
+  EXPECT_EQ(TRAIL_TAIL, trail.add(point(1.0), 3.0));  // too close but long enough after
+  EXPECT_EQ(TRAIL_NONE, trail.add(point(1.0), 9.0));  // the plane didn't move at all
+  EXPECT_EQ(TRAIL_TAIL, trail.add(point(7.0), 9.5));
+  EXPECT_EQ(3u, trail.tail().points.size());
+  EXPECT_EQ(0u, trail.history().points.size());
+}
+TEST(OdomTrail, HistoryWrapsAround)
+{
+  // A tail of 3 and a history of 3, every full tail moves all but its last point into the history.
+  OdomTrail trail;
+  trail.setup(visualization_msgs::Marker(), 6, 1.0f, 100.0f, 3);
+  trail_update_e update = TRAIL_NONE;
+  for (int j = 0; j <= 8; j++)
+    update = trail.add(point(10.0*j), j);
+  EXPECT_EQ(TRAIL_HISTORY, update);
+  visualization_msgs::Marker history = trail.history();
+  visualization_msgs::Marker tail     = trail.tail();
+  ASSERT_EQ(3u, history.points.size());
+  EXPECT_DOUBLE_EQ(50.0, history.points[0].x);
+  EXPECT_DOUBLE_EQ(60.0, history.points[1].x);
+  EXPECT_DOUBLE_EQ(70.0, history.points[2].x);
+  ASSERT_EQ(1u, tail.points.size());
+  EXPECT_DOUBLE_EQ(80.0, tail.points[0].x);
+  EXPECT_EQ(0, history.id);
+  EXPECT_EQ(1, tail.id);
+
+  trail.clear();
+  EXPECT_EQ(0u, trail.history().points.size());
+  EXPECT_EQ(0u, trail.tail().points.size());
+}
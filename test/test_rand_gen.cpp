@@ -0,0 +1,56 @@
+/*	DESCRIPTION:
+ *	Tests of the RandGen: a generator with its own stream doesn't touch
+ *	rand(), and rewinding it to a mark draws the same numbers again.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <theseus/rand_gen.h>
+
+using namespace theseus;
+
+TEST(RandGen, RewindRepeatsTheDraws)
+{
+  RandGen rg(22025, true);
+  ASSERT_TRUE(rg.ownStream());
+  rg.randLin();
+  rand_mark_s mark = rg.mark();
+  double lin            = rg.randLin();
+  unsigned int integer  = rg.UINT();
+  std::vector<unsigned int> integers = rg.UINTv(5);
+  double normal         = rg.norm_rnd(0.0, 1.0);
+  ASSERT_TRUE(rg.rewind(mark));
+  EXPECT_EQ(lin, rg.randLin());
+  EXPECT_EQ(integer, rg.UINT());
+  EXPECT_EQ(integers, rg.UINTv(5));
+  EXPECT_EQ(normal, rg.norm_rnd(0.0, 1.0));
+}
+TEST(RandGen, OwnStreamLeavesRandAlone)
+{
+  srand(7);
+  int expected = rand();
+  srand(7);
+  RandGen rg(22025, true);
+  rg.randLin();
+  rg.UINT();
+  rg.UINTv(3);
+  EXPECT_EQ(expected, rand());
+}
+TEST(RandGen, SameSeedSameSequence)
+{
+  RandGen a(5, true), b(5, true), c(6, true);
+  unsigned int first = a.UINT();
+  EXPECT_EQ(first, b.UINT());
+  EXPECT_NE(first, c.UINT());
+  EXPECT_EQ(a.randLin(), b.randLin());
+}
+TEST(RandGen, SharedStreamCantRewind)
+{
+  RandGen rg(22025);
+  EXPECT_FALSE(rg.ownStream());
+  rand_mark_s mark = rg.mark();
+  rg.randLin();
+  EXPECT_FALSE(rg.rewind(mark));
+}
@@ -0,0 +1,58 @@
+/*	DESCRIPTION:
+ *	Tests of the SeqLock: a reader gets back what was written, and never a
+ *	mix of two writes while the writer keeps going.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <theseus/seqlock.h>
+
+using namespace theseus;
+
+struct seqlock_test_s
+{
+  double a;
+  double b;
+  float  c;                                   // leaves a struct that isn't a multiple of 8 bytes
+  double d;
+};
+
+TEST(SeqLock, ReadsWhatWasWritten)
+{
+  SeqLock<seqlock_test_s> lock;
+  unsigned int version = lock.version();
+  seqlock_test_s value = {1.0, 2.0, 3.0f, 4.0};
+  lock.write(value);
+  EXPECT_EQ(version + 2, lock.version());
+  seqlock_test_s read = lock.read();
+  EXPECT_DOUBLE_EQ(1.0, read.a);
+  EXPECT_DOUBLE_EQ(2.0, read.b);
+  EXPECT_FLOAT_EQ(3.0f, read.c);
+  EXPECT_DOUBLE_EQ(4.0, read.d);
+}
+TEST(SeqLock, NeverTorn)
+{
+  SeqLock<seqlock_test_s> lock;
+  std::atomic<bool> done(false);
+  long torn = 0;
+  std::thread writer([&]()
+  {
+    for (int k = 1; k < 200000; k++)
+    {
+      seqlock_test_s value = {(double) k, (double) k, (float) k, (double) k};
+      lock.write(value);
+    }
+    done = true;
+  });
+  while (done == false)
+  {
+    seqlock_test_s value = lock.read();
+    if (value.a != value.b || value.b != value.d || (float) value.a != value.c)
+      torn++;
+  }
+  writer.join();
+  EXPECT_EQ(0, torn);
+}